@@ -191,40 +191,29 @@ public:
 template < int T > class GPCForest : public Algorithm
 {
 private:
-  struct Trail
-  {
-    unsigned leaf[T]; //!< Inside which leaf of the tree 0..T the patch fell?
-    Point2i coord;    //!< Patch coordinates.
-
-    bool operator==( const Trail &trail ) const { return memcmp( leaf, trail.leaf, sizeof( leaf ) ) == 0; }
-
-    bool operator<( const Trail &trail ) const
-    {
-      for ( int i = 0; i < T - 1; ++i )
-        if ( leaf[i] != trail.leaf[i] )
-          return leaf[i] < trail.leaf[i];
-      return leaf[T - 1] < trail.leaf[T - 1];
-    }
-  };
-
   class ParallelTrailsFilling : public ParallelLoopBody
   {
   private:
     const GPCForest *forest;
     const std::vector< GPCPatchDescriptor > *descr;
-    std::vector< Trail > *trails;
+    std::vector< unsigned > *trails;
 
     ParallelTrailsFilling &operator=( const ParallelTrailsFilling & );
 
   public:
-    ParallelTrailsFilling( const GPCForest *_forest, const std::vector< GPCPatchDescriptor > *_descr, std::vector< Trail > *_trails )
+    ParallelTrailsFilling( const GPCForest *_forest, const std::vector< GPCPatchDescriptor > *_descr, std::vector< unsigned > *_trails )
         : forest( _forest ), descr( _descr ), trails( _trails ){};
 
     void operator()( const Range &range ) const CV_OVERRIDE
     {
-      for ( int t = range.start; t < range.end; ++t )
-        for ( size_t i = 0; i < descr->size(); ++i )
-          trails->at( i ).leaf[t] = forest->tree[t].findLeafForPatch( descr->at( i ) );
+      // All the trees for one patch at a time, so the descriptor stays in cache
+      for ( int i = range.start; i < range.end; ++i )
+      {
+        const GPCPatchDescriptor &d = ( *descr )[i];
+        unsigned *leaf = &( *trails )[(size_t)i * T];
+        for ( int t = 0; t < T; ++t )
+          leaf[t] = forest->tree[t].findLeafForPatch( d );
+      }
     }
   };
 
@@ -289,7 +278,7 @@ public:
   /** @brief Find correspondences between two images.
    * @param[in] imgFrom First image in a sequence.
    * @param[in] imgTo Second image in a sequence.
-   * @param[out] corr Output vector with pairs of corresponding points.
+   * @param[out] corr Output vector with pairs of corresponding points, appended in the raster order of points in imgFrom.
    * @param[in] params Additional matching parameters for fine-tuning.
    */
   void findCorrespondences( InputArray imgFrom, InputArray imgTo, std::vector< std::pair< Point2i, Point2i > > &corr,
@@ -307,6 +296,13 @@ public:
                                          int type );
 
   static void getCoordinatesFromIndex( size_t index, Size sz, int &x, int &y );
+
+private:
+  //! Appends the patches whose trails (nTrees leaf indices per patch) are unique in both images, then drops the outliers.
+  static void findCorrespondences( const std::vector< unsigned > &trailsFrom, const std::vector< unsigned > &trailsTo, int nTrees,
+                                   Size fromSize, Size toSize, std::vector< std::pair< Point2i, Point2i > > &corr );
+
+  template < int T > friend class GPCForest;
 };
 
 template < int T >
@@ -328,36 +324,16 @@ void GPCForest< T >::findCorrespondences( InputArray imgFrom, InputArray imgTo,
 
   std::vector< GPCPatchDescriptor > descr;
   GPCDetails::getAllDescriptorsForImage( fromCh, descr, params, tree[0].getDescriptorType() );
-  std::vector< Trail > trailsFrom( descr.size() ), trailsTo( descr.size() );
-
-  for ( size_t i = 0; i < descr.size(); ++i )
-    GPCDetails::getCoordinatesFromIndex( i, from.size(), trailsFrom[i].coord.x, trailsFrom[i].coord.y );
-  parallel_for_( Range( 0, T ), ParallelTrailsFilling( this, &descr, &trailsFrom ) );
+  std::vector< unsigned > trailsFrom( descr.size() * T ), trailsTo;
+  parallel_for_( Range( 0, (int)descr.size() ), ParallelTrailsFilling( this, &descr, &trailsFrom ) );
 
   descr.clear();
   GPCDetails::getAllDescriptorsForImage( toCh, descr, params, tree[0].getDescriptorType() );
+  trailsTo.resize( descr.size() * T );
+  parallel_for_( Range( 0, (int)descr.size() ), ParallelTrailsFilling( this, &descr, &trailsTo ) );
+  descr.clear();
 
-  for ( size_t i = 0; i < descr.size(); ++i )
-    GPCDetails::getCoordinatesFromIndex( i, to.size(), trailsTo[i].coord.x, trailsTo[i].coord.y );
-  parallel_for_( Range( 0, T ), ParallelTrailsFilling( this, &descr, &trailsTo ) );
-
-  std::sort( trailsFrom.begin(), trailsFrom.end() );
-  std::sort( trailsTo.begin(), trailsTo.end() );
-
-  for ( size_t i = 0; i < trailsFrom.size(); ++i )
-  {
-    bool uniq = true;
-    while ( i + 1 < trailsFrom.size() && trailsFrom[i] == trailsFrom[i + 1] )
-      ++i, uniq = false;
-    if ( uniq )
-    {
-      typename std::vector< Trail >::const_iterator lb = std::lower_bound( trailsTo.begin(), trailsTo.end(), trailsFrom[i] );
-      if ( lb != trailsTo.end() && *lb == trailsFrom[i] && ( ( lb + 1 ) == trailsTo.end() || !( *lb == *( lb + 1 ) ) ) )
-        corr.push_back( std::make_pair( trailsFrom[i].coord, lb->coord ) );
-    }
-  }
-
-  GPCDetails::dropOutliers( corr );
+  GPCDetails::findCorrespondences( trailsFrom, trailsTo, T, from.size(), to.size(), corr );
 }
 
 //! @}
@@ -29,4 +29,32 @@ PERF_TEST_P(DenseOpticalFlow_DeepFlow, perf, Values(szVGA, sz720p))
     SANITY_CHECK_NOTHING();
 }
 
+typedef TestBaseWithParam<Size> DenseOpticalFlow_DeepFlow_Sequence;
+
+// Consecutive frames of a moving texture, processed by the same instance as in a video
+PERF_TEST_P(DenseOpticalFlow_DeepFlow_Sequence, perf, Values(szVGA))
+{
+    const int frameCount = 4;
+    Size sz = GetParam();
+
+    Mat texture(sz.height + 2 * frameCount, sz.width + 2 * frameCount, CV_8U);
+    randu(texture, 0, 255);
+    GaussianBlur(texture, texture, Size(5, 5), 1.5);
+
+    std::vector<Mat> frames;
+    for (int i = 0; i < frameCount; i++)
+        frames.push_back(texture(Rect(Point(2 * i, i), sz)).clone());
+
+    Mat flow;
+    Ptr<DenseOpticalFlow> algo = createOptFlow_DeepFlow();
+
+    TEST_CYCLE_N(1)
+    {
+        for (int i = 1; i < frameCount; i++)
+            algo->calc(frames[i - 1], frames[i], flow);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
 }} // namespace
@@ -0,0 +1,48 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+typedef TestBaseWithParam<int> SparseMatching_GPC;
+
+// a textured color frame and its translation by (3, 2)
+static void makeFramePair(Size sz, Mat& frame1, Mat& frame2, Mat& gt)
+{
+    Mat texture(sz.height + 4, sz.width + 4, CV_8UC3);
+    RNG rng(0);
+    rng.fill(texture, RNG::UNIFORM, 0, 255);
+    GaussianBlur(texture, texture, Size(5, 5), 1.5);
+    frame1 = texture(Rect(Point(3, 2), sz)).clone();
+    frame2 = texture(Rect(Point(0, 0), sz)).clone();
+    gt.create(sz, CV_32FC2);
+    gt.setTo(Scalar(3, 2));
+}
+
+PERF_TEST_P(SparseMatching_GPC, findCorrespondences, Values((int)GPC_DESCRIPTOR_DCT, (int)GPC_DESCRIPTOR_WHT))
+{
+    const int descriptorType = GetParam();
+
+    Mat trainFrom, trainTo, trainGt;
+    makeFramePair(Size(320, 240), trainFrom, trainTo, trainGt);
+    std::vector<Mat> img1(1, trainFrom), img2(1, trainTo), gt(1, trainGt);
+
+    Ptr< GPCForest<5> > forest = GPCForest<5>::create();
+    forest->train(img1, img2, gt, GPCTrainingParams(8, 3, (GPCDescType)descriptorType, false));
+
+    // Sintel frame size
+    Mat frame1, frame2, flow;
+    makeFramePair(Size(1024, 436), frame1, frame2, flow);
+    std::vector< std::pair<Point2i, Point2i> > corr;
+
+    TEST_CYCLE()
+    {
+        corr.clear();
+        forest->findCorrespondences(frame1, frame2, corr);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
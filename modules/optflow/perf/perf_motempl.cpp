@@ -0,0 +1,85 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+typedef TestBaseWithParam<Size> MotionTemplates;
+
+static const double kDuration = 1.0;
+
+// silhouette of a few blobs moving right by 4 pixels per frame
+static void makeSilhouette(Size sz, int frame, Mat& silh)
+{
+    silh.create(sz, CV_8UC1);
+    silh.setTo(Scalar::all(0));
+    RNG rng(0);
+    for (int i = 0; i < 16; i++)
+    {
+        Point c(rng.uniform(0, sz.width) + 4 * frame, rng.uniform(0, sz.height));
+        circle(silh, c, rng.uniform(10, std::max(11, sz.height / 8)), Scalar::all(255), FILLED);
+    }
+}
+
+// motion history of 10 frames taken 0.1 apart
+static void makeMotionHistory(Size sz, Mat& mhi, Mat& silh, double& timestamp)
+{
+    mhi = Mat::zeros(sz, CV_32FC1);
+    timestamp = 0;
+    for (int frame = 0; frame < 10; frame++)
+    {
+        timestamp = 0.1 * (frame + 1);
+        makeSilhouette(sz, frame, silh);
+        cv::motempl::updateMotionHistory(silh, mhi, timestamp, kDuration);
+    }
+}
+
+PERF_TEST_P(MotionTemplates, updateMotionHistory, Values(szVGA, sz720p, sz1080p))
+{
+    Size sz = GetParam();
+    Mat mhi, silh;
+    double timestamp;
+    makeMotionHistory(sz, mhi, silh, timestamp);
+
+    TEST_CYCLE()
+    {
+        cv::motempl::updateMotionHistory(silh, mhi, timestamp, kDuration);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+PERF_TEST_P(MotionTemplates, calcMotionGradient, Values(szVGA, sz720p, sz1080p))
+{
+    Size sz = GetParam();
+    Mat mhi, silh, mask, orient;
+    double timestamp;
+    makeMotionHistory(sz, mhi, silh, timestamp);
+
+    TEST_CYCLE()
+    {
+        cv::motempl::calcMotionGradient(mhi, mask, orient, 0.05, 0.5, 3);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+PERF_TEST_P(MotionTemplates, segmentMotion, Values(szVGA, sz720p, sz1080p))
+{
+    Size sz = GetParam();
+    Mat mhi, silh, segmask;
+    double timestamp;
+    makeMotionHistory(sz, mhi, silh, timestamp);
+    std::vector<Rect> rects;
+
+    TEST_CYCLE()
+    {
+        rects.clear();
+        cv::motempl::segmentMotion(mhi, segmask, rects, timestamp, 0.2);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
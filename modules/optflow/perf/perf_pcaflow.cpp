@@ -0,0 +1,32 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+typedef TestBaseWithParam<Size> DenseOpticalFlow_PCAFlow;
+
+PERF_TEST_P(DenseOpticalFlow_PCAFlow, perf, Values(szVGA, sz720p))
+{
+    Size sz = GetParam();
+
+    // a textured frame and its translation, so that there are features to match
+    Mat texture(sz.height + 4, sz.width + 4, CV_8U);
+    randu(texture, 0, 255);
+    GaussianBlur(texture, texture, Size(5, 5), 1.5);
+    Mat frame1 = texture(Rect(Point(0, 0), sz)).clone();
+    Mat frame2 = texture(Rect(Point(3, 2), sz)).clone();
+    Mat flow;
+
+    Ptr<DenseOpticalFlow> algo = createOptFlow_PCAFlow();
+
+    TEST_CYCLE()
+    {
+        algo->calc(frame1, frame2, flow);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
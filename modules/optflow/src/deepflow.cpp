@@ -71,7 +71,12 @@ protected:
 
 private:
     std::vector<Mat> buildPyramid( const Mat& src );
+    std::vector<Mat> buildSmoothedPyramid( const Mat& src );
 
+    // Video mode: when I0 is the I1 of the previous call, its pyramid is reused
+    Mat prevI1;
+    std::vector<Mat> prevPyramid_I1;
+    Ptr<VariationalRefinement> var;
 };
 
 OpticalFlowDeepFlow::OpticalFlowDeepFlow()
@@ -113,6 +118,19 @@ std::vector<Mat> OpticalFlowDeepFlow::buildPyramid( const Mat& src )
     return pyramid;
 }
 
+std::vector<Mat> OpticalFlowDeepFlow::buildSmoothedPyramid( const Mat& src )
+{
+    Mat I;
+    src.convertTo(I, CV_32F);
+
+    // pre-smooth image
+    int kernelLen = ((int)floor(3 * sigma) * 2) + 1;
+    Size kernelSize(kernelLen, kernelLen);
+    GaussianBlur(I, I, kernelSize, sigma);
+    // build down-sized pyramid
+    return buildPyramid(I);
+}
+
 void OpticalFlowDeepFlow::calc( InputArray _I0, InputArray _I1, InputOutputArray _flow )
 {
     Mat I0temp = _I0.getMat();
@@ -123,39 +141,46 @@ void OpticalFlowDeepFlow::calc( InputArray _I0, InputArray _I1, InputOutputArray
     CV_Assert(I0temp.channels() == 1);
     // TODO: currently only grayscale - data term could be computed in color version as well...
 
-    Mat I0, I1;
+    _flow.create(I0temp.size(), CV_32FC2);
+    Mat W = _flow.getMat(); // if any data present - will be discarded
 
-    I0temp.convertTo(I0, CV_32F);
-    I1temp.convertTo(I1, CV_32F);
+    // when processing a video, the first image is the second one of the previous call and its
+    // pyramid is reused, otherwise both pyramids are built concurrently
+    std::vector<Mat> pyramids[2];
+    bool reuse = !prevPyramid_I1.empty() && prevI1.size() == I0temp.size() && prevI1.type() == I0temp.type()
+            && norm(I0temp, prevI1, NORM_INF) == 0;
+    if ( reuse )
+        pyramids[0] = prevPyramid_I1;
 
-    _flow.create(I0.size(), CV_32FC2);
-    Mat W = _flow.getMat(); // if any data present - will be discarded
+    const Mat* src[2] = { &I0temp, &I1temp };
+    parallel_for_(Range(reuse ? 1 : 0, 2), [&](const Range& range)
+    {
+        for ( int i = range.start; i < range.end; ++i )
+            pyramids[i] = buildSmoothedPyramid(*src[i]);
+    });
 
-    // pre-smooth images
-    int kernelLen = ((int)floor(3 * sigma) * 2) + 1;
-    Size kernelSize(kernelLen, kernelLen);
-    GaussianBlur(I0, I0, kernelSize, sigma);
-    GaussianBlur(I1, I1, kernelSize, sigma);
-    // build down-sized pyramids
-    std::vector<Mat> pyramid_I0 = buildPyramid(I0);
-    std::vector<Mat> pyramid_I1 = buildPyramid(I1);
+    std::vector<Mat>& pyramid_I0 = pyramids[0];
+    std::vector<Mat>& pyramid_I1 = pyramids[1];
     int levelCount = (int) pyramid_I0.size();
 
+    I1temp.copyTo(prevI1);
+    prevPyramid_I1 = pyramid_I1;
+
     // initialize the first version of flow estimate to zeros
     Size smallestSize = pyramid_I0[levelCount - 1].size();
     W = Mat::zeros(smallestSize, CV_32FC2);
 
+    if ( !var )
+        var = VariationalRefinement::create();
+    var->setAlpha(4 * alpha);
+    var->setDelta(delta / 3);
+    var->setGamma(gamma / 3);
+    var->setFixedPointIterations(fixedPointIterations);
+    var->setSorIterations(sorIterations);
+    var->setOmega(omega);
+
     for ( int level = levelCount - 1; level >= 0; --level )
     { //iterate through  all levels, beginning with the most coarse
-        Ptr<VariationalRefinement> var = VariationalRefinement::create();
-
-        var->setAlpha(4 * alpha);
-        var->setDelta(delta / 3);
-        var->setGamma(gamma / 3);
-        var->setFixedPointIterations(fixedPointIterations);
-        var->setSorIterations(sorIterations);
-        var->setOmega(omega);
-
         var->calc(pyramid_I0[level], pyramid_I1[level], W);
         if ( level > 0 ) //not the last level
         {
@@ -168,7 +193,13 @@ void OpticalFlowDeepFlow::calc( InputArray _I0, InputArray _I1, InputOutputArray
     W.copyTo(_flow);
 }
 
-void OpticalFlowDeepFlow::collectGarbage() {}
+void OpticalFlowDeepFlow::collectGarbage()
+{
+    prevI1.release();
+    prevPyramid_I1.clear();
+    if ( var )
+        var->collectGarbage();
+}
 
 Ptr<DenseOpticalFlow> createOptFlow_DeepFlow() { return makePtr<OpticalFlowDeepFlow>(); }
 
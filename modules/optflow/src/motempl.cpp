@@ -43,6 +43,7 @@
 #include "opencv2/core/utility.hpp"
 #include "opencv2/core/hal/hal.hpp"
 #include "opencv2/core/private.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 #include "opencl_kernels_optflow.hpp"
 
 namespace  cv {
@@ -70,6 +71,27 @@ static bool ocl_updateMotionHistory( InputArray _silhouette, InputOutputArray _m
 
 #endif
 
+#if CV_SIMD128
+static inline void updateMotionHistory4( float* mhi, const v_int32x4& silhMask, const v_float32x4& ts4, const v_float32x4& db4 )
+{
+    v_float32x4 v = v_load(mhi);
+    v = v_select(v_ge(v, db4), v, v_setzero_f32());
+    v_store(mhi, v_select(v_reinterpret_as_f32(silhMask), ts4, v));
+}
+
+// Zeroes the orientation of the pixels which are masked off, returns 1 for the kept pixels and 0 otherwise
+static inline v_int32x4 calcMotionGradientMask4( const float* dX, const float* dY, const float* mhiMin, const float* mhiMax,
+                                                 float* orient, const v_float32x4& eps4, const v_float32x4& min4,
+                                                 const v_float32x4& max4 )
+{
+    v_float32x4 d0 = v_sub(v_load(mhiMax), v_load(mhiMin));
+    v_float32x4 off = v_and(v_lt(v_abs(v_load(dX)), eps4), v_lt(v_abs(v_load(dY)), eps4));
+    off = v_or(off, v_or(v_lt(d0, min4), v_lt(max4, d0)));
+    v_store(orient, v_select(off, v_setzero_f32(), v_load(orient)));
+    return v_add(v_reinterpret_as_s32(off), v_setall_s32(1));
+}
+#endif
+
 void updateMotionHistory( InputArray _silhouette, InputOutputArray _mhi,
                               double timestamp, double duration )
 {
@@ -83,72 +105,60 @@ void updateMotionHistory( InputArray _silhouette, InputOutputArray _mhi,
                ocl_updateMotionHistory(_silhouette, _mhi, ts, delbound))
 
     Mat silh = _silhouette.getMat(), mhi = _mhi.getMat();
-    Size size = silh.size();
+
 #if defined(HAVE_IPP)
+    Size size = silh.size();
     int silhstep = (int)silh.step, mhistep = (int)mhi.step;
-#endif
 
     if( silh.isContinuous() && mhi.isContinuous() )
     {
         size.width *= size.height;
         size.height = 1;
-#if defined(HAVE_IPP)
         silhstep = (int)silh.total();
         mhistep = (int)mhi.total() * sizeof(Ipp32f);
-#endif
     }
 
-#if defined(HAVE_IPP)
     IppStatus status = ippiUpdateMotionHistory_8u32f_C1IR((const Ipp8u *)silh.data, silhstep, (Ipp32f *)mhi.data, mhistep,
                                                           ippiSize(size.width, size.height), (Ipp32f)timestamp, (Ipp32f)duration);
     if (status >= 0)
         return;
 #endif
 
-#if CV_SSE2
-    volatile bool useSIMD = checkHardwareSupport(CV_CPU_SSE2);
-#endif
-
-    for(int y = 0; y < size.height; y++ )
+    parallel_for_(Range(0, silh.rows), [&](const Range& range)
     {
-        const uchar* silhData = silh.ptr<uchar>(y);
-        float* mhiData = mhi.ptr<float>(y);
-        int x = 0;
-
-#if CV_SSE2
-        if( useSIMD )
+        for( int y = range.start; y < range.end; y++ )
         {
-            __m128 ts4 = _mm_set1_ps(ts), db4 = _mm_set1_ps(delbound);
-            for( ; x <= size.width - 8; x += 8 )
-            {
-                __m128i z = _mm_setzero_si128();
-                __m128i s = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(silhData + x)), z);
-                __m128 s0 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(s, z)), s1 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(s, z));
-                __m128 v0 = _mm_loadu_ps(mhiData + x), v1 = _mm_loadu_ps(mhiData + x + 4);
-                __m128 fz = _mm_setzero_ps();
-
-                v0 = _mm_and_ps(v0, _mm_cmpge_ps(v0, db4));
-                v1 = _mm_and_ps(v1, _mm_cmpge_ps(v1, db4));
-
-                __m128 m0 = _mm_and_ps(_mm_xor_ps(v0, ts4), _mm_cmpneq_ps(s0, fz));
-                __m128 m1 = _mm_and_ps(_mm_xor_ps(v1, ts4), _mm_cmpneq_ps(s1, fz));
+            const uchar* silhData = silh.ptr<uchar>(y);
+            float* mhiData = mhi.ptr<float>(y);
+            int x = 0;
 
-                v0 = _mm_xor_ps(v0, m0);
-                v1 = _mm_xor_ps(v1, m1);
-
-                _mm_storeu_ps(mhiData + x, v0);
-                _mm_storeu_ps(mhiData + x + 4, v1);
+#if CV_SIMD128
+            v_float32x4 ts4 = v_setall_f32(ts), db4 = v_setall_f32(delbound);
+            for( ; x <= silh.cols - 16; x += 16 )
+            {
+                // 0xff bytes for silhouette pixels, sign-extended into 32-bit lane masks
+                v_int8x16 s = v_reinterpret_as_s8(v_ne(v_load(silhData + x), v_setzero_u8()));
+                v_int16x8 s0, s1;
+                v_int32x4 m0, m1, m2, m3;
+                v_expand(s, s0, s1);
+                v_expand(s0, m0, m1);
+                v_expand(s1, m2, m3);
+
+                updateMotionHistory4(mhiData + x, m0, ts4, db4);
+                updateMotionHistory4(mhiData + x + 4, m1, ts4, db4);
+                updateMotionHistory4(mhiData + x + 8, m2, ts4, db4);
+                updateMotionHistory4(mhiData + x + 12, m3, ts4, db4);
             }
-        }
 #endif
 
-        for( ; x < size.width; x++ )
-        {
-            float val = mhiData[x];
-            val = silhData[x] ? ts : val < delbound ? 0 : val;
-            mhiData[x] = val;
+            for( ; x < silh.cols; x++ )
+            {
+                float val = mhiData[x];
+                val = silhData[x] ? ts : val < delbound ? 0 : val;
+                mhiData[x] = val;
+            }
         }
-    }
+    }, silh.total() / (double)(1 << 16));
 }
 
 
@@ -190,68 +200,59 @@ void calcMotionGradient( InputArray _mhi, OutputArray _mask,
     float min_delta = (float)delta1;
     float max_delta = (float)delta2;
 
-    Mat dX_min, dY_max;
+    Mat dX, dY, mhiMin, mhiMax;
 
     // calc Dx and Dy
-    Sobel( mhi, dX_min, CV_32F, 1, 0, aperture_size, 1, 0, BORDER_REPLICATE );
-    Sobel( mhi, dY_max, CV_32F, 0, 1, aperture_size, 1, 0, BORDER_REPLICATE );
+    Sobel( mhi, dX, CV_32F, 1, 0, aperture_size, 1, 0, BORDER_REPLICATE );
+    Sobel( mhi, dY, CV_32F, 0, 1, aperture_size, 1, 0, BORDER_REPLICATE );
 
-    int x, y;
+    erode( mhi, mhiMin, noArray(), Point(-1,-1), (aperture_size-1)/2, BORDER_REPLICATE );
+    dilate( mhi, mhiMax, noArray(), Point(-1,-1), (aperture_size-1)/2, BORDER_REPLICATE );
 
-    if( mhi.isContinuous() && orient.isContinuous() && mask.isContinuous() )
+    // calc gradient orientation, then mask off pixels where the gradient is very small
+    // or which have little motion difference in their neighborhood
+    parallel_for_(Range(0, size.height), [&](const Range& range)
     {
-        size.width *= size.height;
-        size.height = 1;
-    }
-
-    // calc gradient
-    for( y = 0; y < size.height; y++ )
-    {
-        const float* dX_min_row = dX_min.ptr<float>(y);
-        const float* dY_max_row = dY_max.ptr<float>(y);
-        float* orient_row = orient.ptr<float>(y);
-        uchar* mask_row = mask.ptr<uchar>(y);
-
-        cv::hal::fastAtan2(dY_max_row, dX_min_row, orient_row, size.width, true);
-
-        // make orientation zero where the gradient is very small
-        for( x = 0; x < size.width; x++ )
+        for( int y = range.start; y < range.end; y++ )
         {
-            float dY = dY_max_row[x];
-            float dX = dX_min_row[x];
-
-            if( std::abs(dX) < gradient_epsilon && std::abs(dY) < gradient_epsilon )
+            const float* dX_row = dX.ptr<float>(y);
+            const float* dY_row = dY.ptr<float>(y);
+            const float* min_row = mhiMin.ptr<float>(y);
+            const float* max_row = mhiMax.ptr<float>(y);
+            float* orient_row = orient.ptr<float>(y);
+            uchar* mask_row = mask.ptr<uchar>(y);
+            int x = 0;
+
+            cv::hal::fastAtan2(dY_row, dX_row, orient_row, size.width, true);
+
+#if CV_SIMD128
+            v_float32x4 eps4 = v_setall_f32(gradient_epsilon);
+            v_float32x4 min4 = v_setall_f32(min_delta), max4 = v_setall_f32(max_delta);
+            for( ; x <= size.width - 16; x += 16 )
             {
-                mask_row[x] = (uchar)0;
-                orient_row[x] = 0.f;
+                v_int32x4 m[4];
+                for( int k = 0; k < 4; k++ )
+                    m[k] = calcMotionGradientMask4(dX_row + x + k*4, dY_row + x + k*4, min_row + x + k*4, max_row + x + k*4,
+                                                   orient_row + x + k*4, eps4, min4, max4);
+                v_store(mask_row + x, v_pack_u(v_pack(m[0], m[1]), v_pack(m[2], m[3])));
             }
-            else
-                mask_row[x] = (uchar)1;
-        }
-    }
-
-    erode( mhi, dX_min, noArray(), Point(-1,-1), (aperture_size-1)/2, BORDER_REPLICATE );
-    dilate( mhi, dY_max, noArray(), Point(-1,-1), (aperture_size-1)/2, BORDER_REPLICATE );
-
-    // mask off pixels which have little motion difference in their neighborhood
-    for( y = 0; y < size.height; y++ )
-    {
-        const float* dX_min_row = dX_min.ptr<float>(y);
-        const float* dY_max_row = dY_max.ptr<float>(y);
-        float* orient_row = orient.ptr<float>(y);
-        uchar* mask_row = mask.ptr<uchar>(y);
-
-        for( x = 0; x < size.width; x++ )
-        {
-            float d0 = dY_max_row[x] - dX_min_row[x];
+#endif
 
-            if( mask_row[x] == 0 || d0 < min_delta || max_delta < d0 )
+            for( ; x < size.width; x++ )
             {
-                mask_row[x] = (uchar)0;
-                orient_row[x] = 0.f;
+                float d0 = max_row[x] - min_row[x];
+
+                if( (std::abs(dX_row[x]) < gradient_epsilon && std::abs(dY_row[x]) < gradient_epsilon) ||
+                    d0 < min_delta || max_delta < d0 )
+                {
+                    mask_row[x] = (uchar)0;
+                    orient_row[x] = 0.f;
+                }
+                else
+                    mask_row[x] = (uchar)1;
             }
         }
-    }
+    }, mhi.total() / (double)(1 << 16));
 }
 
 double calcGlobalOrientation( InputArray _orientation, InputArray _mask,
@@ -346,6 +347,27 @@ double calcGlobalOrientation( InputArray _orientation, InputArray _mask,
 }
 
 
+static inline int findRoot( int* parent, int i )
+{
+    while( parent[i] != i )
+    {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+// Links the larger root to the smaller one, so that every root is the first pixel of its tree in raster order
+static inline void unionPixels( int* parent, int i, int j )
+{
+    i = findRoot(parent, i);
+    j = findRoot(parent, j);
+    if( i < j )
+        parent[j] = i;
+    else if( j < i )
+        parent[i] = j;
+}
+
 void segmentMotion(InputArray _mhi, OutputArray _segmask,
                    vector<Rect>& boundingRects,
                    double timestamp, double segThresh)
@@ -354,64 +376,118 @@ void segmentMotion(InputArray _mhi, OutputArray _segmask,
 
     _segmask.create(mhi.size(), CV_32F);
     Mat segmask = _segmask.getMat();
-    segmask = Scalar::all(0);
 
     CV_Assert( mhi.type() == CV_32F );
     CV_Assert( segThresh >= 0 );
 
-    Mat mask = Mat::zeros( mhi.rows + 2, mhi.cols + 2, CV_8UC1 );
+    // A segment is a 4-connected component of non-zero MHI pixels whose neighbors differ by at most segThresh
+    // (what a floating range floodFill collects), which contains a pixel of the last silhouette.
+    // The components are found with union-find, first in horizontal bands in parallel, then across the bands.
+    const int rows = mhi.rows, cols = mhi.cols;
+    const float ts = (float)timestamp, thresh = (float)segThresh;
+    vector<int> parent((size_t)rows * cols);
+    int* parentData = parent.data();
 
-    int x, y;
+    const int nbands = std::max(1, std::min(rows, getNumThreads() * 4));
+    parallel_for_(Range(0, nbands), [&](const Range& range)
+    {
+        for( int band = range.start; band < range.end; band++ )
+        {
+            const int y0 = band * rows / nbands, y1 = (band + 1) * rows / nbands;
+            for( int y = y0; y < y1; y++ )
+            {
+                const float* mhiptr = mhi.ptr<float>(y);
+                const float* prevptr = y > y0 ? mhi.ptr<float>(y - 1) : 0;
+                const int idx = y * cols;
 
-    // protect zero mhi pixels from floodfill.
-    for( y = 0; y < mhi.rows; y++ )
+                for( int x = 0; x < cols; x++ )
+                {
+                    parentData[idx + x] = idx + x;
+                    float v = mhiptr[x];
+                    if( v == 0 )
+                        continue;
+                    if( x > 0 && mhiptr[x-1] != 0 && std::abs(v - mhiptr[x-1]) <= thresh )
+                        unionPixels(parentData, idx + x, idx + x - 1);
+                    if( prevptr && prevptr[x] != 0 && std::abs(v - prevptr[x]) <= thresh )
+                        unionPixels(parentData, idx + x, idx + x - cols);
+                }
+            }
+        }
+    });
+
+    for( int band = 1; band < nbands; band++ )
     {
+        const int y = band * rows / nbands;
         const float* mhiptr = mhi.ptr<float>(y);
-        uchar* maskptr = mask.ptr<uchar>(y+1) + 1;
+        const float* prevptr = mhi.ptr<float>(y - 1);
 
-        for( x = 0; x < mhi.cols; x++ )
-        {
-            if( mhiptr[x] == 0 )
-                maskptr[x] = 1;
-        }
+        for( int x = 0; x < cols; x++ )
+            if( mhiptr[x] != 0 && prevptr[x] != 0 && std::abs(mhiptr[x] - prevptr[x]) <= thresh )
+                unionPixels(parentData, y * cols + x, (y - 1) * cols + x);
     }
 
-    float ts = (float)timestamp;
-    float comp_idx = 1.f;
+    // Number the segments in the order floodFill would find them: by the first silhouette pixel in raster order
+    vector<int> label((size_t)rows * cols), segIdx;
+    vector<Vec4i> compBoxes; // xmin, ymin, xmax, ymax
+    vector<int> segComps;
 
-    for( y = 0; y < mhi.rows; y++ )
+    for( int y = 0; y < rows; y++ )
     {
-        float* mhiptr = mhi.ptr<float>(y);
-        uchar* maskptr = mask.ptr<uchar>(y+1) + 1;
+        const float* mhiptr = mhi.ptr<float>(y);
+        const int idx = y * cols;
 
-        for( x = 0; x < mhi.cols; x++ )
+        for( int x = 0; x < cols; x++ )
         {
-            if( mhiptr[x] == ts && maskptr[x] == 0 )
+            if( mhiptr[x] == 0 )
             {
-                Rect cc;
-                floodFill( mhi, mask, Point(x,y), Scalar::all(0),
-                           &cc, Scalar::all(segThresh), Scalar::all(segThresh),
-                           FLOODFILL_MASK_ONLY + 2*256 + 4 );
+                label[idx + x] = -1;
+                continue;
+            }
 
-                for( int y1 = 0; y1 < cc.height; y1++ )
-                {
-                    float* segmaskptr = segmask.ptr<float>(cc.y + y1) + cc.x;
-                    uchar* maskptr1 = mask.ptr<uchar>(cc.y + y1 + 1) + cc.x + 1;
-
-                    for( int x1 = 0; x1 < cc.width; x1++ )
-                    {
-                        if( maskptr1[x1] > 1 )
-                        {
-                            maskptr1[x1] = 1;
-                            segmaskptr[x1] = comp_idx;
-                        }
-                    }
-                }
-                comp_idx += 1.f;
-                boundingRects.push_back(cc);
+            // parents precede their children, so the parent already points to the root
+            int root = parent[idx + x] = parent[parent[idx + x]];
+            int comp;
+            if( root == idx + x )
+            {
+                comp = (int)compBoxes.size();
+                compBoxes.push_back(Vec4i(x, y, x, y));
+                segIdx.push_back(0);
+            }
+            else
+            {
+                comp = label[root];
+                Vec4i& box = compBoxes[comp];
+                box[0] = std::min(box[0], x);
+                box[2] = std::max(box[2], x);
+                box[3] = y;
+            }
+            label[idx + x] = comp;
+
+            if( mhiptr[x] == ts && segIdx[comp] == 0 )
+            {
+                segComps.push_back(comp);
+                segIdx[comp] = (int)segComps.size();
             }
         }
     }
+
+    for( size_t i = 0; i < segComps.size(); i++ )
+    {
+        const Vec4i& box = compBoxes[segComps[i]];
+        boundingRects.push_back(Rect(box[0], box[1], box[2] - box[0] + 1, box[3] - box[1] + 1));
+    }
+
+    parallel_for_(Range(0, rows), [&](const Range& range)
+    {
+        for( int y = range.start; y < range.end; y++ )
+        {
+            const int* labelptr = &label[(size_t)y * cols];
+            float* segmaskptr = segmask.ptr<float>(y);
+
+            for( int x = 0; x < cols; x++ )
+                segmaskptr[x] = labelptr[x] < 0 ? 0.f : (float)segIdx[labelptr[x]];
+        }
+    }, segmask.total() / (double)(1 << 16));
 }
 
 }
@@ -107,96 +107,204 @@ inline void symOrtho( double a, double b, double &c, double &s, double &r )
   }
 }
 
+/* Products with A split in fixed stripes of rows, so that the results do not depend on the number
+ * of threads. The vectors are the rows of U (k x m) and V (k x n), one for each right-hand side.
+ *
+ *   mulAddA:  U.row(c) = scale[c] * U.row(c) + (A * V.row(c)^T)^T
+ *   mulAddAt: V.row(c) = scale[c] * V.row(c) + (A^T * U.row(c)^T)^T
+ */
+inline int getLSQRStripes( int m ) { return std::max( 1, std::min( 64, m / 256 ) ); }
+
+void mulAddA( const Mat &A, const Mat &V, const std::vector<double> &scale, Mat &U )
+{
+  const int n = A.cols, k = V.rows;
+  parallel_for_( Range( 0, A.rows ), [&]( const Range &range ) {
+    for ( int i = range.start; i < range.end; ++i )
+    {
+      const float *a = A.ptr<float>( i );
+      for ( int c = 0; c < k; ++c )
+      {
+        const float *v = V.ptr<float>( c );
+        float sum = 0;
+        for ( int j = 0; j < n; ++j )
+          sum += a[j] * v[j];
+        float &u = U.at<float>( c, i );
+        u = static_cast<float>( scale[c] * u ) + sum;
+      }
+    }
+  }, getLSQRStripes( A.rows ) );
+}
+
+void mulAddAt( const Mat &A, const Mat &U, const std::vector<double> &scale, Mat &V )
+{
+  const int m = A.rows, n = A.cols, k = U.rows;
+  const int stripes = getLSQRStripes( m );
+  Mat partial( stripes * k, n, CV_32F );
+  parallel_for_( Range( 0, stripes ), [&]( const Range &range ) {
+    for ( int s = range.start; s < range.end; ++s )
+    {
+      float *p = partial.ptr<float>( s * k );
+      std::fill( p, p + k * n, 0.0f );
+      const int end = (int)( (int64)m * ( s + 1 ) / stripes );
+      for ( int i = (int)( (int64)m * s / stripes ); i < end; ++i )
+      {
+        const float *a = A.ptr<float>( i );
+        for ( int c = 0; c < k; ++c )
+        {
+          const float u = U.at<float>( c, i );
+          float *pc = p + c * n;
+          for ( int j = 0; j < n; ++j )
+            pc[j] += a[j] * u;
+        }
+      }
+    }
+  }, stripes );
+
+  // reduce the stripes in order
+  for ( int c = 0; c < k; ++c )
+  {
+    float *v = V.ptr<float>( c );
+    for ( int j = 0; j < n; ++j )
+    {
+      double sum = scale[c] * v[j];
+      for ( int s = 0; s < stripes; ++s )
+        sum += partial.at<float>( s * k + c, j );
+      v[j] = static_cast<float>( sum );
+    }
+  }
+}
+
 /* Iterative LSQR algorithm for solving least squares problems.
  *
  * [1] Paige, C. C. and M. A. Saunders,
  * LSQR: An Algorithm for Sparse Linear Equations And Sparse Least Squares
  * ACM Trans. Math. Soft., Vol.8, 1982, pp. 43-71.
  *
- * Solves the following problem:
+ * Solves the following problem for each column b of B:
  *   argmin_x ||Ax - b|| + damp||x||
+ * The columns are solved together, so that each iteration reads A twice whatever their number.
  *
  * Output:
- *   x -- approximate solution
+ *   X -- approximate solutions, one column for each column of B
  */
-void solveLSQR( const Mat &A, const Mat &b, OutputArray xOut, const double damp = 0.0, const unsigned iter_lim = 10 )
+void solveLSQR( const Mat &A, const Mat &B, OutputArray XOut, const double damp = 0.0, const unsigned iter_lim = 10 )
 {
   const int n = A.size().width;
-  CV_Assert( A.size().height == b.size().height );
+  const int k = B.size().width;
+  CV_Assert( A.size().height == B.size().height );
   CV_Assert( A.type() == CV_32F );
-  CV_Assert( b.type() == CV_32F );
-  xOut.create( n, 1, CV_32F );
-
-  Mat v( n, 1, CV_32F, 0.0f );
-  Mat u = b;
-  Mat x = xOut.getMat();
-  x = Mat::zeros( x.size(), x.type() );
-  double alfa = 0;
-  double beta = cv::norm( u, NORM_L2 );
-  Mat w( n, 1, CV_32F, 0.0f );
-  const Mat AT = A.t();
-
-  if ( beta > 0 )
+  CV_Assert( B.type() == CV_32F );
+  XOut.create( n, k, CV_32F );
+
+  // one row per right-hand side
+  Mat u = B.t();
+  Mat v( k, n, CV_32F, 0.0f );
+  Mat w( k, n, CV_32F, 0.0f );
+  Mat x( k, n, CV_32F, 0.0f );
+  std::vector<double> alfa( k, 0. ), beta( k, 0. ), rhobar( k ), phibar( k ), scale( k, 0. );
+  std::vector<uchar> active( k );
+
+  for ( int c = 0; c < k; ++c )
   {
-    u *= 1 / beta;
-    v = AT * u;
-    alfa = cv::norm( v, NORM_L2 );
+    beta[c] = cv::norm( u.row( c ), NORM_L2 );
+    if ( beta[c] > 0 )
+      u.row( c ) *= 1 / beta[c];
   }
-
-  if ( alfa > 0 )
+  mulAddAt( A, u, scale, v );
+  for ( int c = 0; c < k; ++c )
   {
-    v *= 1 / alfa;
-    w = v.clone();
+    if ( beta[c] > 0 )
+      alfa[c] = cv::norm( v.row( c ), NORM_L2 );
+    else
+      v.row( c ).setTo( 0 );
+    if ( alfa[c] > 0 )
+    {
+      v.row( c ) *= 1 / alfa[c];
+      v.row( c ).copyTo( w.row( c ) );
+    }
+    rhobar[c] = alfa[c];
+    phibar[c] = beta[c];
+    active[c] = alfa[c] * beta[c] != 0;
+    if ( !active[c] )
+    {
+      // nothing to solve, keep the products from changing x
+      u.row( c ).setTo( 0 );
+      v.row( c ).setTo( 0 );
+    }
   }
 
-  double rhobar = alfa;
-  double phibar = beta;
-  if ( alfa * beta == 0 )
-    return;
-
   for ( unsigned itn = 0; itn < iter_lim; ++itn )
   {
-    u *= -alfa;
-    u += A * v;
-    beta = cv::norm( u, NORM_L2 );
+    for ( int c = 0; c < k; ++c )
+      scale[c] = -alfa[c];
+    mulAddA( A, v, scale, u );
 
-    if ( beta > 0 )
+    for ( int c = 0; c < k; ++c )
     {
-      u *= 1 / beta;
-      v *= -beta;
-      v += AT * u;
-      alfa = cv::norm( v, NORM_L2 );
-      if ( alfa > 0 )
-        v *= 1 / alfa;
+      beta[c] = cv::norm( u.row( c ), NORM_L2 );
+      if ( beta[c] > 0 )
+      {
+        u.row( c ) *= 1 / beta[c];
+        scale[c] = -beta[c];
+      }
+      else
+      {
+        // v is kept as is: u is zero and v only gets scaled by 1
+        scale[c] = 1;
+      }
     }
+    mulAddAt( A, u, scale, v );
 
-    double rhobar1 = sqrt( rhobar * rhobar + damp * damp );
-    double cs1 = rhobar / rhobar1;
-    phibar = cs1 * phibar;
+    for ( int c = 0; c < k; ++c )
+    {
+      if ( !active[c] )
+        continue;
 
-    double cs, sn, rho;
-    symOrtho( rhobar1, beta, cs, sn, rho );
+      if ( beta[c] > 0 )
+      {
+        alfa[c] = cv::norm( v.row( c ), NORM_L2 );
+        if ( alfa[c] > 0 )
+          v.row( c ) *= 1 / alfa[c];
+      }
 
-    double theta = sn * alfa;
-    rhobar = -cs * alfa;
-    double phi = cs * phibar;
-    phibar = sn * phibar;
+      double rhobar1 = sqrt( rhobar[c] * rhobar[c] + damp * damp );
+      double cs1 = rhobar[c] / rhobar1;
+      phibar[c] = cs1 * phibar[c];
 
-    double t1 = phi / rho;
-    double t2 = -theta / rho;
+      double cs, sn, rho;
+      symOrtho( rhobar1, beta[c], cs, sn, rho );
 
-    x += t1 * w;
-    w *= t2;
-    w += v;
+      double theta = sn * alfa[c];
+      rhobar[c] = -cs * alfa[c];
+      double phi = cs * phibar[c];
+      phibar[c] = sn * phibar[c];
+
+      double t1 = phi / rho;
+      double t2 = -theta / rho;
+
+      x.row( c ) += t1 * w.row( c );
+      w.row( c ) *= t2;
+      w.row( c ) += v.row( c );
+    }
   }
+
+  transpose( x, XOut );
 }
 
+/* Fills a row of the system with the DCT basis sampled at p. The basis is separable, so the
+ * cosines of each direction are computed once. */
 inline void _cpu_fillDCTSampledPoints( float *row, const Point2f &p, const Size &basisSize, const Size &size )
 {
+  AutoBuffer<float> cosY( basisSize.height );
+  for ( int n2 = 0; n2 < basisSize.height; ++n2 )
+    cosY[n2] = cosf( ( n2 * CV_PI / size.height ) * ( p.y + 0.5 ) );
+
   for ( int n1 = 0; n1 < basisSize.width; ++n1 )
+  {
+    const float cosX = cosf( ( n1 * CV_PI / size.width ) * ( p.x + 0.5 ) );
     for ( int n2 = 0; n2 < basisSize.height; ++n2 )
-      row[n1 * basisSize.height + n2] =
-        cosf( ( n1 * CV_PI / size.width ) * ( p.x + 0.5 ) ) * cosf( ( n2 * CV_PI / size.height ) * ( p.y + 0.5 ) );
+      row[n1 * basisSize.height + n2] = cosX * cosY[n2];
+  }
 }
 
 ocl::ProgramSource _ocl_fillDCTSampledPointsSource(
@@ -220,36 +328,53 @@ void applyCLAHE( UMat &img, float claheClip )
   clahe->apply( img, img );
 }
 
+/* Evaluates the flow from its DCT coefficients. With the normalization of the basis used to build
+ * the system, the inverse DCT reduces to
+ *   flow(y, x) = sum_{i,j} w(i * basisSize.height + j) * cos(i * pi * (x + 0.5) / W) * cos(j * pi * (y + 0.5) / H),
+ * which is computed with a pass on the columns of the basis followed by a pass on the rows.
+ */
 void reduceToFlow( const Mat &w1, const Mat &w2, Mat &flow, const Size &basisSize )
 {
   const Size size = flow.size();
-  Mat flowX( size, CV_32F, 0.0f );
-  Mat flowY( size, CV_32F, 0.0f );
-
-  const float mult = sqrt( static_cast<float>(size.area()) ) * 0.5;
-
-  for ( int i = 0; i < basisSize.width; ++i )
-    for ( int j = 0; j < basisSize.height; ++j )
+  const int bw = basisSize.width, bh = basisSize.height;
+
+  Mat cosX( bw, size.width, CV_32F ), cosY( size.height, bh, CV_32F );
+  for ( int i = 0; i < bw; ++i )
+    for ( int x = 0; x < size.width; ++x )
+      cosX.at<float>( i, x ) = static_cast<float>( cos( ( i * CV_PI / size.width ) * ( x + 0.5 ) ) );
+  for ( int y = 0; y < size.height; ++y )
+    for ( int j = 0; j < bh; ++j )
+      cosY.at<float>( y, j ) = static_cast<float>( cos( ( j * CV_PI / size.height ) * ( y + 0.5 ) ) );
+
+  // horizontal pass: t(j, x) = sum_i w(i * bh + j) * cos(i * pi * (x + 0.5) / W), both components interleaved
+  Mat t( bh, size.width, CV_32FC2, Scalar::all( 0 ) );
+  for ( int j = 0; j < bh; ++j )
+  {
+    Point2f *tj = t.ptr<Point2f>( j );
+    for ( int i = 0; i < bw; ++i )
     {
-      flowX.at<float>( j, i ) = w1.at<float>( i * basisSize.height + j ) * mult;
-      flowY.at<float>( j, i ) = w2.at<float>( i * basisSize.height + j ) * mult;
+      const Point2f coef( w1.at<float>( i * bh + j ), w2.at<float>( i * bh + j ) );
+      const float *cx = cosX.ptr<float>( i );
+      for ( int x = 0; x < size.width; ++x )
+        tj[x] += coef * cx[x];
     }
-  for ( int i = 0; i < basisSize.height; ++i )
-  {
-    flowX.at<float>( i, 0 ) *= M_SQRT2;
-    flowY.at<float>( i, 0 ) *= M_SQRT2;
-  }
-  for ( int i = 0; i < basisSize.width; ++i )
-  {
-    flowX.at<float>( 0, i ) *= M_SQRT2;
-    flowY.at<float>( 0, i ) *= M_SQRT2;
   }
 
-  dct( flowX, flowX, DCT_INVERSE );
-  dct( flowY, flowY, DCT_INVERSE );
-  for ( int i = 0; i < size.height; ++i )
-    for ( int j = 0; j < size.width; ++j )
-      flow.at<Point2f>( i, j ) = Point2f( flowX.at<float>( i, j ), flowY.at<float>( i, j ) );
+  // vertical pass
+  parallel_for_( Range( 0, size.height ), [&]( const Range &range ) {
+    for ( int y = range.start; y < range.end; ++y )
+    {
+      Point2f *f = flow.ptr<Point2f>( y );
+      const float *cy = cosY.ptr<float>( y );
+      std::fill( f, f + size.width, Point2f( 0, 0 ) );
+      for ( int j = 0; j < bh; ++j )
+      {
+        const Point2f *tj = t.ptr<Point2f>( j );
+        for ( int x = 0; x < size.width; ++x )
+          f[x] += tj[x] * cy[j];
+      }
+    }
+  } );
 }
 }
 
@@ -349,13 +474,15 @@ void OpticalFlowPCAFlow::getSystem( OutputArray AOut, OutputArray b1Out, OutputA
     Mat b1 = b1Out.getMat();
     Mat b2 = b2Out.getMat();
 
-    for ( size_t i = 0; i < features.size(); ++i )
-    {
-      _cpu_fillDCTSampledPoints( A.ptr<float>( i ), features[i], basisSize, size );
-      const Point2f flow = predictedFeatures[i] - features[i];
-      b1.at<float>( i ) = flow.x;
-      b2.at<float>( i ) = flow.y;
-    }
+    parallel_for_( Range( 0, (int)features.size() ), [&]( const Range &range ) {
+      for ( int i = range.start; i < range.end; ++i )
+      {
+        _cpu_fillDCTSampledPoints( A.ptr<float>( i ), features[i], basisSize, size );
+        const Point2f flow = predictedFeatures[i] - features[i];
+        b1.at<float>( i ) = flow.x;
+        b2.at<float>( i ) = flow.y;
+      }
+    } );
   }
 }
 
@@ -398,13 +525,15 @@ void OpticalFlowPCAFlow::getSystem( OutputArray A1Out, OutputArray A2Out, Output
     Mat b1 = b1Out.getMat();
     Mat b2 = b2Out.getMat();
 
-    for ( size_t i = 0; i < features.size(); ++i )
-    {
-      _cpu_fillDCTSampledPoints( A1.ptr<float>( i ), features[i], basisSize, size );
-      const Point2f flow = predictedFeatures[i] - features[i];
-      b1.at<float>( i ) = flow.x;
-      b2.at<float>( i ) = flow.y;
-    }
+    parallel_for_( Range( 0, (int)features.size() ), [&]( const Range &range ) {
+      for ( int i = range.start; i < range.end; ++i )
+      {
+        _cpu_fillDCTSampledPoints( A1.ptr<float>( i ), features[i], basisSize, size );
+        const Point2f flow = predictedFeatures[i] - features[i];
+        b1.at<float>( i ) = flow.x;
+        b2.at<float>( i ) = flow.y;
+      }
+    } );
   }
 
   Mat A1 = A1Out.getMat();
@@ -468,10 +597,14 @@ void OpticalFlowPCAFlow::calc( InputArray I0, InputArray I1, InputOutputArray fl
   }
   else
   {
-    Mat A, b1, b2;
+    // both components share the system matrix and are solved together
+    Mat A, b1, b2, w;
     getSystem( A, b1, b2, features, predictedFeatures, size );
-    solveLSQR( A, b1, w1, dampingFactor * size.area() );
-    solveLSQR( A, b2, w2, dampingFactor * size.area() );
+    Mat b;
+    hconcat( b1, b2, b );
+    solveLSQR( A, b, w, dampingFactor * size.area() );
+    w1 = w.col( 0 ).clone();
+    w2 = w.col( 1 ).clone();
   }
   Mat flowSmall( ( size / 8 ) * 2, CV_32FC2 );
   reduceToFlow( w1, w2, flowSmall, basisSize );
@@ -114,18 +114,136 @@ Mat sgeo_dist(const Mat& gra, const std::vector<Point2f> & points, float max, Ma
     return dm;
 }
 
+/*
+ * Raster propagation of the nearest seed on the rows [r0, r1) of a band, alternating
+ * raster scan order and inverse raster scan order until a round changes nothing.
+ * The rows next to the band belong to other bands and are only read, from the
+ * snapshots up (row r0 - 1) and down (row r1), to take their seed when it is nearer.
+ * Returns true if the band converged, border_changed tells if its first or last row changed.
+ */
+static bool propagate_band(const Mat & gra, Mat & dist, Mat & quellknoten, Mat & dirt,
+    int r0, int r1, const float * up_dist, const int * up_id, const float * down_dist, const int * down_id,
+    int max_rounds, bool & border_changed)
+{
+    int Dx[] = { -1,0,1,-1,1,-1,0,1 };
+    int Dy[] = { -1,-1,-1,0,0,1,1,1 };
+    bool updated = false;
+
+    // processes the row y from x_begin to x_end (excluded) in the direction x_step
+    auto process_row = [&](int y, int x_begin, int x_end, int x_step)
+    {
+        // rows y - 1, y and y + 1, the ones outside of the band are read only
+        const float * src_dist[3];
+        const int * src_id[3];
+        float * dst_dist[3];
+        int * dst_id[3];
+        uchar * dst_dirt[3];
+        bool border_row[3];
+        for (int k = 0; k < 3; k++) {
+            int ty = y + k - 1;
+            src_dist[k] = NULL;
+            src_id[k] = NULL;
+            dst_dist[k] = NULL;
+            dst_id[k] = NULL;
+            dst_dirt[k] = NULL;
+            border_row[k] = ty == r0 || ty == r1 - 1;
+            if (ty >= r0 && ty < r1) {
+                src_dist[k] = dst_dist[k] = dist.ptr<float>(ty);
+                src_id[k] = dst_id[k] = quellknoten.ptr<int>(ty);
+                dst_dirt[k] = dirt.ptr<uchar>(ty);
+            }
+            else if (ty >= 0 && ty < gra.rows) {
+                src_dist[k] = ty < r0 ? up_dist : down_dist;
+                src_id[k] = ty < r0 ? up_id : down_id;
+            }
+        }
+        const Vec8f * gra_row = gra.ptr<Vec8f>(y);
+
+        for (int x = x_begin; x != x_end; x += x_step) {
+            if (dst_dirt[1][x] == 0) {
+                continue;
+            }
+            dst_dirt[1][x] = 0;
+
+            float c_dist = dst_dist[1][x];
+            const Vec8f & gra_e = gra_row[x];
+
+            for (int i = 0; i < 8; i++) {
+                int k = Dy[i] + 1;
+                int tx = x + Dx[i];
+                if (src_dist[k] == NULL || tx < 0 || tx >= gra.cols) {
+                    continue;
+                }
+                float t_dist = src_dist[k][tx];
+                if (c_dist > t_dist) {
+                    if (c_dist > t_dist + gra_e[i]) {
+                        dst_id[1][x] = src_id[k][tx];
+                        dst_dist[1][x] = t_dist + gra_e[i];
+                        dst_dirt[1][x] = 1;
+                        updated = true;
+                        border_changed |= border_row[1];
+                    }
+                }
+                else if (dst_dist[k] != NULL) {
+                    if (c_dist + gra_e[i] < t_dist) {
+                        dst_id[k][tx] = dst_id[1][x];
+                        dst_dist[k][tx] = dst_dist[1][x] + gra_e[i];
+                        dst_dirt[k][tx] = 1;
+                        updated = true;
+                        border_changed |= border_row[k];
+                    }
+                }
+            }
+        }
+    };
+
+    /*
+        * on even rounds go rasterscanorder , on odd round inverse rasterscanorder
+        */
+    for (int rounds = 0; rounds < max_rounds; rounds++) {
+        updated = false;
+        if (rounds % 2 == 0) {
+            for (int y = r0; y < r1; y++)
+                process_row(y, 0, gra.cols, 1);
+        }
+        else {
+            for (int y = r1 - 1; y >= r0; y--)
+                process_row(y, gra.cols - 1, -1, -1);
+        }
+        if (!updated) {
+            return true;
+        }
+    }
+    return false;
+}
+
 Mat interpolate_irregular_nn_raster(const std::vector<Point2f> & prevPoints,
     const std::vector<Point2f> & nextPoints,
     const std::vector<uchar> & status,
     const Mat & i1)
 {
-    Mat gra = getGraph(i1, 0.1f);
-    int Dx[] = { -1,0,1,-1,1,-1,0,1 };
-    int Dy[] = { -1,-1,-1,0,0,1,1,1 };
+    GeoInterpolationBuffers buffers;
+    return interpolate_irregular_nn_raster(prevPoints, nextPoints, status, i1, buffers);
+}
+
+Mat interpolate_irregular_nn_raster(const std::vector<Point2f> & prevPoints,
+    const std::vector<Point2f> & nextPoints,
+    const std::vector<uchar> & status,
+    const Mat & i1,
+    GeoInterpolationBuffers & buffers)
+{
+    getGraph(i1, 0.1f, buffers.gra);
+    const Mat & gra = buffers.gra;
     int max_rounds = 10;
-    Mat dirt = Mat(gra.rows, gra.cols, CV_8U, Scalar(0));
-    Mat quellknoten = Mat(gra.rows, gra.cols, CV_32S, Scalar(-1));
-    Mat dist = Mat(gra.rows, gra.cols, CV_32F, Scalar(std::numeric_limits<float>::max()));
+    Mat & dirt = buffers.dirt;
+    Mat & quellknoten = buffers.quellknoten;
+    Mat & dist = buffers.dist;
+    dirt.create(gra.rows, gra.cols, CV_8U);
+    dirt.setTo(Scalar(0));
+    quellknoten.create(gra.rows, gra.cols, CV_32S);
+    quellknoten.setTo(Scalar(-1));
+    dist.create(gra.rows, gra.cols, CV_32F);
+    dist.setTo(Scalar(std::numeric_limits<float>::max()));
     /*
         * assign quellknoten ids.
         */
@@ -140,103 +258,70 @@ Mat interpolate_irregular_nn_raster(const std::vector<Point2f> & prevPoints,
         quellknoten.at<int>(y, x) = i;
     }
 
-    bool clean = true;
-    bool done = false;
-    int x = 0;
-    int y = 0;
-    int rounds = 0;
-    while (!done) {
-        /*
-            * Update x and y
-            * on even rounds go rasterscanorder , on odd round inverse rasterscanorder
-            */
-        if (rounds % 2 == 0) {
-            x++;
-            if (x >= gra.cols) {
-                x = 0;
-                y++;
-                if (y >= gra.rows) {
-                    y = 0;
-                    rounds++;
-                    y = gra.rows - 1;
-                    x = gra.cols - 1;
-                    if (rounds >= max_rounds || clean) {
-                        done = true;
-                        break;
-                    }
-                }
-            }
-        }
-        else {
-            x--;
-            if (x < 0) {
-                x = gra.cols - 1;
-                y--;
-                if (y < 0) {
-                    y = gra.rows - 1;
-                    rounds++;
-                    y = 0;
-                    x = 0;
-                    if (rounds >= max_rounds || clean) {
-                        done = true;
-                        break;
-                    }
-                }
-            }
-        }
-        if (dirt.at<uchar>(y, x) == 0) {
-            continue;
+    /*
+        * The image is split in bands of rows propagating in parallel. After each pass
+        * the first and last rows of the bands are exchanged, until none of them changes.
+        * The band height does not depend on the number of threads, so neither does the result.
+        */
+    const int band_height = 64;
+    int num_bands = std::max(gra.rows / band_height, 1);
+    std::vector<int> band_rows(num_bands + 1);
+    for (int b = 0; b <= num_bands; b++)
+        band_rows[b] = b * gra.rows / num_bands;
+    Mat & border_dist = buffers.border_dist;
+    Mat & border_id = buffers.border_id;
+    border_dist.create(2 * num_bands, gra.cols, CV_32F);
+    border_id.create(2 * num_bands, gra.cols, CV_32S);
+    std::vector<uchar> band_changed(num_bands);
+
+    for (int pass = 0; pass < num_bands + max_rounds; pass++)
+    {
+        for (int b = 0; b < num_bands; b++)
+        {
+            dist.row(band_rows[b]).copyTo(border_dist.row(2 * b));
+            dist.row(band_rows[b + 1] - 1).copyTo(border_dist.row(2 * b + 1));
+            quellknoten.row(band_rows[b]).copyTo(border_id.row(2 * b));
+            quellknoten.row(band_rows[b + 1] - 1).copyTo(border_id.row(2 * b + 1));
+            // recheck the rows next to the other bands, which may have changed
+            if (pass > 0 && b > 0)
+                dirt.row(band_rows[b]).setTo(Scalar(1));
+            if (pass > 0 && b < num_bands - 1)
+                dirt.row(band_rows[b + 1] - 1).setTo(Scalar(1));
         }
-        dirt.at<uchar>(y, x) = 0;
-
-        float c_dist = dist.at<float>(y, x);
-        Vec8f gra_e = gra.at<Vec8f>(y, x);
 
-        for (int i = 0; i < 8; i++) {
-            int tx = Dx[i];
-            int ty = Dy[i];
-            if (ty == 0 && tx == 0) {
-                continue;
-            }
-            if (x + tx < 0 || x + tx >= gra.cols) {
-                continue;
-            }
-            if (y + ty < 0 || y + ty >= gra.rows) {
-                continue;
-            }
-            if (c_dist > dist.at<float>(y + ty, x + tx)) {
-                if (c_dist > dist.at<float>(y + ty, x + tx) + gra_e[i]) {
-                    quellknoten.at<int>(y, x) = quellknoten.at<int>(y + ty, x + tx);
-                    dist.at<float>(y, x) = dist.at<float>(y + ty, x + tx) + gra_e[i];
-                    dirt.at<uchar>(y, x) = 1;
-                    clean = false;
-                }
-            }
-            else {
-                if (c_dist + gra_e[i] < dist.at<float>(y + ty, x + tx)) {
-                    quellknoten.at<int>(y + ty, x + tx) = quellknoten.at<int>(y, x);
-                    dist.at<float>(y + ty, x + tx) = dist.at<float>(y, x) + gra_e[i];
-                    dirt.at<uchar>(y + ty, x + tx) = 1;
-                    clean = false;
-                }
+        parallel_for_(Range(0, num_bands), [&](const Range & range)
+        {
+            for (int b = range.start; b < range.end; b++)
+            {
+                bool border_changed = false;
+                bool converged = propagate_band(gra, dist, quellknoten, dirt, band_rows[b], band_rows[b + 1],
+                    b > 0 ? border_dist.ptr<float>(2 * b - 1) : NULL, b > 0 ? border_id.ptr<int>(2 * b - 1) : NULL,
+                    b < num_bands - 1 ? border_dist.ptr<float>(2 * b + 2) : NULL,
+                    b < num_bands - 1 ? border_id.ptr<int>(2 * b + 2) : NULL,
+                    max_rounds, border_changed);
+                band_changed[b] = !converged || (border_changed && num_bands > 1);
             }
-        }
-
-
+        });
 
+        if (std::find(band_changed.begin(), band_changed.end(), 1) == band_changed.end())
+            break;
     }
 
     Mat nnFlow(i1.rows, i1.cols, CV_32FC2, Scalar(0));
-    for (y = 0; y < i1.rows; y++) {
-        for (x = 0; x < i1.cols; x++) {
-
-            int id = quellknoten.at<int>(y, x);
-            if (id != -1)
-            {
-                nnFlow.at<Point2f>(y, x) = nextPoints[id] - prevPoints[id];
+    parallel_for_(Range(0, i1.rows), [&](const Range & range)
+    {
+        for (int y = range.start; y < range.end; y++) {
+            const int * id_row = quellknoten.ptr<int>(y);
+            Point2f * flow_row = nnFlow.ptr<Point2f>(y);
+            for (int x = 0; x < i1.cols; x++) {
+                int id = id_row[x];
+                if (id != -1)
+                {
+                    flow_row[x] = nextPoints[id] - prevPoints[id];
+                }
             }
         }
-    }
+    });
     return nnFlow;
 }
 
@@ -358,42 +443,72 @@ Mat interpolate_irregular_knn(
 }
 
 Mat getGraph(const Mat &image, float edge_length)
+{
+    Mat gra;
+    getGraph(image, edge_length, gra);
+    return gra;
+}
+
+void getGraph(const Mat &image, float edge_length, Mat &gra)
 {
 
     int Dx[] = { -1,0,1,-1,1,-1,0,1 };
     int Dy[] = { -1,-1,-1,0,0,1,1,1 };
-    Mat gra(image.rows, image.cols, CV_32FC(8));
+    gra.create(image.rows, image.cols, CV_32FC(8));
 
-    for (int y = 0; y < gra.rows; y++) {
-        for (int x = 0; x < gra.cols; x++) {
+    /*
+        * edges to the next neighbours are computed first, each edge to a previous
+        * neighbour is then the same edge seen from the neighbour.
+        */
+    parallel_for_(Range(0, gra.rows), [&](const Range & range)
+    {
+        for (int y = range.start; y < range.end; y++) {
+            Vec8f * gra_row = gra.ptr<Vec8f>(y);
+            const Vec3b * image_row = image.ptr<Vec3b>(y);
+            for (int x = 0; x < gra.cols; x++) {
 
-            for (int i = 0; i < 8; i++) {
-                int dx = Dx[i];
-                int dy = Dy[i];
-                gra.at<Vec8f>(y, x)[i] = -1;
+                for (int i = 4; i < 8; i++) {
+                    int dx = Dx[i];
+                    int dy = Dy[i];
+                    gra_row[x][i] = -1;
 
-                if (x + dx < 0 || y + dy < 0 || x + dx >= gra.cols || y + dy >= gra.rows) {
-                    continue;
-                }
+                    if (x + dx < 0 || y + dy < 0 || x + dx >= gra.cols || y + dy >= gra.rows) {
+                        continue;
+                    }
 
-                if (i < 4) {
-                    int si = 7 - i;
-                    gra.at<Vec8f>(y, x)[i] = gra.at<Vec8f>(y + dy, x + dx)[si];
-                }
-                else {
+                    const Vec3b & neighbour = image.ptr<Vec3b>(y + dy)[x + dx];
                     float p1 = dx * dx*edge_length*edge_length + dy * dy*edge_length*edge_length;
-                    float p2 = static_cast<float>(image.at<Vec3b>(y, x)[0] - image.at<Vec3b>(y + dy, x + dx)[0]);
-                    float p3 = static_cast<float>(image.at<Vec3b>(y, x)[1] - image.at<Vec3b>(y + dy, x + dx)[1]);
-                    float p4 = static_cast<float>(image.at<Vec3b>(y, x)[2] - image.at<Vec3b>(y + dy, x + dx)[2]);
-                    gra.at<Vec8f>(y, x)[i] = sqrt(p1 + p2 * p2 + p3 * p3 + p4 * p4);
+                    float p2 = static_cast<float>(image_row[x][0] - neighbour[0]);
+                    float p3 = static_cast<float>(image_row[x][1] - neighbour[1]);
+                    float p4 = static_cast<float>(image_row[x][2] - neighbour[2]);
+                    gra_row[x][i] = sqrt(p1 + p2 * p2 + p3 * p3 + p4 * p4);
                 }
 
             }
-
         }
-    }
+    }, gra.total() / (double)(1 << 16));
 
-    return gra;
+    parallel_for_(Range(0, gra.rows), [&](const Range & range)
+    {
+        for (int y = range.start; y < range.end; y++) {
+            Vec8f * gra_row = gra.ptr<Vec8f>(y);
+            for (int x = 0; x < gra.cols; x++) {
+
+                for (int i = 0; i < 4; i++) {
+                    int dx = Dx[i];
+                    int dy = Dy[i];
+                    gra_row[x][i] = -1;
+
+                    if (x + dx < 0 || y + dy < 0 || x + dx >= gra.cols || y + dy >= gra.rows) {
+                        continue;
+                    }
+
+                    gra_row[x][i] = gra.ptr<Vec8f>(y + dy)[x + dx][7 - i];
+                }
+
+            }
+        }
+    }, gra.total() / (double)(1 << 16));
 }
 
 
@@ -8,7 +8,19 @@ namespace cv {
 namespace optflow {
 
 typedef Vec<float, 8> Vec8f;
+
+//! buffers of interpolate_irregular_nn_raster, kept from a frame to the next
+struct GeoInterpolationBuffers
+{
+    Mat gra;            //!< 8-neighbourhood graph
+    Mat dist;           //!< geodesic distance to the nearest seed
+    Mat quellknoten;    //!< index of the nearest seed
+    Mat dirt;           //!< pixels to be propagated
+    Mat border_dist, border_id; //!< first and last rows of the bands
+};
+
 Mat getGraph(const Mat & image, float edge_length);
+void getGraph(const Mat & image, float edge_length, Mat & gra);
 Mat sgeo_dist(const Mat& gra, int y, int x, float max, Mat &prev);
 Mat sgeo_dist(const Mat& gra, const std::vector<Point2f> & points, float max, Mat &prev);
 Mat interpolate_irregular_nw(const Mat &in, const Mat &mask, const Mat &color_img, float max_d, float bandwidth, float pixeldistance);
@@ -30,6 +42,11 @@ Mat interpolate_irregular_nn_raster(const std::vector<Point2f> & prevPoints,
     const std::vector<Point2f> & nextPoints,
     const std::vector<uchar> & status,
     const Mat & i1);
+Mat interpolate_irregular_nn_raster(const std::vector<Point2f> & prevPoints,
+    const std::vector<Point2f> & nextPoints,
+    const std::vector<uchar> & status,
+    const Mat & i1,
+    GeoInterpolationBuffers & buffers);
 
 }} // namespace
 #endif
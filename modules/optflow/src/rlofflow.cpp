@@ -236,7 +236,7 @@ public:
             Mat blurredPrevImage, blurredCurrImage;
             GaussianBlur(prevImage, blurredPrevImage, cv::Size(5, 5), -1);
             std::vector<uchar> status(filtered_currPoints.size(), 1);
-            interpolate_irregular_nn_raster(filtered_prevPoints, filtered_currPoints, status, blurredPrevImage).copyTo(dense_flow);
+            interpolate_irregular_nn_raster(filtered_prevPoints, filtered_currPoints, status, blurredPrevImage, geoBuffers).copyTo(dense_flow);
             std::vector<Mat> vecMats;
             std::vector<Mat> vecMats2(2);
             cv::split(dense_flow, vecMats);
@@ -265,6 +265,7 @@ public:
         prevPyramid[1].release();
         currPyramid[0].release();
         currPyramid[1].release();
+        geoBuffers = GeoInterpolationBuffers();
     }
 
 protected:
@@ -272,6 +273,7 @@ protected:
     float                         forwardBackwardThreshold;
     Ptr<CImageBuffer>             prevPyramid[2];
     Ptr<CImageBuffer>             currPyramid[2];
+    GeoInterpolationBuffers       geoBuffers;
     cv::Size                      gridStep;
     InterpolationType             interp_type;
     int                           k;
@@ -469,6 +469,147 @@ void getRandomCauchyVector( Vec< double, GPCPatchDescriptor::nFeatures > &v )
 }
 
 double getRobustMedian( double m ) { return m < 0 ? m * ( 1.0 + epsTolerance ) : m * ( 1.0 - epsTolerance ); }
+
+inline uint64 getTrailHash( const unsigned *leaf, int nTrees )
+{
+  uint64 h = 14695981039346656037ULL; // FNV-1a over the leaf indices
+  for ( int t = 0; t < nTrees; ++t )
+    h = ( h ^ leaf[t] ) * 1099511628211ULL;
+  h ^= h >> 29; // mix, as both the low (bucket) and the top (partition) bits are used
+  h *= 0xbf58476d1ce4e5b9ULL;
+  return h ^ ( h >> 32 );
+}
+
+/* Hash table entry for the trails join. Counters saturate at 2 since we only need to know whether a trail is unique. */
+struct TrailEntry
+{
+  const unsigned *leaf; //!< Representative trail, NULL for empty entries
+  uint64 hash;
+  int from, to;
+  uchar nFrom, nTo;
+};
+
+/* Indices of the trails of each partition: bucket p holds order[start[p]], ..., order[start[p + 1] - 1], in increasing order. */
+void bucketTrails( const std::vector< uint64 > &hash, int nParts, std::vector< int > &order, std::vector< int > &start )
+{
+  start.assign( nParts + 1, 0 );
+  for ( size_t i = 0; i < hash.size(); ++i )
+    ++start[int( hash[i] >> 58 & ( nParts - 1 ) ) + 1];
+  for ( int part = 0; part < nParts; ++part )
+    start[part + 1] += start[part];
+
+  std::vector< int > pos( start.begin(), start.end() - 1 );
+  order.resize( hash.size() );
+  for ( size_t i = 0; i < hash.size(); ++i )
+    order[pos[int( hash[i] >> 58 & ( nParts - 1 ) )]++] = (int)i;
+}
+
+class ParallelTrailsJoin : public ParallelLoopBody
+{
+private:
+  const std::vector< unsigned > &trailsFrom, &trailsTo;
+  const std::vector< uint64 > &hashFrom, &hashTo;
+  const std::vector< int > &orderFrom, &startFrom, &orderTo, &startTo;
+  const int nTrees;
+  std::vector< int > &matchTo;
+
+  ParallelTrailsJoin &operator=( const ParallelTrailsJoin & );
+
+  static TrailEntry &findEntry( std::vector< TrailEntry > &table, const unsigned *leaf, uint64 hash, int nTrees )
+  {
+    const size_t mask = table.size() - 1;
+    for ( size_t k = size_t( hash ) & mask;; k = ( k + 1 ) & mask )
+    {
+      TrailEntry &e = table[k];
+      if ( !e.leaf )
+      {
+        e.leaf = leaf;
+        e.hash = hash;
+        return e;
+      }
+      if ( e.hash == hash && memcmp( e.leaf, leaf, nTrees * sizeof( unsigned ) ) == 0 )
+        return e;
+    }
+  }
+
+public:
+  ParallelTrailsJoin( const std::vector< unsigned > &_trailsFrom, const std::vector< unsigned > &_trailsTo,
+                      const std::vector< uint64 > &_hashFrom, const std::vector< uint64 > &_hashTo,
+                      const std::vector< int > &_orderFrom, const std::vector< int > &_startFrom,
+                      const std::vector< int > &_orderTo, const std::vector< int > &_startTo, int _nTrees,
+                      std::vector< int > &_matchTo )
+      : trailsFrom( _trailsFrom ), trailsTo( _trailsTo ), hashFrom( _hashFrom ), hashTo( _hashTo ), orderFrom( _orderFrom ),
+        startFrom( _startFrom ), orderTo( _orderTo ), startTo( _startTo ), nTrees( _nTrees ), matchTo( _matchTo ){};
+
+  void operator()( const Range &range ) const CV_OVERRIDE
+  {
+    std::vector< TrailEntry > table;
+
+    // Every partition owns the trails whose hash falls into it, so the partitions never share an output element
+    for ( int part = range.start; part < range.end; ++part )
+    {
+      const int fromBegin = startFrom[part], fromEnd = startFrom[part + 1];
+      const int toBegin = startTo[part], toEnd = startTo[part + 1];
+
+      size_t tableSize = 16;
+      while ( tableSize < 2 * size_t( fromEnd - fromBegin + toEnd - toBegin ) )
+        tableSize *= 2;
+      const TrailEntry empty = { NULL, 0, -1, -1, 0, 0 };
+      table.assign( tableSize, empty );
+
+      for ( int k = toBegin; k < toEnd; ++k )
+      {
+        const int i = orderTo[k];
+        TrailEntry &e = findEntry( table, &trailsTo[(size_t)i * nTrees], hashTo[i], nTrees );
+        e.to = i;
+        e.nTo = (uchar)std::min( e.nTo + 1, 2 );
+      }
+      for ( int k = fromBegin; k < fromEnd; ++k )
+      {
+        const int i = orderFrom[k];
+        TrailEntry &e = findEntry( table, &trailsFrom[(size_t)i * nTrees], hashFrom[i], nTrees );
+        e.from = i;
+        e.nFrom = (uchar)std::min( e.nFrom + 1, 2 );
+      }
+
+      for ( size_t k = 0; k < table.size(); ++k )
+        if ( table[k].nFrom == 1 && table[k].nTo == 1 )
+          matchTo[table[k].from] = table[k].to;
+    }
+  }
+};
+
+/* Match patches whose trails (leaf indices in every tree, nTrees values per patch) are unique in both images.
+ * matchTo[i] receives the index of the patch in the second image matching the i-th patch of the first one, or -1.
+ */
+void findUniqueMatches( const std::vector< unsigned > &trailsFrom, const std::vector< unsigned > &trailsTo, int nTrees,
+                        std::vector< int > &matchTo )
+{
+  CV_Assert( nTrees > 0 );
+  CV_Assert( trailsFrom.size() % nTrees == 0 && trailsTo.size() % nTrees == 0 );
+
+  std::vector< uint64 > hashFrom( trailsFrom.size() / nTrees ), hashTo( trailsTo.size() / nTrees );
+  parallel_for_( Range( 0, (int)hashFrom.size() ), [&]( const Range &range ) {
+    for ( int i = range.start; i < range.end; ++i )
+      hashFrom[i] = getTrailHash( &trailsFrom[(size_t)i * nTrees], nTrees );
+  } );
+  parallel_for_( Range( 0, (int)hashTo.size() ), [&]( const Range &range ) {
+    for ( int i = range.start; i < range.end; ++i )
+      hashTo[i] = getTrailHash( &trailsTo[(size_t)i * nTrees], nTrees );
+  } );
+
+  matchTo.assign( hashFrom.size(), -1 );
+
+  // The result does not depend on the number of partitions, only the work split does
+  int nParts = 1;
+  while ( nParts < 64 && nParts < 4 * getNumThreads() )
+    nParts *= 2;
+  std::vector< int > orderFrom, startFrom, orderTo, startTo;
+  bucketTrails( hashFrom, nParts, orderFrom, startFrom );
+  bucketTrails( hashTo, nParts, orderTo, startTo );
+  parallel_for_( Range( 0, nParts ),
+                 ParallelTrailsJoin( trailsFrom, trailsTo, hashFrom, hashTo, orderFrom, startFrom, orderTo, startTo, nTrees, matchTo ) );
+}
 }
 
 double GPCPatchDescriptor::dot( const Vec< double, nFeatures > &coef ) const
@@ -737,6 +878,24 @@ Ptr< GPCTrainingSamples > GPCTrainingSamples::create( InputArrayOfArrays imagesF
   return ts;
 }
 
+void GPCDetails::findCorrespondences( const std::vector< unsigned > &trailsFrom, const std::vector< unsigned > &trailsTo, int nTrees,
+                                      Size fromSize, Size toSize, std::vector< std::pair< Point2i, Point2i > > &corr )
+{
+  std::vector< int > matchTo;
+  findUniqueMatches( trailsFrom, trailsTo, nTrees, matchTo );
+
+  for ( size_t i = 0; i < matchTo.size(); ++i )
+    if ( matchTo[i] >= 0 )
+    {
+      Point2i p, q;
+      getCoordinatesFromIndex( i, fromSize, p.x, p.y );
+      getCoordinatesFromIndex( matchTo[i], toSize, q.x, q.y );
+      corr.push_back( std::make_pair( p, q ) );
+    }
+
+  dropOutliers( corr );
+}
+
 void GPCDetails::dropOutliers( std::vector< std::pair< Point2i, Point2i > > &corr )
 {
   if ( corr.size() == 0 )
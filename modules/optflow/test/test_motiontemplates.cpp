@@ -494,6 +494,66 @@ int CV_MHIGlobalOrientTest::validate_test_results( int test_case_idx )
 }
 
 
+////////////////////// segment motion /////////////////////////
+
+// floodFill based reference: every not yet segmented pixel of the last silhouette starts a new segment
+static void test_segmentMotion( const Mat& mhi, Mat& segmask, vector<Rect>& rects, double timestamp, double segThresh )
+{
+    Mat mhiCopy = mhi.clone();
+    Mat mask = Mat::zeros( mhi.rows + 2, mhi.cols + 2, CV_8UC1 );
+    mask( Rect( 1, 1, mhi.cols, mhi.rows ) ).setTo( 1, mhi == 0 );
+    segmask = Mat::zeros( mhi.size(), CV_32F );
+    float comp_idx = 1.f;
+
+    for( int y = 0; y < mhi.rows; y++ )
+        for( int x = 0; x < mhi.cols; x++ )
+        {
+            if( mhi.at<float>(y, x) != (float)timestamp || mask.at<uchar>(y + 1, x + 1) != 0 )
+                continue;
+
+            Rect cc;
+            floodFill( mhiCopy, mask, Point(x, y), Scalar::all(0), &cc, Scalar::all(segThresh), Scalar::all(segThresh),
+                       FLOODFILL_MASK_ONLY + 2*256 + 4 );
+            Mat filled = mask( Rect( 1, 1, mhi.cols, mhi.rows ) ) == 2;
+            segmask.setTo( comp_idx, filled );
+            mask( Rect( 1, 1, mhi.cols, mhi.rows ) ).setTo( 1, filled );
+            comp_idx += 1.f;
+            rects.push_back( cc );
+        }
+}
+
+TEST(Video_MHISegment, accuracy)
+{
+    RNG& rng = cvtest::TS::ptr()->get_rng();
+
+    for( int iter = 0; iter < 20; iter++ )
+    {
+        // a few stamps of moving blobs on top of noise, with some holes
+        Size size( rng.uniform(1, 200), rng.uniform(1, 200) );
+        Mat mhi( size, CV_32F, Scalar::all(0) );
+        const int nstamps = rng.uniform(2, 6);
+        for( int t = 1; t <= nstamps; t++ )
+            for( int k = 0; k < 4; k++ )
+                circle( mhi, Point( rng.uniform(0, size.width), rng.uniform(0, size.height) ), rng.uniform(1, 40),
+                        Scalar::all(t), FILLED );
+        Mat holes( size, CV_8U );
+        rng.fill( holes, RNG::UNIFORM, 0, 8 );
+        mhi.setTo( 0, holes == 0 );
+
+        const double timestamp = nstamps, segThresh = rng.uniform(0., 2.);
+        Mat segmask, ref_segmask;
+        vector<Rect> rects, ref_rects;
+        cv::motempl::segmentMotion( mhi, segmask, rects, timestamp, segThresh );
+        test_segmentMotion( mhi, ref_segmask, ref_rects, timestamp, segThresh );
+
+        EXPECT_EQ( 0, cvtest::norm( segmask, ref_segmask, NORM_INF ) ) << size;
+        ASSERT_EQ( ref_rects.size(), rects.size() ) << size;
+        for( size_t i = 0; i < rects.size(); i++ )
+            EXPECT_EQ( ref_rects[i], rects[i] ) << size;
+    }
+}
+
+
 TEST(Video_MHIUpdate, accuracy) { CV_UpdateMHITest test; test.safe_run(); }
 TEST(Video_MHIGradient, accuracy) { CV_MHIGradientTest test; test.safe_run(); }
 TEST(Video_MHIGlobalOrient, accuracy) { CV_MHIGlobalOrientTest test; test.safe_run(); }
@@ -346,7 +346,8 @@ class CV_EXPORTS_W TrackerMOSSE : public cv::legacy::Tracker
 /** @brief This class is used to track multiple objects using the specified tracker algorithm.
 
 * The %MultiTracker is naive implementation of multiple object tracking.
-* It process the tracked objects independently without any optimization accross the tracked objects.
+* It process the tracked objects independently without any optimization accross the tracked objects,
+* the KCF, MOSSE and CSRT trackers are updated in parallel.
 */
 class CV_EXPORTS_W MultiTracker : public Algorithm
 {
@@ -382,6 +383,8 @@ public:
   /**
   * \brief Update the current tracking status.
   * The result will be saved in the internal storage.
+  * KCF, MOSSE and CSRT trackers are updated concurrently, other trackers and instances added for
+  * several objects are updated sequentially.
   * @param image input image
   */
   bool update(InputArray image);
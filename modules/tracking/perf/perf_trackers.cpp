@@ -99,4 +99,64 @@ PERF_TEST_P(Tracking, TLD, testing::ValuesIn(getTrackingParams()))
     runTrackingTest(tracker, GetParam());
 }
 
+PERF_TEST_P(Tracking, KCF_CN, testing::ValuesIn(getTrackingParams()))
+{
+    legacy::TrackerKCF::Params params;
+    params.desc_pca = TrackerKCF::CN;
+    params.desc_npca = 0;
+    auto tracker = legacy::TrackerKCF::create(params);
+    runTrackingTest(tracker, GetParam());
+}
+
+//==================================================================================================
+
+typedef perf::TestBaseWithParam<string> MultiTracking;
+
+static Ptr<legacy::Tracker> createLegacyTracker(const string& name)
+{
+    if (name == "KCF")
+        return legacy::TrackerKCF::create();
+    if (name == "MOSSE")
+        return legacy::TrackerMOSSE::create();
+    return legacy::TrackerCSRT::create();
+}
+
+// 100 targets on a 10x10 grid of a textured frame which moves by a few pixels per frame
+PERF_TEST_P(MultiTracking, targets_100, testing::Values("KCF", "MOSSE", "CSRT"))
+{
+    const int N = 10;
+    const int nTargets = 10;
+    const Size targetSize(40, 40);
+
+    Mat texture(Size(1280 + 2 * N * 3, 720 + 2 * N * 2), CV_8UC3);
+    RNG rng(0);
+    rng.fill(texture, RNG::UNIFORM, 0, 256);
+    GaussianBlur(texture, texture, Size(7, 7), 2);
+
+    std::vector<Mat> frames;
+    for (int i = 0; i < N; ++i)
+        frames.push_back(texture(Rect(Point(N * 3 + 3 * i, N * 2 + 2 * i), Size(1280, 720))).clone());
+
+    std::vector<Rect2d> boundingBoxes;
+    for (int y = 0; y < nTargets; y++)
+        for (int x = 0; x < nTargets; x++)
+            boundingBoxes.push_back(Rect2d(Point2d(60 + x * 116, 40 + y * 64), targetSize));
+
+    PERF_SAMPLE_BEGIN();
+    {
+        Ptr<legacy::MultiTracker> multiTracker = legacy::MultiTracker::create();
+        for (size_t i = 0; i < boundingBoxes.size(); i++)
+            multiTracker->add(createLegacyTracker(GetParam()), frames[0], boundingBoxes[i]);
+        for (int i = 1; i < N; ++i)
+        {
+            std::vector<Rect2d> rcs;
+            multiTracker->update(frames[i], rcs);
+            ASSERT_EQ(boundingBoxes.size(), rcs.size());
+        }
+    }
+    PERF_SAMPLE_END();
+
+    SANITY_CHECK_NOTHING();
+}
+
 }} // namespace
@@ -41,6 +41,7 @@
 
 #include "precomp.hpp"
 #include <stdlib.h>
+#include "opencv2/core/hal/intrin.hpp"
 
 namespace cv {
 namespace detail {
@@ -32817,4 +32818,33 @@ inline namespace tracking {
       {0.0087778f,-0.015645f,0.004769f,0.011785f,-0.54199f,0.31505f,0.00020476f,-0.020282f,0.00021236f,-0.34675f}
   };
 
+  void computeColorNames(const Mat& bgr, Mat& cnFeatures)
+  {
+    CV_Assert(bgr.type() == CV_8UC3);
+    cnFeatures.create(bgr.size(), CV_32FC(10));
+
+    // whole frames are split in stripes, patches are small enough to be processed at once
+    double nstripes = bgr.total() >= (1 << 16) ? (double)bgr.rows : 1.;
+    parallel_for_(Range(0, bgr.rows), [&](const Range& range) {
+      for (int i = range.start; i < range.end; i++) {
+        const uchar* src = bgr.ptr<uchar>(i);
+        float* dst = cnFeatures.ptr<float>(i);
+
+        for (int j = 0; j < bgr.cols; j++, src += 3, dst += 10) {
+          // 32 levels per channel, R is the least significant
+          const float* cn = ColorNames[(src[2] >> 3) + 32 * (src[1] >> 3) + 32 * 32 * (src[0] >> 3)];
+#if CV_SIMD128
+          v_store(dst, v_load(cn));
+          v_store(dst + 4, v_load(cn + 4));
+          dst[8] = cn[8];
+          dst[9] = cn[9];
+#else
+          for (int k = 0; k < 10; k++)
+            dst[k] = cn[k];
+#endif
+        }
+      }
+    }, nstripes);
+  }
+
 }}}  // namespace
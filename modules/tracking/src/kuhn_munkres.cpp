@@ -32,7 +32,11 @@ std::vector<size_t> KuhnMunkres::Solve(const cv::Mat& dissimilarity_matrix) {
     is_row_visited_ = std::vector<int>(n_, 0);
     is_col_visited_ = std::vector<int>(n_, 0);
 
-    Run();
+    if (n_ > kMaxMunkresSize) {
+        RunShortestAugmentingPaths();
+    } else {
+        Run();
+    }
 
     std::vector<size_t> results(static_cast<size_t>(marked_.rows), static_cast<size_t>(-1));
     for (int i = 0; i < marked_.rows; i++) {
@@ -173,4 +177,62 @@ void KuhnMunkres::Run() {
 }
 
 
+void KuhnMunkres::RunShortestAugmentingPaths() {
+    // Rows are added one by one, each one along the shortest augmenting path
+    // in the reduced costs dm_(i, j) - u[i] - v[j]. Index 0 is a virtual
+    // column holding the row being added, so arrays are 1-based.
+    const double inf = std::numeric_limits<double>::max();
+    std::vector<double> u(n_ + 1, 0.), v(n_ + 1, 0.), min_v(n_ + 1);
+    std::vector<int> row_of_col(n_ + 1, 0), way(n_ + 1, 0);
+    std::vector<uchar> used(n_ + 1);
+
+    for (int row = 1; row <= n_; row++) {
+        row_of_col[0] = row;
+        int col0 = 0;
+        std::fill(min_v.begin(), min_v.end(), inf);
+        std::fill(used.begin(), used.end(), (uchar)0);
+
+        do {
+            used[col0] = 1;
+            int row0 = row_of_col[col0];
+            const float* dm_ptr = dm_.ptr<float>(row0 - 1);
+            double delta = inf;
+            int col1 = 0;
+            for (int col = 1; col <= n_; col++) {
+                if (!used[col]) {
+                    double cur = dm_ptr[col - 1] - u[row0] - v[col];
+                    if (cur < min_v[col]) {
+                        min_v[col] = cur;
+                        way[col] = col0;
+                    }
+                    if (min_v[col] < delta) {
+                        delta = min_v[col];
+                        col1 = col;
+                    }
+                }
+            }
+            for (int col = 0; col <= n_; col++) {
+                if (used[col]) {
+                    u[row_of_col[col]] += delta;
+                    v[col] -= delta;
+                } else {
+                    min_v[col] -= delta;
+                }
+            }
+            col0 = col1;
+        } while (row_of_col[col0] != 0);
+
+        // flip the augmenting path
+        do {
+            int col1 = way[col0];
+            row_of_col[col0] = row_of_col[col1];
+            col0 = col1;
+        } while (col0 != 0);
+    }
+
+    for (int col = 1; col <= n_; col++) {
+        marked_.at<char>(row_of_col[col] - 1, col - 1) = kStar;
+    }
+}
+
 }}}  // namespace
\ No newline at end of file
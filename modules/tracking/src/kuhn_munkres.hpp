@@ -17,9 +17,13 @@ inline namespace tracking {
 ///
 /// \brief The KuhnMunkres class
 ///
-/// Solves the assignment problem.
+/// Solves the assignment problem. Small problems are solved with the
+/// classical Munkres steps on the dissimilarity matrix, larger ones with
+/// shortest augmenting paths and dual potentials (Jonker-Volgenant), in
+/// O(n^3) whatever the content of the matrix.
+/// Exported for the tests.
 ///
-class KuhnMunkres {
+class CV_EXPORTS KuhnMunkres {
 public:
     KuhnMunkres();
 
@@ -37,6 +41,7 @@ public:
 private:
     static constexpr int kStar = 1;
     static constexpr int kPrime = 2;
+    static constexpr int kMaxMunkresSize = 32;
 
     cv::Mat dm_;
     cv::Mat marked_;
@@ -54,6 +59,7 @@ private:
     int FindInRow(int row, int what);
     int FindInCol(int col, int what);
     void Run();
+    void RunShortestAugmentingPaths();
 };
 
 }}}  // namespace
@@ -83,10 +83,42 @@ inline namespace tracking {
   // update position of the tracked objects, the result is stored in internal storage
   bool MultiTracker::update(InputArray image)
   {
-    bool status = true;
-    for(unsigned i=0;i< trackerList.size(); i++){
-      status &= trackerList[i]->update(image, objects[i]);
+    const int nTrackers = (int)trackerList.size();
+    if (nTrackers == 0)
+      return true;
+
+    // KCF, MOSSE and CSRT trackers only read the frame and keep their state in their own instance,
+    // so they are updated in parallel. Other trackers may use global state (e.g. rand() in Boosting),
+    // they are updated one after the other, as are instances added for several objects.
+    Mat frame = image.getMat();
+    std::vector<int> parallelIdx, serialIdx;
+    for (int i = 0; i < nTrackers; i++)
+    {
+      const Ptr<Tracker>& tracker = trackerList[i];
+      bool reentrant = tracker.dynamicCast<TrackerKCF>() || tracker.dynamicCast<TrackerMOSSE>() ||
+                       tracker.dynamicCast<TrackerCSRT>();
+      for (int j = 0; j < nTrackers && reentrant; j++)
+        reentrant = j == i || trackerList[j] != tracker;
+      (reentrant ? parallelIdx : serialIdx).push_back(i);
+    }
+
+    std::vector<uchar> statuses(nTrackers);
+    for (size_t k = 0; k < serialIdx.size(); k++)
+    {
+      int i = serialIdx[k];
+      statuses[i] = trackerList[i]->update(frame, objects[i]);
     }
+    parallel_for_(Range(0, (int)parallelIdx.size()), [&](const Range& range) {
+      for (int k = range.start; k < range.end; k++)
+      {
+        int i = parallelIdx[k];
+        statuses[i] = trackerList[i]->update(frame, objects[i]);
+      }
+    });
+
+    bool status = true;
+    for (int i = 0; i < nTrackers; i++)
+      status &= statuses[i] != 0;
     return status;
   };
 
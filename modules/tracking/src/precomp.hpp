@@ -66,6 +66,13 @@ inline namespace tracking {
 
 	extern const float ColorNames[][10];
 
+    /* Color Names features
+     Maps each pixel of a CV_8UC3 BGR image to its 10 Color Names probabilities,
+     bgr - the input image (a patch or a whole frame),
+     cnFeatures - the CV_32FC(10) output, reallocated if needed.
+    */
+    void computeColorNames(const Mat& bgr, Mat& cnFeatures);
+
     /* Cholesky decomposition
      The function performs Cholesky decomposition <https://en.wikipedia.org/wiki/Cholesky_decomposition>.
      A - the Hermitian, positive-definite matrix,
@@ -106,25 +106,22 @@ Mat TrackerCSRTImpl::calculate_response(const Mat &image, const std::vector<Mat>
 
     std::vector<Mat> ftrs = get_features(patch, yf.size());
     std::vector<Mat> Ffeatures = fourier_transform_features(ftrs);
-    Mat resp, res;
-    if(params.use_channel_weights){
-        res = Mat::zeros(Ffeatures[0].size(), CV_32FC2);
-        Mat resp_ch;
-        Mat mul_mat;
-        for(size_t i = 0; i < Ffeatures.size(); ++i) {
-            mulSpectrums(Ffeatures[i], filter[i], resp_ch, 0, true);
-            res += (resp_ch * filter_weights[i]);
-        }
-        idft(res, res, DFT_SCALE | DFT_REAL_OUTPUT);
-    } else {
-        res = Mat::zeros(Ffeatures[0].size(), CV_32FC2);
-        Mat resp_ch;
-        for(size_t i = 0; i < Ffeatures.size(); ++i) {
-            mulSpectrums(Ffeatures[i], filter[i], resp_ch, 0 , true);
-            res = res + resp_ch;
+
+    // per channel responses are computed in parallel, then summed in channel order
+    std::vector<Mat> resp_ch(Ffeatures.size());
+    parallel_for_(Range(0, static_cast<int>(Ffeatures.size())), [&](const Range& range) {
+        for (int i = range.start; i < range.end; i++) {
+            mulSpectrums(Ffeatures[i], filter[i], resp_ch[i], 0, true);
+            if(params.use_channel_weights)
+                resp_ch[i] *= filter_weights[i];
         }
-        idft(res, res, DFT_SCALE | DFT_REAL_OUTPUT);
+    });
+
+    Mat res = Mat::zeros(Ffeatures[0].size(), CV_32FC2);
+    for(size_t i = 0; i < resp_ch.size(); ++i) {
+        res += resp_ch[i];
     }
+    idft(res, res, DFT_SCALE | DFT_REAL_OUTPUT);
     return res;
 }
 
@@ -139,16 +136,20 @@ void TrackerCSRTImpl::update_csr_filter(const Mat &image, const Mat &mask)
     std::vector<Mat> new_csr_filter = create_csr_filter(Fftrs, yf, mask);
     //calculate per channel weights
     if(params.use_channel_weights) {
-        Mat current_resp;
-        double max_val;
         float sum_weights = 0;
         std::vector<float> new_filter_weights = std::vector<float>(new_csr_filter.size());
-        for(size_t i = 0; i < new_csr_filter.size(); ++i) {
-            mulSpectrums(Fftrs[i], new_csr_filter[i], current_resp, 0, true);
-            idft(current_resp, current_resp, DFT_SCALE | DFT_REAL_OUTPUT);
-            minMaxLoc(current_resp, NULL, &max_val, NULL, NULL);
-            sum_weights += static_cast<float>(max_val);
-            new_filter_weights[i] = static_cast<float>(max_val);
+        parallel_for_(Range(0, static_cast<int>(new_csr_filter.size())), [&](const Range& range) {
+            Mat current_resp;
+            double max_val;
+            for (int i = range.start; i < range.end; i++) {
+                mulSpectrums(Fftrs[i], new_csr_filter[i], current_resp, 0, true);
+                idft(current_resp, current_resp, DFT_SCALE | DFT_REAL_OUTPUT);
+                minMaxLoc(current_resp, NULL, &max_val, NULL, NULL);
+                new_filter_weights[i] = static_cast<float>(max_val);
+            }
+        });
+        for(size_t i = 0; i < new_filter_weights.size(); ++i) {
+            sum_weights += new_filter_weights[i];
         }
         //update filter weights with new values
         float updated_sum = 0;
@@ -236,16 +237,17 @@ public:
             H = H.mul(P);
             dft(H, H, DFT_COMPLEX_OUTPUT);
             Mat L = Mat::zeros(H.size(), H.type()); //Lagrangian multiplier
-            Mat G;
+            // buffers reused by all the iterations
+            Mat G(H.size(), H.type()), GL(H.size(), H.type()), h;
             for(int iteration = 0; iteration < admm_iterations; ++iteration) {
-                G = divide_complex_matrices((Sxy + (mu * H) - L) , (Sxx + mu));
-                idft((mu * G) + L, H, DFT_SCALE | DFT_REAL_OUTPUT);
+                updateG(Sxy, Sxx, H, L, mu, G, GL);
+                idft(GL, h, DFT_SCALE | DFT_REAL_OUTPUT);
                 float lm = 1.0f / (lambda+mu);
-                H = H.mul(P*lm);
-                dft(H, H, DFT_COMPLEX_OUTPUT);
+                multiply(h, P, h, lm);
+                dft(h, H, DFT_COMPLEX_OUTPUT);
 
                 //Update variables for next iteration
-                L = L + mu * (G - H);
+                updateL(G, H, mu, L);
                 mu = min(mu_max, beta*mu);
             }
             result_filter[i] = H;
@@ -256,6 +258,45 @@ public:
         return *this;
     }
 
+    // G = (Sxy + mu * H - L) / (Sxx + mu) and GL = mu * G + L, in one pass over the spectra
+    static void updateG(const Mat &Sxy, const Mat &Sxx, const Mat &H, const Mat &L, float mu,
+            Mat &G, Mat &GL)
+    {
+        const int n = H.cols * 2;
+        for (int y = 0; y < H.rows; y++) {
+            const float* sxy = Sxy.ptr<float>(y);
+            const float* sxx = Sxx.ptr<float>(y);
+            const float* h = H.ptr<float>(y);
+            const float* l = L.ptr<float>(y);
+            float* g = G.ptr<float>(y);
+            float* gl = GL.ptr<float>(y);
+            for (int x = 0; x < n; x += 2) {
+                float a = sxy[x] + mu * h[x] - l[x];
+                float b = sxy[x + 1] + mu * h[x + 1] - l[x + 1];
+                float c = sxx[x] + mu;
+                float d = sxx[x + 1];
+                float div = c * c + d * d;
+                g[x] = (a * c + b * d) / div;
+                g[x + 1] = (b * c - a * d) / div;
+                gl[x] = mu * g[x] + l[x];
+                gl[x + 1] = mu * g[x + 1] + l[x + 1];
+            }
+        }
+    }
+
+    // L = L + mu * (G - H)
+    static void updateL(const Mat &G, const Mat &H, float mu, Mat &L)
+    {
+        const int n = H.cols * 2;
+        for (int y = 0; y < H.rows; y++) {
+            const float* g = G.ptr<float>(y);
+            const float* h = H.ptr<float>(y);
+            float* l = L.ptr<float>(y);
+            for (int x = 0; x < n; x++)
+                l[x] += mu * (g[x] - h[x]);
+        }
+    }
+
 private:
     int admm_iterations;
     Mat Y;
@@ -46,13 +46,14 @@ Mat gaussian_shaped_labels(const float sigma, const int w, const int h)
 std::vector<Mat> fourier_transform_features(const std::vector<Mat> &M)
 {
     std::vector<Mat> out(M.size());
-    Mat channel;
-    // iterate over channels and convert them to Fourier domain
-    for(size_t k = 0; k < M.size(); k++) {
-        M[k].convertTo(channel, CV_32F);
-        dft(channel, channel, DFT_COMPLEX_OUTPUT);
-        out[k] = (channel);
-    }
+    // convert the channels to Fourier domain in parallel
+    parallel_for_(Range(0, static_cast<int>(M.size())), [&](const Range& range) {
+        for(int k = range.start; k < range.end; k++) {
+            Mat channel;
+            M[k].convertTo(channel, CV_32F);
+            dft(channel, out[k], DFT_COMPLEX_OUTPUT);
+        }
+    });
     return out;
 }
 
@@ -495,24 +496,10 @@ std::vector<Mat> get_features_hog(const Mat &im, const int bin_size)
     return features;
 }
 
-std::vector<Mat> get_features_cn(const Mat &ppatch_data, const Size &output_size) {
-    Mat patch_data = ppatch_data.clone();
-    Vec3b & pixel = patch_data.at<Vec3b>(0,0);
-    unsigned index;
-
-    Mat cnFeatures = Mat::zeros(patch_data.rows,patch_data.cols,CV_32FC(10));
-
-    for(int i=0;i<patch_data.rows;i++){
-        for(int j=0;j<patch_data.cols;j++){
-            pixel=patch_data.at<Vec3b>(i,j);
-            index=(unsigned)(cvFloor((float)pixel[2]/8)+32*cvFloor((float)pixel[1]/8)+32*32*cvFloor((float)pixel[0]/8));
+std::vector<Mat> get_features_cn(const Mat &patch_data, const Size &output_size) {
+    Mat cnFeatures;
+    computeColorNames(patch_data, cnFeatures);
 
-            //copy the values
-            for(int k=0;k<10;k++){
-                cnFeatures.at<Vec<float,10> >(i,j)[k]=(float)ColorNames[index][k];
-            }
-        }
-    }
     std::vector<Mat> result;
     split(cnFeatures, result);
     for (size_t i = 0; i < result.size(); i++) {
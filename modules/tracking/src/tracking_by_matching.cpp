@@ -13,6 +13,7 @@
 #include <utility>
 #include <limits>
 #include <algorithm>
+#include <typeinfo>
 
 #include "opencv2/tracking/tracking_by_matching.hpp"
 #include "opencv2/core/check.hpp"
@@ -33,6 +34,11 @@ inline namespace tracking {
 
 using namespace tbm;
 
+// The built-in distances can be computed concurrently, user implementations may not be re-entrant
+static bool isBuiltinDistance(const IDescriptorDistance &distance) {
+    return typeid(distance) == typeid(CosDistance) || typeid(distance) == typeid(MatchTemplateDistance);
+}
+
 CosDistance::CosDistance(const cv::Size &descriptor_size)
     : descriptor_size_(descriptor_size) {
     TBM_CHECK(descriptor_size.area() != 0);
@@ -57,9 +63,16 @@ std::vector<float> CosDistance::compute(const std::vector<cv::Mat> &descrs1,
     TBM_CHECK(descrs1.size() == descrs2.size());
 
     std::vector<float> distances(descrs1.size(), 1.f);
-    for (size_t i = 0; i < descrs1.size(); i++) {
-        distances.at(i) = compute(descrs1.at(i), descrs2.at(i));
-    }
+    auto computeDistances = [&](const cv::Range& range) {
+        for (int i = range.start; i < range.end; i++) {
+            distances[i] = compute(descrs1[i], descrs2[i]);
+        }
+    };
+    cv::Range all(0, static_cast<int>(descrs1.size()));
+    if (isBuiltinDistance(*this))
+        cv::parallel_for_(all, computeDistances);
+    else
+        computeDistances(all);
 
     return distances;
 }
@@ -79,10 +92,17 @@ float MatchTemplateDistance::compute(const cv::Mat &descr1,
 
 std::vector<float> MatchTemplateDistance::compute(const std::vector<cv::Mat> &descrs1,
                                                   const std::vector<cv::Mat> &descrs2) {
-    std::vector<float> result;
-    for (size_t i = 0; i < descrs1.size(); i++) {
-        result.push_back(compute(descrs1[i], descrs2[i]));
-    }
+    std::vector<float> result(descrs1.size());
+    auto computeDistances = [&](const cv::Range& range) {
+        for (int i = range.start; i < range.end; i++) {
+            result[i] = compute(descrs1[i], descrs2[i]);
+        }
+    };
+    cv::Range all(0, static_cast<int>(descrs1.size()));
+    if (isBuiltinDistance(*this))
+        cv::parallel_for_(all, computeDistances);
+    else
+        computeDistances(all);
     return result;
 }
 
@@ -996,17 +1016,27 @@ void TrackerByMatching::ComputeDissimilarityMatrix(
     const std::vector<cv::Mat> &descriptors_fast,
     cv::Mat& dissimilarity_matrix) {
     cv::Mat am(static_cast<int>(active_tracks.size()), static_cast<int>(detections.size()), CV_32F, cv::Scalar(0));
-    int i = 0;
-    for (auto id : active_tracks) {
-        auto ptr = am.ptr<float>(i);
-        for (size_t j = 0; j < descriptors_fast.size(); j++) {
-            auto last_det = tracks_.at(id).objects.back();
-            last_det.rect = tracks_.at(id).predicted_rect;
-            ptr[j] = AffinityFast(tracks_.at(id).descriptor_fast, last_det,
-                                  descriptors_fast[j], detections[j]);
+    std::vector<size_t> track_ids(active_tracks.begin(), active_tracks.end());
+
+    // rows are independent, the affinities of each track are computed in parallel
+    // when the fast distance is a built-in one
+    auto computeRows = [&](const cv::Range& range) {
+        for (int i = range.start; i < range.end; i++) {
+            const auto& track = tracks_.at(track_ids[i]);
+            auto last_det = track.objects.back();
+            last_det.rect = track.predicted_rect;
+
+            auto ptr = am.ptr<float>(i);
+            for (size_t j = 0; j < descriptors_fast.size(); j++) {
+                ptr[j] = AffinityFast(track.descriptor_fast, last_det,
+                                      descriptors_fast[j], detections[j]);
+            }
         }
-        i++;
-    }
+    };
+    if (distance_fast_ && isBuiltinDistance(*distance_fast_))
+        cv::parallel_for_(cv::Range(0, am.rows), computeRows);
+    else
+        computeRows(cv::Range(0, am.rows));
     dissimilarity_matrix = 1.0 - am;
 }
 
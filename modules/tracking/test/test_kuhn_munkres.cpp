@@ -0,0 +1,95 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "test_precomp.hpp"
+
+#include "../src/kuhn_munkres.hpp"
+
+namespace opencv_test { namespace {
+
+using namespace cv::detail::tracking;
+
+// cost of the best assignment of the rows to distinct columns, by exhaustive search
+static float bruteForceCost(const Mat& m, int row, std::vector<uchar>& used_cols)
+{
+    if (row == m.rows)
+        return 0.f;
+    float best = std::numeric_limits<float>::max();
+    for (int col = 0; col < m.cols; col++)
+    {
+        if (used_cols[col])
+            continue;
+        used_cols[col] = 1;
+        best = std::min(best, m.at<float>(row, col) + bruteForceCost(m, row + 1, used_cols));
+        used_cols[col] = 0;
+    }
+    return best;
+}
+
+// cost of the assignment found by the solver, checking that the columns are distinct
+static float solverCost(const Mat& m)
+{
+    std::vector<size_t> result = KuhnMunkres().Solve(m);
+    const size_t n = (size_t)std::max(m.rows, m.cols);
+    EXPECT_EQ(n, result.size());
+    std::vector<uchar> used_cols(n, 0);
+    float cost = 0.f;
+    for (size_t row = 0; row < result.size(); row++)
+    {
+        size_t col = result[row];
+        EXPECT_LT(col, n);
+        if (col >= n)
+            continue;
+        EXPECT_FALSE(used_cols[col]) << "column " << col << " assigned twice";
+        used_cols[col] = 1;
+        if ((int)row < m.rows && (int)col < m.cols)
+            cost += m.at<float>((int)row, (int)col);
+    }
+    return cost;
+}
+
+// the matrices are padded to a square larger than 32, which is solved with shortest augmenting paths,
+// integer costs in a small range give many ties
+TEST(KuhnMunkres, shortest_paths_vs_brute_force)
+{
+    RNG& rng = TS::ptr()->get_rng();
+    const Size sizes[] = { Size(40, 3), Size(34, 4), Size(3, 40), Size(4, 34) };
+    for (const Size& size : sizes)
+    {
+        for (int iter = 0; iter < 10; iter++)
+        {
+            Mat m(size, CV_32F);
+            for (int i = 0; i < m.rows; i++)
+                for (int j = 0; j < m.cols; j++)
+                    m.at<float>(i, j) = (float)rng.uniform(0, 5);
+
+            // few rows are assigned to columns, or few columns to rows
+            Mat few_rows = m.rows < m.cols ? m : Mat(m.t());
+            std::vector<uchar> used_cols(few_rows.cols, 0);
+            EXPECT_EQ(bruteForceCost(few_rows, 0, used_cols), solverCost(m)) << "size: " << size;
+        }
+    }
+}
+
+TEST(KuhnMunkres, shortest_paths_planted_assignment)
+{
+    RNG& rng = TS::ptr()->get_rng();
+    const int n = 100;
+    std::vector<int> perm(n);
+    for (int i = 0; i < n; i++)
+        perm[i] = i;
+    cv::randShuffle(perm, 1, &rng);
+
+    // the only zero cost assignment is the planted one
+    Mat m(n, n, CV_32F);
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++)
+            m.at<float>(i, j) = j == perm[i] ? 0.f : (float)rng.uniform(1, 10);
+
+    std::vector<size_t> result = KuhnMunkres().Solve(m);
+    ASSERT_EQ((size_t)n, result.size());
+    for (int i = 0; i < n; i++)
+        EXPECT_EQ((size_t)perm[i], result[i]) << "row " << i;
+}
+
+}} // namespace
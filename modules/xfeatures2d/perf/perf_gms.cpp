@@ -0,0 +1,39 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+typedef tuple<int, bool, bool> GMSParams;
+typedef perf::TestBaseWithParam<GMSParams> gms;
+
+PERF_TEST_P(gms, matchGMS, testing::Combine(testing::Values(10000, 100000), testing::Bool(), testing::Bool()))
+{
+    const int numMatches = get<0>(GetParam());
+    const bool withRotation = get<1>(GetParam()), withScale = get<2>(GetParam());
+    const Size size1(1920, 1080), size2(1920, 1080);
+
+    // 60% of the matches follow a rotation and a shift, the rest are outliers
+    RNG rng(0);
+    vector<KeyPoint> keypoints1(numMatches), keypoints2(numMatches);
+    vector<DMatch> matches(numMatches);
+    const float angle = 0.1f, c = std::cos(angle), s = std::sin(angle);
+    for (int i = 0; i < numMatches; i++)
+    {
+        Point2f p(rng.uniform(0.f, (float)size1.width), rng.uniform(0.f, (float)size1.height));
+        Point2f q(c * p.x - s * p.y + 150.f, s * p.x + c * p.y - 50.f);
+        if (rng.uniform(0.f, 1.f) > 0.6f || q.x < 0 || q.y < 0 || q.x >= size2.width || q.y >= size2.height)
+            q = Point2f(rng.uniform(0.f, (float)size2.width), rng.uniform(0.f, (float)size2.height));
+        keypoints1[i] = KeyPoint(p, 7.f);
+        keypoints2[i] = KeyPoint(q, 7.f);
+        matches[i] = DMatch(i, i, 0.f);
+    }
+
+    vector<DMatch> matchesGMS;
+    TEST_CYCLE() matchGMS(size1, size2, keypoints1, keypoints2, matches, matchesGMS, withRotation, withScale);
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
@@ -0,0 +1,51 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+typedef perf::TestBaseWithParam<std::string> harris_laplace;
+
+#define HARRIS_LAPLACE_IMAGES \
+    "cv/detectors_descriptors_evaluation/images_datasets/leuven/img1.png",\
+    "stitching/a3.png"
+
+PERF_TEST_P(harris_laplace, detect, testing::Values(HARRIS_LAPLACE_IMAGES))
+{
+    string filename = getDataPath(GetParam());
+    Mat frame = imread(filename, IMREAD_GRAYSCALE);
+    ASSERT_FALSE(frame.empty()) << "Unable to load source image " << filename;
+
+    Mat mask;
+    declare.in(frame).time(90);
+
+    Ptr<HarrisLaplaceFeatureDetector> detector = HarrisLaplaceFeatureDetector::create();
+    vector<KeyPoint> points;
+    TEST_CYCLE() detector->detect(frame, points, mask);
+
+    SANITY_CHECK_NOTHING();
+}
+
+PERF_TEST_P(harris_laplace, detect_affine, testing::Values(HARRIS_LAPLACE_IMAGES))
+{
+    string filename = getDataPath(GetParam());
+    Mat frame = imread(filename, IMREAD_GRAYSCALE);
+    ASSERT_FALSE(frame.empty()) << "Unable to load source image " << filename;
+
+    Mat mask;
+    declare.in(frame).time(300);
+
+    Ptr<AffineFeature2D> detector = AffineFeature2D::create(HarrisLaplaceFeatureDetector::create());
+    vector<Elliptic_KeyPoint> points;
+    TEST_CYCLE()
+    {
+        // the elliptic keypoints are appended to the output vector
+        points.clear();
+        detector->detect(frame, points, mask);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
@@ -33,4 +33,21 @@ PERF_TEST_P(latch, extract, testing::Values(LATCH_IMAGES))
 }
 #endif // NONFREE
 
+PERF_TEST_P(latch, extract_orb, testing::Values(LATCH_IMAGES))
+{
+    string filename = getDataPath(GetParam());
+    Mat frame = imread(filename, IMREAD_GRAYSCALE);
+    ASSERT_FALSE(frame.empty()) << "Unable to load source image " << filename;
+
+    Ptr<ORB> detector = ORB::create(4000);
+    vector<KeyPoint> points;
+    detector->detect(frame, points);
+
+    Ptr<LATCH> descriptor = LATCH::create();
+    Mat descriptors;
+    TEST_CYCLE() descriptor->compute(frame, points, descriptors);
+
+    SANITY_CHECK_NOTHING();
+}
+
 }} // namespace
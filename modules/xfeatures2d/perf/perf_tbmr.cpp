@@ -0,0 +1,50 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+typedef perf::TestBaseWithParam<std::string> tbmr;
+
+#define TBMR_IMAGES \
+    "cv/detectors_descriptors_evaluation/images_datasets/leuven/img1.png",\
+    "stitching/a3.png"
+
+PERF_TEST_P(tbmr, detect, testing::Values(TBMR_IMAGES))
+{
+    string filename = getDataPath(GetParam());
+    Mat frame = imread(filename, IMREAD_GRAYSCALE);
+    ASSERT_FALSE(frame.empty()) << "Unable to load source image " << filename;
+
+    Mat mask;
+    declare.in(frame);
+
+    Ptr<TBMR> detector = TBMR::create();
+    vector<KeyPoint> points;
+    TEST_CYCLE() detector->detect(frame, points, mask);
+
+    SANITY_CHECK_NOTHING();
+}
+
+// large image, as the aerial ones
+PERF_TEST_P(tbmr, detect_large, testing::Values(TBMR_IMAGES))
+{
+    string filename = getDataPath(GetParam());
+    Mat frame = imread(filename, IMREAD_GRAYSCALE);
+    ASSERT_FALSE(frame.empty()) << "Unable to load source image " << filename;
+
+    Mat large;
+    repeat(frame, 3, 3, large);
+
+    Mat mask;
+    declare.in(large).time(90);
+
+    Ptr<TBMR> detector = TBMR::create();
+    vector<KeyPoint> points;
+    TEST_CYCLE() detector->detect(large, points, mask);
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
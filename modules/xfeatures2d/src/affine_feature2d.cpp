@@ -453,24 +453,40 @@ float selDifferentiationScale(const Mat & img, Mat & Lxm2smooth, Mat & Lxmysmoot
 void calcAffineCovariantRegions(const Mat & image, const std::vector<KeyPoint> & keypoints,
         std::vector<Elliptic_KeyPoint> & affRegions)
 {
-    for (size_t i = 0; i < keypoints.size(); ++i)
+    //Each keypoint is adapted on its own, in parallel
+    std::vector<Elliptic_KeyPoint> adapted(keypoints.size());
+    std::vector<uchar> converged(keypoints.size(), 0);
+    parallel_for_(Range(0, (int) keypoints.size()), [&](const Range& range)
     {
-        KeyPoint kp = keypoints[i];
-        Elliptic_KeyPoint ex(kp.pt, 0, Size_<float> (kp.size / 2, kp.size / 2), kp.size,
-                kp.size / 6);
+        for (int i = range.start; i < range.end; ++i)
+        {
+            KeyPoint kp = keypoints[i];
+            Elliptic_KeyPoint ex(kp.pt, 0, Size_<float> (kp.size / 2, kp.size / 2), kp.size,
+                    kp.size / 6);
 
-        if (calcAffineAdaptation(image, ex))
-            affRegions.push_back(ex);
+            converged[i] = calcAffineAdaptation(image, ex);
+            adapted[i] = ex;
+        }
+    });
+    for (size_t i = 0; i < keypoints.size(); ++i)
+    {
+        if (converged[i])
+            affRegions.push_back(adapted[i]);
     }
+
     //Erase similar keypoint
     float maxDiff = 4;
-    Mat colorimg;
+    std::vector<uchar> erased(affRegions.size(), 0);
     for (size_t i = 0; i < affRegions.size(); i++)
     {
-        Elliptic_KeyPoint kp1 = affRegions[i];
+        if (erased[i])
+            continue;
+        const Elliptic_KeyPoint& kp1 = affRegions[i];
         for (size_t j = i+1; j < affRegions.size(); j++){
 
-            Elliptic_KeyPoint kp2 = affRegions[j];
+            if (erased[j])
+                continue;
+            const Elliptic_KeyPoint& kp2 = affRegions[j];
 
             if(norm(kp1.pt-kp2.pt)<=maxDiff){
                 float phi1, phi2;
@@ -483,12 +499,18 @@ void calcAffineCovariantRegions(const Mat & image, const std::vector<KeyPoint> &
                 si1 = kp1.si;
                 si2 = kp2.si;
                 if(std::abs(phi1-phi2)<15 && std::max(si1,si2)/std::min(si1,si2)<1.4f && axes1.width-axes2.width<5 && axes1.height-axes2.height<5){
-                    affRegions.erase(affRegions.begin()+j);
-                    j--;
+                    erased[j] = 1;
                 }
             }
         }
     }
+    size_t k = 0;
+    for (size_t i = 0; i < affRegions.size(); i++)
+    {
+        if (!erased[i])
+            affRegions[k++] = affRegions[i];
+    }
+    affRegions.resize(k);
 }
 
 void calcAffineCovariantDescriptors(const Ptr<DescriptorExtractor>& dextractor, const Mat& img,
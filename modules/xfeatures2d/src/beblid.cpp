@@ -9,6 +9,7 @@
 //     Pattern Recognition Letters, 133:366–372, 2020.
 
 #include "precomp.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 
 #define CV_BEBLID_PARALLEL
 
@@ -69,9 +70,18 @@ private:
     float scale_factor_;
     cv::Size patch_size_;
 
+    // The weak learners as a structure of arrays, for the vectorized evaluation
+    std::vector<float> wl_x1_, wl_y1_, wl_x2_, wl_y2_, wl_radius_;
+    std::vector<decltype(WeakLearnerT::th)> wl_th_;
+
     void computeBoxDiffsDescriptor(const cv::Mat &integralImg,
                                    const std::vector<cv::KeyPoint> &keypoints,
                                    cv::Mat &descriptors);
+
+#if CV_SIMD128
+    void computeBoxDiffsDescriptorSIMD(const int *integralPtr, int integralStep,
+                                       const cv::KeyPoint &kp, uchar *d) const;
+#endif
 }; // END BEBLID_Impl CLASS
 
 
@@ -152,48 +162,67 @@ static inline bool isKeypointInTheBorder(const cv::KeyPoint &kp,
 }
 
 /**
- * @brief Rectifies the coordinates of the measurement functions that conform the descriptor
- * with the keypoint location parameters.
- * @param wlPatchParams The input weak learner parameters learnt for the normalized patch
- * @param wlImageParams The output  weak learner parameters adapted to the keypoint location
+ * @brief Computes the affine transformation from the normalized patch to the image for a keypoint.
  * @param kp The keypoint defining the offset, rotation and scale to be applied
+ * @param m The output 2x3 transformation matrix, row by row
  * @param scaleFactor A scale factor that magnifies the measurement functions w.r.t. the keypoint.
  * @param patchSize The size of the normalized patch where the measurement functions were learnt.
+ * @return The scale of the transformation
  */
-template< typename WeakLearnerT>
-static inline void rectifyABWL(const std::vector<WeakLearnerT> &wlPatchParams,
-                               std::vector<WeakLearnerT> &wlImageParams,
-                               const cv::KeyPoint &kp,
-                               float scaleFactor = 1,
-                               const cv::Size &patchSize = cv::Size(32, 32))
+static inline float getRectification(const cv::KeyPoint &kp,
+                                     float m[6],
+                                     float scaleFactor = 1,
+                                     const cv::Size &patchSize = cv::Size(32, 32))
 {
-    float m00, m01, m02, m10, m11, m12;
     float s, cosine, sine;
 
     s = scaleFactor * kp.size / (0.5f * (patchSize.width + patchSize.height));
-    wlImageParams.resize(wlPatchParams.size());
 
     if (kp.angle == -1)
     {
-        m00 = s;
-        m01 = 0.0f;
-        m02 = -0.5f * s * patchSize.width + kp.pt.x;
-        m10 = 0.0f;
-        m11 = s;
-        m12 = -s * 0.5f * patchSize.height + kp.pt.y;
+        m[0] = s;
+        m[1] = 0.0f;
+        m[2] = -0.5f * s * patchSize.width + kp.pt.x;
+        m[3] = 0.0f;
+        m[4] = s;
+        m[5] = -s * 0.5f * patchSize.height + kp.pt.y;
     }
     else
     {
         cosine = (kp.angle >= 0) ? float(cos(kp.angle * CV_DEGREES_TO_RADS)) : 1.f;
         sine = (kp.angle >= 0) ? float(sin(kp.angle * CV_DEGREES_TO_RADS)) : 0.f;
 
-        m00 = s * cosine;
-        m01 = -s * sine;
-        m02 = (-s * cosine + s * sine) * patchSize.width * 0.5f + kp.pt.x;
-        m10 = s * sine;
-        m11 = s * cosine;
-        m12 = (-s * sine - s * cosine) * patchSize.height * 0.5f + kp.pt.y;
+        m[0] = s * cosine;
+        m[1] = -s * sine;
+        m[2] = (-s * cosine + s * sine) * patchSize.width * 0.5f + kp.pt.x;
+        m[3] = s * sine;
+        m[4] = s * cosine;
+        m[5] = (-s * sine - s * cosine) * patchSize.height * 0.5f + kp.pt.y;
     }
+    return s;
+}
+
+/**
+ * @brief Rectifies the coordinates of the measurement functions that conform the descriptor
+ * with the keypoint location parameters.
+ * @param wlPatchParams The input weak learner parameters learnt for the normalized patch
+ * @param wlImageParams The output  weak learner parameters adapted to the keypoint location
+ * @param kp The keypoint defining the offset, rotation and scale to be applied
+ * @param scaleFactor A scale factor that magnifies the measurement functions w.r.t. the keypoint.
+ * @param patchSize The size of the normalized patch where the measurement functions were learnt.
+ */
+template< typename WeakLearnerT>
+static inline void rectifyABWL(const std::vector<WeakLearnerT> &wlPatchParams,
+                               std::vector<WeakLearnerT> &wlImageParams,
+                               const cv::KeyPoint &kp,
+                               float scaleFactor = 1,
+                               const cv::Size &patchSize = cv::Size(32, 32))
+{
+    float m[6];
+    const float s = getRectification(kp, m, scaleFactor, patchSize);
+    const float m00 = m[0], m01 = m[1], m02 = m[2], m10 = m[3], m11 = m[4], m12 = m[5];
+
+    wlImageParams.resize(wlPatchParams.size());
 
     for (size_t i = 0; i < wlPatchParams.size(); i++)
     {
@@ -352,8 +381,89 @@ template <class WeakLearnerT>
 BEBLID_Impl<WeakLearnerT>::BEBLID_Impl(float scale_factor, const std::vector<WeakLearnerT>& wl_params)
     :  wl_params_(wl_params), scale_factor_(scale_factor), patch_size_(32, 32)
 {
+    CV_Assert(wl_params_.size() % 8 == 0);
+    for (size_t i = 0; i < wl_params_.size(); i++)
+    {
+        wl_x1_.push_back((float)wl_params_[i].x1);
+        wl_y1_.push_back((float)wl_params_[i].y1);
+        wl_x2_.push_back((float)wl_params_[i].x2);
+        wl_y2_.push_back((float)wl_params_[i].y2);
+        wl_radius_.push_back((float)wl_params_[i].boxRadius);
+        wl_th_.push_back(wl_params_[i].th);
+    }
+}
+
+#if CV_SIMD128
+// Lanes where the box difference is below the threshold scaled by the box area,
+// compared with the same arithmetic as the scalar code
+static inline v_int32x4 v_belowThreshold(const v_int32x4 &response, const v_int32x4 &area, const int *th)
+{
+    return v_le(response, v_mul(v_load(th), area));
+}
+
+static inline v_int32x4 v_belowThreshold(const v_int32x4 &response, const v_int32x4 &area, const float *th)
+{
+    return v_reinterpret_as_s32(v_le(v_cvt_f32(response), v_mul(v_load(th), v_cvt_f32(area))));
 }
 
+// Descriptor of a keypoint whose boxes are all inside the image, 8 weak learners (one byte) at a time
+template<class WeakLearnerT>
+void BEBLID_Impl<WeakLearnerT>::computeBoxDiffsDescriptorSIMD(const int *integralPtr, int integralStep,
+                                                              const cv::KeyPoint &kp, uchar *d) const
+{
+    float m[6];
+    const float s = getRectification(kp, m, scale_factor_, patch_size_);
+    const v_float32x4 m00 = v_setall_f32(m[0]), m01 = v_setall_f32(m[1]), m02 = v_setall_f32(m[2]);
+    const v_float32x4 m10 = v_setall_f32(m[3]), m11 = v_setall_f32(m[4]), m12 = v_setall_f32(m[5]);
+    const v_float32x4 vs = v_setall_f32(s), half = v_setall_f32(0.5f);
+    const v_int32x4 step = v_setall_s32(integralStep), one = v_setall_s32(1);
+    const v_int32x4 bits[2] = { v_int32x4(128, 64, 32, 16), v_int32x4(8, 4, 2, 1) };
+    int CV_DECL_ALIGNED(16) idx[8][4];
+
+    for (size_t i = 0; i < wl_params_.size(); i += 8, d++)
+    {
+        v_int32x4 byte = v_setzero_s32();
+        for (int k = 0; k < 2; k++)
+        {
+            const size_t j = i + k * 4;
+            const v_float32x4 px1 = v_load(&wl_x1_[j]), py1 = v_load(&wl_y1_[j]);
+            const v_float32x4 px2 = v_load(&wl_x2_[j]), py2 = v_load(&wl_y2_[j]);
+
+            // Rectify the weak learners coordinates using the keypoint information
+            v_int32x4 x1 = v_trunc(v_add(v_add(v_add(v_mul(m00, px1), v_mul(m01, py1)), m02), half));
+            v_int32x4 y1 = v_trunc(v_add(v_add(v_add(v_mul(m10, px1), v_mul(m11, py1)), m12), half));
+            v_int32x4 x2 = v_trunc(v_add(v_add(v_add(v_mul(m00, px2), v_mul(m01, py2)), m02), half));
+            v_int32x4 y2 = v_trunc(v_add(v_add(v_add(v_mul(m10, px2), v_mul(m11, py2)), m12), half));
+            v_int32x4 r = v_trunc(v_add(v_mul(vs, v_load(&wl_radius_[j])), half));
+
+            // Offsets of the box corners in the integral image
+            v_int32x4 box1y1 = v_mul(v_sub(y1, r), step), box1y2 = v_mul(v_add(v_add(y1, r), one), step);
+            v_int32x4 box1x1 = v_sub(x1, r), box1x2 = v_add(v_add(x1, r), one);
+            v_int32x4 box2y1 = v_mul(v_sub(y2, r), step), box2y2 = v_mul(v_add(v_add(y2, r), one), step);
+            v_int32x4 box2x1 = v_sub(x2, r), box2x2 = v_add(v_add(x2, r), one);
+            v_store_aligned(idx[0], v_add(box1y1, box1x1));  // A of Box1
+            v_store_aligned(idx[1], v_add(box1y2, box1x2));  // D of Box1
+            v_store_aligned(idx[2], v_add(box1y1, box1x2));  // B of Box1
+            v_store_aligned(idx[3], v_add(box1y2, box1x1));  // C of Box1
+            v_store_aligned(idx[4], v_add(box2y1, box2x1));  // A of Box2
+            v_store_aligned(idx[5], v_add(box2y2, box2x2));  // D of Box2
+            v_store_aligned(idx[6], v_add(box2y1, box2x2));  // B of Box2
+            v_store_aligned(idx[7], v_add(box2y2, box2x1));  // C of Box2
+
+            // Get the difference between the average level of the two boxes
+            v_int32x4 response = v_sub(v_add(v_lut(integralPtr, idx[0]), v_lut(integralPtr, idx[1])),
+                                       v_add(v_lut(integralPtr, idx[2]), v_lut(integralPtr, idx[3])));
+            response = v_add(v_sub(response, v_add(v_lut(integralPtr, idx[4]), v_lut(integralPtr, idx[5]))),
+                             v_add(v_lut(integralPtr, idx[6]), v_lut(integralPtr, idx[7])));
+
+            v_int32x4 side = v_add(v_shl<1>(r), one);
+            byte = v_or(byte, v_and(v_belowThreshold(response, v_mul(side, side), &wl_th_[j]), bits[k]));
+        }
+        *d = (uchar)v_reduce_sum(byte);
+    }
+}
+#endif
+
 // Internal function that implements the core of BEBLID descriptor
 template<class WeakLearnerT>
 void BEBLID_Impl<WeakLearnerT>::computeBoxDiffsDescriptor(const cv::Mat &integralImg,
@@ -384,9 +494,19 @@ void BEBLID_Impl<WeakLearnerT>::computeBoxDiffsDescriptor(const cv::Mat &integra
 
         for (kpIdx = range.start; kpIdx < range.end; kpIdx++)
         {
+            const bool inTheBorder = isKeypointInTheBorder(keypoints[kpIdx], frameSize, patch_size_, scale_factor_);
+#if CV_SIMD128
+            if (!inTheBorder)
+            {
+                // Code to process the keypoints in the image center
+                computeBoxDiffsDescriptorSIMD(integralPtr, integralImg.cols, keypoints[kpIdx], d);
+                d += descriptorSize();
+                continue;
+            }
+#endif
             // Rectify the weak learners coordinates using the keypoint information
             rectifyABWL(wl_params_, imgWLParams, keypoints[kpIdx], scale_factor_, patch_size_);
-            if (isKeypointInTheBorder(keypoints[kpIdx], frameSize, patch_size_, scale_factor_))
+            if (inTheBorder)
             {
                 // Code to process the keypoints in the image margins
                 for (wlIdx = 0; wlIdx < wl_params_.size(); wlIdx++) {
@@ -95,6 +95,29 @@ public:
 
 
 private:
+    // Motion statistics of one grid type and scale.
+    // Only the non-zero cell pairs are kept: the matches from left cell i go to
+    // the right cells entries[cellStart[i]].first, ... entries[cellStart[i + 1] - 1].first
+    // (in increasing order), entries[k].second of them to each.
+    struct MotionStatistics
+    {
+        vector<int> cellStart;
+        vector<pair<int, int> > entries;
+        vector<int> numberPointsInPerCellLeft;
+
+        int count(const int left, const int right) const;
+    };
+
+    // Right grid of one scale
+    struct RightGrid
+    {
+        Size size;
+        Mat neighbor;
+
+        // Right cell of every match
+        vector<int> matchCells;
+    };
+
     // Normalized Points
     vector<Point2f> mvP1, mvP2;
 
@@ -105,45 +128,26 @@ private:
     size_t mNumberMatches;
 
     // Grid Size
-    Size mGridSizeLeft, mGridSizeRight;
+    Size mGridSizeLeft;
     int mGridNumberLeft;
-    int mGridNumberRight;
 
-    // x      : left grid idx
-    // y      : right grid idx
-    // value  : how many matches from idx_left to idx_right
-    Mat mMotionStatistics;
-
-    //
-    vector<int> mNumberPointsInPerCellLeft;
-
-    // Inldex  : grid_idx_left
-    // Value   : grid_idx_right
-    vector<int> mCellPairs;
-
-    // Every Matches has a cell-pair
-    // first  : grid_idx_left
-    // second : grid_idx_right
-    vector<pair<int, int> > mvMatchPairs;
-
-    // Inlier Mask for output
-    vector<bool> mvbInlierMask;
+    // Left cell of every match for each of the 4 grid types
+    vector<int> mvMatchCellsLeft[4];
 
     //
     Mat mGridNeighborLeft;
-    Mat mGridNeighborRight;
 
     double mThresholdFactor;
 
 
-    // Assign Matches to Cell Pairs
-    void assignMatchPairs(const int GridType);
+    // Build the motion statistics of the given left and right cells of the matches
+    void buildMotionStatistics(const vector<int> &cellsLeft, const vector<int> &cellsRight, MotionStatistics &stats) const;
 
     void convertMatches(const vector<DMatch> &vDMatches, vector<pair<int, int> > &vMatches);
 
-    int getGridIndexLeft(const Point2f &pt, const int type);
+    int getGridIndexLeft(const Point2f &pt, const int type) const;
 
-    int getGridIndexRight(const Point2f &pt);
+    int getGridIndexRight(const Point2f &pt, const Size &gridSizeRight) const;
 
     vector<int> getNB9(const int idx, const Size& GridSize);
 
@@ -152,37 +156,56 @@ private:
     void normalizePoints(const vector<KeyPoint> &kp, const Size &size, vector<Point2f> &npts);
 
     // Run
-    int run(const int rotationType);
+    int run(const int rotationType, const RightGrid &grid, const MotionStatistics *stats, vector<uchar> &inlierMask) const;
 
-    void setScale(const int scale);
+    void setScale(const int scale, RightGrid &grid);
 
     // Verify Cell Pairs
-    void verifyCellPairs(const int rotationType);
+    void verifyCellPairs(const int rotationType, const RightGrid &grid, const MotionStatistics &stats, vector<int> &cellPairs) const;
 };
 
-void GMSMatcher::assignMatchPairs(const int gridType)
+int GMSMatcher::MotionStatistics::count(const int left, const int right) const
+{
+    vector<pair<int, int> >::const_iterator begin = entries.begin() + cellStart[left], end = entries.begin() + cellStart[left + 1];
+    vector<pair<int, int> >::const_iterator it = lower_bound(begin, end, pair<int, int>(right, 0));
+    return it != end && it->first == right ? it->second : 0;
+}
+
+void GMSMatcher::buildMotionStatistics(const vector<int> &cellsLeft, const vector<int> &cellsRight, MotionStatistics &stats) const
 {
+    stats.numberPointsInPerCellLeft.assign(mGridNumberLeft, 0);
     for (size_t i = 0; i < mNumberMatches; i++)
     {
-        Point2f &lp = mvP1[mvMatches[i].first];
-        Point2f &rp = mvP2[mvMatches[i].second];
+        if (cellsLeft[i] < 0 || cellsRight[i] < 0) continue;
+        stats.numberPointsInPerCellLeft[cellsLeft[i]]++;
+    }
 
-        int lgidx = mvMatchPairs[i].first = getGridIndexLeft(lp, gridType);
-        int rgidx = -1;
+    // Bucket the right cells by left cell
+    vector<int> start(mGridNumberLeft + 1, 0);
+    for (int i = 0; i < mGridNumberLeft; i++)
+        start[i + 1] = start[i] + stats.numberPointsInPerCellLeft[i];
 
-        if (gridType == 1)
-        {
-            rgidx = mvMatchPairs[i].second = getGridIndexRight(rp);
-        }
-        else
+    vector<int> cells(start[mGridNumberLeft]), pos(start.begin(), start.end() - 1);
+    for (size_t i = 0; i < mNumberMatches; i++)
+    {
+        if (cellsLeft[i] < 0 || cellsRight[i] < 0) continue;
+        cells[pos[cellsLeft[i]]++] = cellsRight[i];
+    }
+
+    // Count the matches of every cell pair
+    stats.cellStart.assign(mGridNumberLeft + 1, 0);
+    stats.entries.clear();
+    for (int i = 0; i < mGridNumberLeft; i++)
+    {
+        sort(cells.begin() + start[i], cells.begin() + start[i + 1]);
+        for (int k = start[i]; k < start[i + 1]; k++)
         {
-            rgidx = mvMatchPairs[i].second;
+            if (k > start[i] && cells[k] == cells[k - 1])
+                stats.entries.back().second++;
+            else
+                stats.entries.push_back(pair<int, int>(cells[k], 1));
         }
-
-        if (lgidx < 0 || rgidx < 0) continue;
-
-        mMotionStatistics.at<int>(lgidx, rgidx)++;
-        mNumberPointsInPerCellLeft[lgidx]++;
+        stats.cellStart[i + 1] = (int)stats.entries.size();
     }
 }
 
@@ -194,7 +217,7 @@ void GMSMatcher::convertMatches(const vector<DMatch> &vDMatches, vector<pair<int
         vMatches[i] = pair<int, int>(vDMatches[i].queryIdx, vDMatches[i].trainIdx);
 }
 
-int GMSMatcher::getGridIndexLeft(const Point2f &pt, const int type)
+int GMSMatcher::getGridIndexLeft(const Point2f &pt, const int type) const
 {
     int x = 0, y = 0;
 
@@ -225,78 +248,63 @@ int GMSMatcher::getGridIndexLeft(const Point2f &pt, const int type)
     return x + y * mGridSizeLeft.width;
 }
 
-int GMSMatcher::getGridIndexRight(const Point2f &pt)
+int GMSMatcher::getGridIndexRight(const Point2f &pt, const Size &gridSizeRight) const
 {
-    int x = cvFloor(pt.x * mGridSizeRight.width);
-    int y = cvFloor(pt.y * mGridSizeRight.height);
+    int x = cvFloor(pt.x * gridSizeRight.width);
+    int y = cvFloor(pt.y * gridSizeRight.height);
 
-    return x + y * mGridSizeRight.width;
+    return x + y * gridSizeRight.width;
 }
 
 int GMSMatcher::getInlierMask(vector<bool> &vbInliers, const bool withRotation, const bool withScale)
 {
-    int max_inlier = 0;
+    const int numScales = withScale ? 5 : 1;
+    const int numRotations = withRotation ? 8 : 1;
 
-    if (!withScale && !withRotation)
+    // The left cells depend on the grid type only, the right ones on the scale only,
+    // so every (scale, grid type) statistics is shared by all the rotation types
+    for (int gridType = 1; gridType <= 4; gridType++)
     {
-        setScale(0);
-        max_inlier = run(1);
-        vbInliers = mvbInlierMask;
-        return max_inlier;
+        vector<int> &cells = mvMatchCellsLeft[gridType - 1];
+        cells.resize(mNumberMatches);
+        for (size_t i = 0; i < mNumberMatches; i++)
+            cells[i] = getGridIndexLeft(mvP1[mvMatches[i].first], gridType);
     }
 
-    if (withRotation && withScale)
-    {
-        for (int scale = 0; scale < 5; scale++)
+    vector<RightGrid> grids(numScales);
+    for (int scale = 0; scale < numScales; scale++)
+        setScale(scale, grids[scale]);
+
+    vector<MotionStatistics> stats(numScales * 4);
+    parallel_for_(Range(0, numScales * 4), [&](const Range& range) {
+        for (int k = range.start; k < range.end; k++)
+            buildMotionStatistics(mvMatchCellsLeft[k % 4], grids[k / 4].matchCells, stats[k]);
+    });
+
+    // Evaluate all the hypotheses, then keep the first one with the most inliers
+    const int numHypotheses = numScales * numRotations;
+    vector<vector<uchar> > inlierMasks(numHypotheses);
+    vector<int> numInliers(numHypotheses);
+    parallel_for_(Range(0, numHypotheses), [&](const Range& range) {
+        for (int k = range.start; k < range.end; k++)
         {
-            setScale(scale);
-            for (int rotationType = 1; rotationType <= 8; rotationType++)
-            {
-                int num_inlier = run(rotationType);
-
-                if (num_inlier > max_inlier)
-                {
-                    vbInliers = mvbInlierMask;
-                    max_inlier = num_inlier;
-                }
-            }
+            const int scale = k / numRotations, rotationType = k % numRotations + 1;
+            numInliers[k] = run(rotationType, grids[scale], &stats[scale * 4], inlierMasks[k]);
         }
-        return max_inlier;
-    }
+    });
 
-    if (withRotation && !withScale)
+    int max_inlier = 0, best = -1;
+    for (int k = 0; k < numHypotheses; k++)
     {
-        setScale(0);
-        for (int rotationType = 1; rotationType <= 8; rotationType++)
+        if (numInliers[k] > max_inlier || (!withScale && !withRotation))
         {
-            int num_inlier = run(rotationType);
-
-            if (num_inlier > max_inlier)
-            {
-                vbInliers = mvbInlierMask;
-                max_inlier = num_inlier;
-            }
+            max_inlier = numInliers[k];
+            best = k;
         }
-        return max_inlier;
-    }
-
-    if (!withRotation && withScale)
-    {
-        for (int scale = 0; scale < 5; scale++)
-        {
-            setScale(scale);
-            int num_inlier = run(1);
-
-            if (num_inlier > max_inlier)
-            {
-                vbInliers = mvbInlierMask;
-                max_inlier = num_inlier;
-            }
-
-        }
-        return max_inlier;
     }
 
+    if (best >= 0)
+        vbInliers.assign(inlierMasks[best].begin(), inlierMasks[best].end());
     return max_inlier;
 }
 
@@ -349,74 +357,69 @@ void GMSMatcher::normalizePoints(const vector<KeyPoint> &kp, const Size &size, v
     }
 }
 
-int GMSMatcher::run(const int rotationType)
+int GMSMatcher::run(const int rotationType, const RightGrid &grid, const MotionStatistics *stats, vector<uchar> &inlierMask) const
 {
-    mvbInlierMask.assign(mNumberMatches, false);
-
-    // Initialize Motion Statisctics
-    mMotionStatistics = Mat::zeros(mGridNumberLeft, mGridNumberRight, CV_32SC1);
-    mvMatchPairs.assign(mNumberMatches, pair<int, int>(0, 0));
+    inlierMask.assign(mNumberMatches, (uchar)0);
+    vector<int> cellPairs;
 
     for (int gridType = 1; gridType <= 4; gridType++)
     {
-        // initialize
-        mMotionStatistics.setTo(0);
-        mCellPairs.assign(mGridNumberLeft, -1);
-        mNumberPointsInPerCellLeft.assign(mGridNumberLeft, 0);
+        const vector<int> &cellsLeft = mvMatchCellsLeft[gridType - 1];
 
-        assignMatchPairs(gridType);
-        verifyCellPairs(rotationType);
+        verifyCellPairs(rotationType, grid, stats[gridType - 1], cellPairs);
 
         // Mark inliers
         for (size_t i = 0; i < mNumberMatches; i++)
         {
-            if (mvMatchPairs[i].first >= 0 && mCellPairs[mvMatchPairs[i].first] == mvMatchPairs[i].second)
-                mvbInlierMask[i] = true;
+            if (cellsLeft[i] >= 0 && cellPairs[cellsLeft[i]] == grid.matchCells[i])
+                inlierMask[i] = 1;
         }
     }
 
-    return (int) count(mvbInlierMask.begin(), mvbInlierMask.end(), true); //number of inliers
+    return (int) count(inlierMask.begin(), inlierMask.end(), (uchar)1); //number of inliers
 }
 
-void GMSMatcher::setScale(const int scale)
+void GMSMatcher::setScale(const int scale, RightGrid &grid)
 {
     // Set Scale
-    mGridSizeRight.width = cvRound(mGridSizeLeft.width  * mScaleRatios[scale]);
-    mGridSizeRight.height = cvRound(mGridSizeLeft.height * mScaleRatios[scale]);
-    mGridNumberRight = mGridSizeRight.width * mGridSizeRight.height;
+    grid.size.width = cvRound(mGridSizeLeft.width  * mScaleRatios[scale]);
+    grid.size.height = cvRound(mGridSizeLeft.height * mScaleRatios[scale]);
 
     // Initialize the neighbor of right grid
-    mGridNeighborRight = Mat::zeros(mGridNumberRight, 9, CV_32SC1);
-    initalizeNeighbors(mGridNeighborRight, mGridSizeRight);
+    grid.neighbor = Mat::zeros(grid.size.area(), 9, CV_32SC1);
+    initalizeNeighbors(grid.neighbor, grid.size);
+
+    grid.matchCells.resize(mNumberMatches);
+    for (size_t i = 0; i < mNumberMatches; i++)
+        grid.matchCells[i] = getGridIndexRight(mvP2[mvMatches[i].second], grid.size);
 }
 
-void GMSMatcher::verifyCellPairs(const int rotationType)
+void GMSMatcher::verifyCellPairs(const int rotationType, const RightGrid &grid, const MotionStatistics &stats, vector<int> &cellPairs) const
 {
     const int *CurrentRP = mRotationPatterns[rotationType - 1];
 
+    cellPairs.assign(mGridNumberLeft, -1);
+
     for (int i = 0; i < mGridNumberLeft; i++)
     {
-        if (sum(mMotionStatistics.row(i))[0] == 0)
-        {
-            mCellPairs[i] = -1;
+        if (stats.cellStart[i] == stats.cellStart[i + 1])
             continue;
-        }
 
+        // the first right cell with the most matches
         int max_number = 0;
-        for (int j = 0; j < mGridNumberRight; j++)
+        for (int k = stats.cellStart[i]; k < stats.cellStart[i + 1]; k++)
         {
-            int *value = mMotionStatistics.ptr<int>(i);
-            if (value[j] > max_number)
+            if (stats.entries[k].second > max_number)
             {
-                mCellPairs[i] = j;
-                max_number = value[j];
+                cellPairs[i] = stats.entries[k].first;
+                max_number = stats.entries[k].second;
             }
         }
 
-        int idx_grid_rt = mCellPairs[i];
+        int idx_grid_rt = cellPairs[i];
 
         const int *NB9_lt = mGridNeighborLeft.ptr<int>(i);
-        const int *NB9_rt = mGridNeighborRight.ptr<int>(idx_grid_rt);
+        const int *NB9_rt = grid.neighbor.ptr<int>(idx_grid_rt);
 
         int score = 0;
         double thresh = 0;
@@ -429,15 +432,15 @@ void GMSMatcher::verifyCellPairs(const int rotationType)
             if (ll == -1 || rr == -1)
                 continue;
 
-            score += mMotionStatistics.at<int>(ll, rr);
-            thresh += mNumberPointsInPerCellLeft[ll];
+            score += stats.count(ll, rr);
+            thresh += stats.numberPointsInPerCellLeft[ll];
             numpair++;
         }
 
         thresh = mThresholdFactor * std::sqrt(thresh / numpair);
 
         if (score < thresh)
-            mCellPairs[i] = -2;
+            cellPairs[i] = -2;
     }
 }
 
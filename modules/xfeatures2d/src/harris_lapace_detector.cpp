@@ -3,6 +3,7 @@
 // of this distribution and at http://opencv.org/license.html
 
 #include "precomp.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 
 namespace {
 
@@ -13,6 +14,100 @@ bool sort_func(KeyPoint kp1, KeyPoint kp2)
     return (kp1.response > kp2.response);
 }
 
+/*
+ * Products of the derivatives normalized by sd: Lxm2 = (sd*Lx)^2, Lym2 = (sd*Ly)^2, Lxmy = (sd*Lx)*(sd*Ly)
+ */
+void calcDerivativesProducts(const Mat& Lx, const Mat& Ly, float sd, Mat& Lxm2, Mat& Lym2, Mat& Lxmy)
+{
+    Lxm2.create(Lx.size(), CV_32F);
+    Lym2.create(Lx.size(), CV_32F);
+    Lxmy.create(Lx.size(), CV_32F);
+
+    parallel_for_(Range(0, Lx.rows), [&](const Range& range)
+    {
+        for (int row = range.start; row < range.end; row++)
+        {
+            const float* lx_ptr = Lx.ptr<float>(row);
+            const float* ly_ptr = Ly.ptr<float>(row);
+            float* xx_ptr = Lxm2.ptr<float>(row);
+            float* yy_ptr = Lym2.ptr<float>(row);
+            float* xy_ptr = Lxmy.ptr<float>(row);
+            int col = 0;
+#if CV_SIMD128
+            v_float32x4 v_sd = v_setall_f32(sd);
+            for (; col <= Lx.cols - v_float32x4::nlanes; col += v_float32x4::nlanes)
+            {
+                v_float32x4 lx = v_mul(v_load(lx_ptr + col), v_sd);
+                v_float32x4 ly = v_mul(v_load(ly_ptr + col), v_sd);
+                v_store(xx_ptr + col, v_mul(lx, lx));
+                v_store(yy_ptr + col, v_mul(ly, ly));
+                v_store(xy_ptr + col, v_mul(lx, ly));
+            }
+#endif
+            for (; col < Lx.cols; col++)
+            {
+                float lx = lx_ptr[col] * sd;
+                float ly = ly_ptr[col] * sd;
+                xx_ptr[col] = lx * lx;
+                yy_ptr[col] = ly * ly;
+                xy_ptr[col] = lx * ly;
+            }
+        }
+    }, Lx.total() / (double)(1 << 16));
+}
+
+/*
+ * Calculates cornerness det - 0.04 * tr^2 of the second moment matrix in each pixel of the image
+ * Returns the max cornerness value
+ */
+double calcCornerness(const Mat& dx2, const Mat& dy2, const Mat& dxy, Mat& cornern_mat)
+{
+    cornern_mat.create(dx2.size(), CV_32F);
+    std::vector<float> rowMax(dx2.rows);
+
+    parallel_for_(Range(0, dx2.rows), [&](const Range& range)
+    {
+        for (int row = range.start; row < range.end; row++)
+        {
+            const float* dx2_ptr = dx2.ptr<float>(row);
+            const float* dy2_ptr = dy2.ptr<float>(row);
+            const float* dxy_ptr = dxy.ptr<float>(row);
+            float* corn_ptr = cornern_mat.ptr<float>(row);
+            float maxVal = -FLT_MAX;
+            int col = 0;
+#if CV_SIMD128
+            v_float32x4 v_k = v_setall_f32(0.04f), v_maxVal = v_setall_f32(-FLT_MAX);
+            for (; col <= dx2.cols - v_float32x4::nlanes; col += v_float32x4::nlanes)
+            {
+                v_float32x4 dx2f = v_load(dx2_ptr + col);
+                v_float32x4 dy2f = v_load(dy2_ptr + col);
+                v_float32x4 dxyf = v_load(dxy_ptr + col);
+                v_float32x4 det = v_sub(v_mul(dx2f, dy2f), v_mul(dxyf, dxyf));
+                v_float32x4 tr = v_add(dx2f, dy2f);
+                v_float32x4 cornerness = v_sub(det, v_mul(v_mul(v_k, tr), tr));
+                v_store(corn_ptr + col, cornerness);
+                v_maxVal = v_max(v_maxVal, cornerness);
+            }
+            maxVal = v_reduce_max(v_maxVal);
+#endif
+            for (; col < dx2.cols; col++)
+            {
+                float dx2f = dx2_ptr[col];
+                float dy2f = dy2_ptr[col];
+                float dxyf = dxy_ptr[col];
+                float det = dx2f * dy2f - dxyf * dxyf;
+                float tr = dx2f + dy2f;
+                float cornerness = det - (0.04f * tr * tr);
+                corn_ptr[col] = cornerness;
+                maxVal = std::max(maxVal, cornerness);
+            }
+            rowMax[row] = maxVal;
+        }
+    }, dx2.total() / (double)(1 << 16));
+
+    return *std::max_element(rowMax.begin(), rowMax.end());
+}
+
 class Pyramid
 {
 
@@ -40,6 +135,7 @@ private:
     std::vector<Octave> octaves;
     std::vector<DOGOctave> DOG_octaves;
     void build(const Mat& img, bool DOG);
+    void buildDOG();
 public:
     class Params
     {
@@ -107,7 +203,7 @@ void Pyramid::build(const Mat& img, bool DOG)
     int octave, layer;
     double sigmaN = 0.5;
 
-    std::vector<Mat> layers, DOG_layers;
+    std::vector<Mat> layers;
     /* standard deviation of current layer*/
     float sigma_curr = sigma;
     /* standard deviation of previous layer*/
@@ -127,30 +223,17 @@ void Pyramid::build(const Mat& img, bool DOG)
         {
             sigma_curr = getSigma(layer);
             sigma = sqrt(powf(sigma_curr, 2) - powf(sigma_prev, 2));
-            Mat prev_lay = layers[layer - 1], curr_lay, DOG_lay;
+            Mat prev_lay = layers[layer - 1], curr_lay;
             /* smoothing is applied on previous layer so sigma_curr^2 = sigma^2 + sigma_prev^2 */
             gsize = int(ceil(sigma * 3)) * 2 + 1;
             GaussianBlur(prev_lay, curr_lay, Size(gsize,gsize), sigma);
             layers.push_back(curr_lay);
-            if (DOG)
-            {
-                absdiff(curr_lay, prev_lay, DOG_lay);
-                DOG_layers.push_back(DOG_lay);
-            }
             sigma_prev = sigma_curr;
 
         }
         Octave tmp_oct(layers);
         octaves.push_back(tmp_oct);
         layers.clear();
-
-        if (DOG)
-        {
-            DOGOctave tmp_DOG_Oct(DOG_layers);
-            DOG_octaves.push_back(tmp_DOG_Oct);
-            DOG_layers.clear();
-        }
-
     }
 
     /* Presmoothing on first layer */
@@ -175,16 +258,10 @@ void Pyramid::build(const Mat& img, bool DOG)
             sigma_curr = getSigma(layer);
             sigma = sqrt(powf(sigma_curr, 2) - powf(sigma_prev, 2));
 
-            Mat prev_lay = layers[layer - 1], curr_lay, DOG_lay;
+            Mat prev_lay = layers[layer - 1], curr_lay;
             gsize = int(ceil(sigma * 3)) * 2 + 1;
             GaussianBlur(prev_lay, curr_lay, Size(gsize,gsize), sigma);
             layers.push_back(curr_lay);
-
-            if (DOG)
-            {
-                absdiff(curr_lay, prev_lay, DOG_lay);
-                DOG_layers.push_back(DOG_lay);
-            }
             sigma_prev = sigma_curr;
         }
 
@@ -193,18 +270,42 @@ void Pyramid::build(const Mat& img, bool DOG)
 
         Octave tmp_oct(layers);
         octaves.push_back(tmp_oct);
-        if (DOG)
-        {
-            DOGOctave tmp_DOG_Oct(DOG_layers);
-            DOG_octaves.push_back(tmp_DOG_Oct);
-            DOG_layers.clear();
-        }
         sigma_curr = sigma_prev = sigma0;
         layers.clear();
         layers.push_back(resized_lay);
 
     }
 
+    if (DOG)
+        buildDOG();
+}
+
+/**
+ * Build DOG pyramid from the gaussian one
+ * each layer is computed by its own, so all of them are done in parallel
+ * (smoothing is chained from layer to layer and is already parallel inside GaussianBlur)
+ */
+void Pyramid::buildDOG()
+{
+    std::vector<Point> DOG_index;
+    DOG_octaves.clear();
+    for (int octave = 0; octave < (int) octaves.size(); octave++)
+    {
+        int layersN = (int) octaves[octave].layers.size();
+        DOG_octaves.push_back(DOGOctave(std::vector<Mat>(layersN - 1)));
+        for (int layer = 1; layer < layersN; layer++)
+            DOG_index.push_back(Point(layer, octave));
+    }
+
+    parallel_for_(Range(0, (int) DOG_index.size()), [&](const Range& range)
+    {
+        for (int i = range.start; i < range.end; i++)
+        {
+            const std::vector<Mat>& layers = octaves[DOG_index[i].y].layers;
+            int layer = DOG_index[i].x;
+            absdiff(layers[layer], layers[layer - 1], DOG_octaves[DOG_index[i].y].layers[layer - 1]);
+        }
+    });
 }
 
 /**
@@ -480,12 +581,8 @@ void HarrisLaplaceFeatureDetector_Impl::detect(InputArray img, std::vector<KeyPo
             Sobel(curr_layer, Ly, CV_32F, 0, 1, 1);
 
             /*Normalization*/
-            Lx = Lx * sd;
-            Ly = Ly * sd;
-
-            Mat Lxm2 = Lx.mul(Lx);
-            Mat Lym2 = Ly.mul(Ly);
-            Mat Lxmy = Lx.mul(Ly);
+            Mat Lxm2, Lym2, Lxmy;
+            calcDerivativesProducts(Lx, Ly, sd, Lxm2, Lym2, Lxmy);
 
             gsize = int(ceil(si * 3)) * 2 + 1;
 
@@ -494,28 +591,13 @@ void HarrisLaplaceFeatureDetector_Impl::detect(InputArray img, std::vector<KeyPo
             GaussianBlur(Lym2, Lym2smooth, Size(gsize, gsize), si, si, BORDER_REPLICATE);
             GaussianBlur(Lxmy, Lxmysmooth, Size(gsize, gsize), si, si, BORDER_REPLICATE);
 
-            Mat cornern_mat(curr_layer.size(), CV_32F);
-
-            /*Calculates cornerness in each pixel of the image*/
-            for (int row = 0; row < curr_layer.rows; row++)
-            {
-                for (int col = 0; col < curr_layer.cols; col++)
-                {
-                    float dx2f = Lxm2smooth.at<float> (row, col);
-                    float dy2f = Lym2smooth.at<float> (row, col);
-                    float dxyf = Lxmysmooth.at<float> (row, col);
-                    float det = dx2f * dy2f - dxyf * dxyf;
-                    float tr = dx2f + dy2f;
-                    float cornerness = det - (0.04f * tr * tr);
-                    cornern_mat.at<float> (row, col) = cornerness;
-                }
-            }
+            Mat cornern_mat;
 
-            double maxVal = 0;
+            /*Calculates cornerness in each pixel of the image and its max value*/
+            double maxVal = calcCornerness(Lxm2smooth, Lym2smooth, Lxmysmooth, cornern_mat);
             Mat corn_dilate;
 
-            /*Find max cornerness value and rejects all corners that are lower than a threshold*/
-            minMaxLoc(cornern_mat, 0, &maxVal, 0, 0);
+            /*Rejects all corners that are lower than a threshold*/
             threshold(cornern_mat, cornern_mat, maxVal * corn_thresh, 0, THRESH_TOZERO);
             dilate(cornern_mat, corn_dilate, Mat());
 
@@ -527,43 +609,53 @@ void HarrisLaplaceFeatureDetector_Impl::detect(InputArray img, std::vector<KeyPo
             curDOG = pyr.getDOGLayer(octave, layer);
             succDOG = pyr.getDOGLayer(octave, layer + 1);
 
-            for (int y = 1; y < imgsize.height - 1; y++)
+            std::vector<std::vector<KeyPoint> > row_keypoints(imgsize.height);
+            parallel_for_(Range(1, std::max(imgsize.height - 1, 1)), [&](const Range& range)
             {
-                for (int x = 1; x < imgsize.width - 1; x++)
+                for (int y = range.start; y < range.end; y++)
                 {
-                    float val = cornern_mat.at<float> (y, x);
-                    if (val != 0 && val == corn_dilate.at<float> (y, x))
+                    const float* corn_ptr = cornern_mat.ptr<float>(y);
+                    const float* dilate_ptr = corn_dilate.ptr<float>(y);
+                    for (int x = 1; x < imgsize.width - 1; x++)
                     {
+                        float val = corn_ptr[x];
+                        if (val != 0 && val == dilate_ptr[x])
+                        {
 
-                        float curVal = curDOG.at<float> (y, x);
-                        float prevVal =  prevDOG.at<float> (y, x);
-                        float succVal = succDOG.at<float> (y, x);
+                            float curVal = curDOG.at<float> (y, x);
+                            float prevVal =  prevDOG.at<float> (y, x);
+                            float succVal = succDOG.at<float> (y, x);
 
-                        KeyPoint kp(
-                                Point2f(x * powf(2.0f, (float) octave - 1) + powf(2.0f, (float) octave - 1) / 2,
-                                        y * powf(2.0f, (float) octave - 1) + powf(2.0f, (float) octave - 1) / 2),
-                                3 * powf(2.0f, (float) octave - 1) * si * 2, 0, val, octave);
+                            KeyPoint kp(
+                                    Point2f(x * powf(2.0f, (float) octave - 1) + powf(2.0f, (float) octave - 1) / 2,
+                                            y * powf(2.0f, (float) octave - 1) + powf(2.0f, (float) octave - 1) / 2),
+                                    3 * powf(2.0f, (float) octave - 1) * si * 2, 0, val, octave);
 
-                        if(!mask.empty() && mask.at<unsigned char>(int(kp.pt.y), int(kp.pt.x)) == 0)
-                        {
-                            // ignore keypoints where mask is zero
-                            continue;
-                        }
+                            if(!mask.empty() && mask.at<unsigned char>(int(kp.pt.y), int(kp.pt.x)) == 0)
+                            {
+                                // ignore keypoints where mask is zero
+                                continue;
+                            }
 
-                        /*Check whether keypoint size is inside the image*/
-                        float start_kp_x = kp.pt.x - kp.size / 2;
-                        float start_kp_y = kp.pt.y - kp.size / 2;
-                        float end_kp_x = start_kp_x + kp.size;
-                        float end_kp_y = start_kp_y + kp.size;
+                            /*Check whether keypoint size is inside the image*/
+                            float start_kp_x = kp.pt.x - kp.size / 2;
+                            float start_kp_y = kp.pt.y - kp.size / 2;
+                            float end_kp_x = start_kp_x + kp.size;
+                            float end_kp_y = start_kp_y + kp.size;
 
-                        if (curVal > prevVal && curVal > succVal && curVal >= DOG_thresh
-                                && start_kp_x > 0 && start_kp_y > 0 && end_kp_x < image.cols
-                                && end_kp_y < image.rows)
-                            keypoints.push_back(kp);
+                            if (curVal > prevVal && curVal > succVal && curVal >= DOG_thresh
+                                    && start_kp_x > 0 && start_kp_y > 0 && end_kp_x < image.cols
+                                    && end_kp_y < image.rows)
+                                row_keypoints[y].push_back(kp);
 
+                        }
                     }
                 }
-            }
+            }, curr_layer.total() / (double)(1 << 16));
+
+            /*Keep the keypoints in raster order whatever the split among threads*/
+            for (int y = 1; y < imgsize.height - 1; y++)
+                keypoints.insert(keypoints.end(), row_keypoints[y].begin(), row_keypoints[y].end());
 
         }
 
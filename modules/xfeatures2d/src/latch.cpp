@@ -44,6 +44,7 @@
 //M*/
 
 #include "precomp.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 #include <algorithm>
 #include <vector>
 
@@ -110,218 +111,97 @@ namespace cv
         void CalcuateSums(int count, const std::vector<int> &points, bool rotationInvariance, const Mat &grayImage, const KeyPoint &pt, int &suma, int &sumc, float cos_theta, float sin_theta, int half_ssd_size);
 
 
-        static void pixelTests1(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size)
+        template <int bytes>
+        static void pixelTests(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size)
         {
             Mat descriptors = _descriptors.getMat();
-            for (int i = 0; i < (int)keypoints.size(); ++i)
+            parallel_for_(Range(0, (int)keypoints.size()), [&](const Range& range)
             {
-                uchar* desc = descriptors.ptr(i);
-                const KeyPoint& pt = keypoints[i];
-                int count = 0;
-
-                //handling keypoint orientation
-                float angle = pt.angle;
-                angle *= (float)(CV_PI / 180.f);
-                float cos_theta = cos(angle);
-                float sin_theta = sin(angle);
-                for (int ix = 0; ix < 1; ix++){
-                    desc[ix] = 0;
-                    for (int j = 7; j >= 0; j--){
-
-                        int suma = 0;
-                        int sumc = 0;
-
-                        CalcuateSums(count, points, rotationInvariance, grayImage, pt, suma, sumc, cos_theta, sin_theta, half_ssd_size);
-                        desc[ix] += (uchar)((suma < sumc) << j);
-
-                        count += 6;
+                for (int i = range.start; i < range.end; ++i)
+                {
+                    uchar* desc = descriptors.ptr(i);
+                    const KeyPoint& pt = keypoints[i];
+                    int count = 0;
+
+                    //handling keypoint orientation
+                    float angle = pt.angle;
+                    angle *= (float)(CV_PI / 180.f);
+                    float cos_theta = cos(angle);
+                    float sin_theta = sin(angle);
+                    for (int ix = 0; ix < bytes; ix++){
+                        desc[ix] = 0;
+                        for (int j = 7; j >= 0; j--){
+
+                            int suma = 0;
+                            int sumc = 0;
+
+                            CalcuateSums(count, points, rotationInvariance, grayImage, pt, suma, sumc, cos_theta, sin_theta, half_ssd_size);
+                            desc[ix] += (uchar)((suma < sumc) << j);
+
+                            count += 6;
+                        }
                     }
                 }
-            }
+            });
         }
 
-
-        static void pixelTests2(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size)
+        // SSD between the (2K+1)x(2K+1) patches around a and b, and between the ones around c and b
+        static inline void patchSSD(const Mat& grayImage, int ax, int ay, int bx, int by, int cx, int cy, int K, int& suma, int& sumc)
         {
-            Mat descriptors = _descriptors.getMat();
-            for (int i = 0; i < (int)keypoints.size(); ++i)
+#if CV_SIMD128
+            const int len = 2 * K + 1;
+            // the last load of a row may read past the patch, so make sure it stays inside the image row
+            if (std::max(ax, std::max(bx, cx)) - K + ((len + 7) & ~7) <= grayImage.cols)
             {
-                uchar* desc = descriptors.ptr(i);
-                const KeyPoint& pt = keypoints[i];
-                int count = 0;
-
-                //handling keypoint orientation
-                float angle = pt.angle;
-                angle *= (float)(CV_PI / 180.f);
-                float cos_theta = cos(angle);
-                float sin_theta = sin(angle);
-                for (int ix = 0; ix < 2; ix++){
-                    desc[ix] = 0;
-                    for (int j = 7; j >= 0; j--){
-
-                        int suma = 0;
-                        int sumc = 0;
-
-                        CalcuateSums(count, points, rotationInvariance, grayImage, pt, suma, sumc, cos_theta, sin_theta, half_ssd_size);
-                        desc[ix] += (uchar)((suma < sumc) << j);
-
-                        count += 6;
-                    }
-                }
-            }
-        }
+                static const short maskTab[16] = { -1, -1, -1, -1, -1, -1, -1, -1, 0, 0, 0, 0, 0, 0, 0, 0 };
+                const int tail = len & 7;
+                const v_int16x8 tailMask = v_load(maskTab + 8 - tail);
+                v_int32x4 sa = v_setzero_s32(), sc = v_setzero_s32();
 
-
-        static void pixelTests4(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size)
-        {
-            Mat descriptors = _descriptors.getMat();
-            for (int i = 0; i < (int)keypoints.size(); ++i)
-            {
-                uchar* desc = descriptors.ptr(i);
-                const KeyPoint& pt = keypoints[i];
-                int count = 0;
-
-                //handling keypoint orientation
-                float angle = pt.angle;
-                angle *= (float)(CV_PI / 180.f);
-                float cos_theta = cos(angle);
-                float sin_theta = sin(angle);
-                for (int ix = 0; ix < 4; ix++){
-                    desc[ix] = 0;
-                    for (int j = 7; j >= 0; j--){
-
-                        int suma = 0;
-                        int sumc = 0;
-
-                        CalcuateSums(count, points, rotationInvariance, grayImage, pt, suma, sumc, cos_theta, sin_theta, half_ssd_size);
-                        desc[ix] += (uchar)((suma < sumc) << j);
-
-                        count += 6;
+                for (int iy = -K; iy <= K; iy++)
+                {
+                    const uchar * Mi_a = grayImage.ptr<uchar>(ay + iy) + ax - K;
+                    const uchar * Mi_b = grayImage.ptr<uchar>(by + iy) + bx - K;
+                    const uchar * Mi_c = grayImage.ptr<uchar>(cy + iy) + cx - K;
+                    int ix = 0;
+
+                    for (; ix <= len - 8; ix += 8)
+                    {
+                        v_int16x8 b = v_reinterpret_as_s16(v_load_expand(Mi_b + ix));
+                        v_int16x8 difa = v_sub(v_reinterpret_as_s16(v_load_expand(Mi_a + ix)), b);
+                        v_int16x8 difc = v_sub(v_reinterpret_as_s16(v_load_expand(Mi_c + ix)), b);
+                        sa = v_add(sa, v_dotprod(difa, difa));
+                        sc = v_add(sc, v_dotprod(difc, difc));
                     }
-                }
-            }
-        }
-
-
-
-        static void pixelTests8(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size)
-        {
-            Mat descriptors = _descriptors.getMat();
-            for (int i = 0; i < (int)keypoints.size(); ++i)
-            {
-                uchar* desc = descriptors.ptr(i);
-                const KeyPoint& pt = keypoints[i];
-                int count = 0;
-
-                //handling keypoint orientation
-                float angle = pt.angle;
-                angle *= (float)(CV_PI / 180.f);
-                float cos_theta = cos(angle);
-                float sin_theta = sin(angle);
-                for (int ix = 0; ix < 8; ix++){
-                    desc[ix] = 0;
-                    for (int j = 7; j >= 0; j--){
-
-                        int suma = 0;
-                        int sumc = 0;
-
-                        CalcuateSums(count, points, rotationInvariance, grayImage, pt, suma, sumc, cos_theta, sin_theta, half_ssd_size);
-                        desc[ix] += (uchar)((suma < sumc) << j);
-
-                        count += 6;
+                    if (tail)
+                    {
+                        v_int16x8 b = v_reinterpret_as_s16(v_load_expand(Mi_b + ix));
+                        v_int16x8 difa = v_and(v_sub(v_reinterpret_as_s16(v_load_expand(Mi_a + ix)), b), tailMask);
+                        v_int16x8 difc = v_and(v_sub(v_reinterpret_as_s16(v_load_expand(Mi_c + ix)), b), tailMask);
+                        sa = v_add(sa, v_dotprod(difa, difa));
+                        sc = v_add(sc, v_dotprod(difc, difc));
                     }
                 }
-            }
-        }
-
 
-        static void pixelTests16(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size)
-        {
-            Mat descriptors = _descriptors.getMat();
-            for (int i = 0; i < (int)keypoints.size(); ++i)
-            {
-                uchar* desc = descriptors.ptr(i);
-                const KeyPoint& pt = keypoints[i];
-                int count = 0;
-
-                //handling keypoint orientation
-                float angle = pt.angle;
-                angle *= (float)(CV_PI / 180.f);
-                float cos_theta = cos(angle);
-                float sin_theta = sin(angle);
-                for (int ix = 0; ix < 16; ix++){
-                    desc[ix] = 0;
-                    for (int j = 7; j >= 0; j--){
-
-                        int suma = 0;
-                        int sumc = 0;
-
-                        CalcuateSums(count, points, rotationInvariance, grayImage, pt, suma, sumc, cos_theta, sin_theta, half_ssd_size);
-                        desc[ix] += (uchar)((suma < sumc) << j);
-
-                        count += 6;
-                    }
-                }
+                suma += v_reduce_sum(sa);
+                sumc += v_reduce_sum(sc);
+                return;
             }
-        }
+#endif
 
-
-        static void pixelTests32(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size)
-        {
-            Mat descriptors = _descriptors.getMat();
-            for (int i = 0; i < (int)keypoints.size(); ++i)
+            for (int iy = -K; iy <= K; iy++)
             {
-                uchar* desc = descriptors.ptr(i);
-                const KeyPoint& pt = keypoints[i];
-                int count = 0;
-
-                float angle = pt.angle;
-                angle *= (float)(CV_PI / 180.f);
-                float cos_theta = cos(angle);
-                float sin_theta = sin(angle);
-                for (int ix = 0; ix < 32; ix++){
-                    desc[ix] = 0;
-                    for (int j = 7; j >= 0; j--){
-
-                        int suma = 0;
-                        int sumc = 0;
-
-                        CalcuateSums(count, points, rotationInvariance, grayImage, pt, suma, sumc, cos_theta, sin_theta, half_ssd_size);
-                        desc[ix] += (uchar)((suma < sumc) << j);
-
-                        count += 6;
-                    }
-                }
-            }
-        }
+                const uchar * Mi_a = grayImage.ptr<uchar>(ay + iy);
+                const uchar * Mi_b = grayImage.ptr<uchar>(by + iy);
+                const uchar * Mi_c = grayImage.ptr<uchar>(cy + iy);
 
+                for (int ix = -K; ix <= K; ix++)
+                {
+                    int difa = Mi_a[ax + ix] - Mi_b[bx + ix];
+                    suma += difa * difa;
 
-        static void pixelTests64(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size)
-        {
-            Mat descriptors = _descriptors.getMat();
-            for (int i = 0; i < (int)keypoints.size(); ++i)
-            {
-                uchar* desc = descriptors.ptr(i);
-                const KeyPoint& pt = keypoints[i];
-                int count = 0;
-
-                //handling keypoint orientation
-                float angle = pt.angle;
-                angle *= (float)(CV_PI / 180.f);
-                float cos_theta = cos(angle);
-                float sin_theta = sin(angle);
-                for (int ix = 0; ix < 64; ix++){
-                    desc[ix] = 0;
-                    for (int j = 7; j >= 0; j--){
-
-                        int suma = 0;
-                        int sumc = 0;
-
-                        CalcuateSums(count, points, rotationInvariance, grayImage, pt, suma, sumc, cos_theta, sin_theta, half_ssd_size);
-                        desc[ix] += (uchar)((suma < sumc) << j);
-
-                        count += 6;
-                    }
+                    int difc = Mi_c[cx + ix] - Mi_b[bx + ix];
+                    sumc += difc * difc;
                 }
             }
         }
@@ -399,23 +279,7 @@ namespace cv
             cy2 += (int)(pt.pt.y + 0.5);
 
 
-            int K = half_ssd_size;
-            for (int iy = -K; iy <= K; iy++)
-            {
-                const uchar * Mi_a = grayImage.ptr<uchar>(ay2 + iy);
-                const uchar * Mi_b = grayImage.ptr<uchar>(by2 + iy);
-                const uchar * Mi_c = grayImage.ptr<uchar>(cy2 + iy);
-
-                for (int ix = -K; ix <= K; ix++)
-                {
-                    double difa = Mi_a[ax2 + ix] - Mi_b[bx2 + ix];
-                    suma += (int)((difa)*(difa));
-
-                    double difc = Mi_c[cx2 + ix] - Mi_b[bx2 + ix];
-                    sumc += (int)((difc)*(difc));
-                }
-            }
-
+            patchSSD(grayImage, ax2, ay2, bx2, by2, cx2, cy2, half_ssd_size, suma, sumc);
         }
 
 
@@ -425,25 +289,25 @@ namespace cv
           switch (bytes)
           {
           case 1:
-              test_fn_ = pixelTests1;
+              test_fn_ = pixelTests<1>;
               break;
           case 2:
-              test_fn_ = pixelTests2;
+              test_fn_ = pixelTests<2>;
               break;
           case 4:
-              test_fn_ = pixelTests4;
+              test_fn_ = pixelTests<4>;
               break;
           case 8:
-              test_fn_ = pixelTests8;
+              test_fn_ = pixelTests<8>;
               break;
           case 16:
-              test_fn_ = pixelTests16;
+              test_fn_ = pixelTests<16>;
               break;
           case 32:
-              test_fn_ = pixelTests32;
+              test_fn_ = pixelTests<32>;
               break;
           case 64:
-              test_fn_ = pixelTests64;
+              test_fn_ = pixelTests<64>;
               break;
           default:
               CV_Error(Error::StsBadArg, "descriptorSize must be 1,2, 4, 8, 16, 32, or 64");
@@ -78,7 +78,19 @@ class TBMR_Impl CV_FINAL : public TBMR
                      OutputArray descriptors,
                      bool useProvidedKeypoints = false) CV_OVERRIDE;
 
-    CV_INLINE uint zfindroot(uint *parent, uint p)
+    // component tree representation (parent,S): see
+    // https://ieeexplore.ieee.org/document/6850018
+    struct ComponentTree
+    {
+        Mat parent;
+        Mat S;
+        // moments: compound type of: (area, x, y, xy, xx, yy)
+        Mat imaAttributes;
+        // max tree if S is ascending, min tree if S is descending
+        bool maxTree;
+    };
+
+    static CV_INLINE uint zfindroot(uint *parent, uint p)
     {
         if (parent[p] == p)
             return p;
@@ -86,38 +98,103 @@ class TBMR_Impl CV_FINAL : public TBMR
             return parent[p] = zfindroot(parent, parent[p]);
     }
 
-    // Calculate the Component tree. Based on the order of S, it will be a
-    // min or max tree.
-    void calcMinMaxTree(Mat ima)
+    // Sort the pixels by increasing gray level, keeping the raster order of
+    // the pixels with the same level. S gets the order of the whole image,
+    // bandS the order of each band of rows, each in the slice of the band.
+    static void sortPixels(const Mat &ima, const std::vector<int> &bandRows,
+                           Mat &S, Mat &bandS)
     {
-        int rs = ima.rows;
+        int nbands = (int)bandRows.size() - 1;
         int cs = ima.cols;
-        uint imSize = (uint)rs * cs;
+        S.create(1, (int)ima.total(), CV_32S);
+        bandS.create(1, (int)ima.total(), CV_32S);
+        const uchar *ima_ptr = ima.ptr<const uchar>();
+        uint *S_ptr = S.ptr<uint>();
+        uint *bandS_ptr = bandS.ptr<uint>();
+        std::vector<std::array<uint, 256>> hist(nbands);
+
+        // counting sort of each band
+        parallel_for_(Range(0, nbands), [&](const Range &range) {
+            for (int b = range.start; b < range.end; b++)
+            {
+                uint begin = (uint)bandRows[b] * cs;
+                uint end = (uint)bandRows[b + 1] * cs;
+                std::array<uint, 256> &h = hist[b];
+                h.fill(0);
+                for (uint p = begin; p < end; p++)
+                    h[ima_ptr[p]]++;
+                std::array<uint, 256> offset;
+                uint sum = begin;
+                for (int v = 0; v < 256; v++)
+                {
+                    offset[v] = sum;
+                    sum += h[v];
+                }
+                for (uint p = begin; p < end; p++)
+                    bandS_ptr[offset[ima_ptr[p]]++] = p;
+            }
+        });
+
+        // the bands are in raster order, so the image order of each level is
+        // the concatenation of the ones of the bands
+        std::vector<std::array<uint, 256>> offset(nbands);
+        uint sum = 0;
+        for (int v = 0; v < 256; v++)
+            for (int b = 0; b < nbands; b++)
+            {
+                offset[b][v] = sum;
+                sum += hist[b][v];
+            }
+
+        parallel_for_(Range(0, nbands), [&](const Range &range) {
+            for (int b = range.start; b < range.end; b++)
+            {
+                const uint *src = bandS_ptr + (size_t)bandRows[b] * cs;
+                for (int v = 0; v < 256; v++)
+                {
+                    memcpy(S_ptr + offset[b][v], src, hist[b][v] * sizeof(uint));
+                    src += hist[b][v];
+                }
+            }
+        });
+    }
+
+    // buffers of the union-find, one element per pixel
+    struct UnionFind
+    {
+        uint *zpar, *root, *rank;
+        bool *dejaVu;
+    };
+
+    // Calculate the Component tree of the rows [r0, r1) of the image. Based
+    // on the order of bandS, it will be a min or max tree.
+    static void calcBandTree(const Mat &ima, ComponentTree &tree,
+                             const UnionFind &uf, const uint *bandS, int r0,
+                             int r1)
+    {
+        int cs = ima.cols;
+        uint bandSize = (uint)(r1 - r0) * cs;
+        bandS += (size_t)r0 * cs;
 
         std::array<int, 4> offsets = {
             -ima.cols, -1, 1, ima.cols
         }; // {-1,0}, {0,-1}, {0,1}, {1,0} yx
         std::array<Vec2i, 4> offsetsv = { Vec2i(0, -1), Vec2i(-1, 0),
                                           Vec2i(1, 0), Vec2i(0, 1) }; //  xy
-        AutoBuffer<uint> zparb(imSize);
-        AutoBuffer<uint> rootb(imSize);
-        AutoBuffer<uint> rankb(imSize);
-        memset(rankb.data(), 0, imSize * sizeof(uint));
-        uint* zpar = zparb.data();
-        uint *root = rootb.data();
-        uint *rank = rankb.data();
-        parent = Mat(rs, cs, CV_32S); // unsigned
-        AutoBuffer<bool> dejaVub(imSize);
-        memset(dejaVub.data(), 0, imSize * sizeof(bool));
-        bool* dejaVu = dejaVub.data();
-
-        const uint *S_ptr = S.ptr<const uint>();
-        uint *parent_ptr = parent.ptr<uint>();
-        Vec<uint, 6> *imaAttribute = imaAttributes.ptr<Vec<uint, 6>>();
-
-        for (int i = imSize - 1; i >= 0; --i)
+        uint *zpar = uf.zpar;
+        uint *root = uf.root;
+        uint *rank = uf.rank;
+        bool *dejaVu = uf.dejaVu;
+        memset(rank + (size_t)r0 * cs, 0, bandSize * sizeof(uint));
+        memset(dejaVu + (size_t)r0 * cs, 0, bandSize * sizeof(bool));
+
+        const uint8_t *ima_ptr = ima.ptr<const uint8_t>();
+        uint *parent_ptr = tree.parent.ptr<uint>();
+        Vec<uint, 6> *imaAttribute = tree.imaAttributes.ptr<Vec<uint, 6>>();
+
+        for (uint i = 0; i < bandSize; ++i)
         {
-            uint p = S_ptr[i];
+            uint p = tree.maxTree ? bandS[bandSize - 1 - i] : bandS[i];
 
             Vec2i idx_p(p % cs, p / cs);
             // make set
@@ -141,8 +218,8 @@ class TBMR_Impl CV_FINAL : public TBMR
 
                 Vec2i q_idx = idx_p + offsetsv[k];
                 bool inBorder = q_idx[0] >= 0 && q_idx[0] < ima.cols &&
-                                q_idx[1] >= 0 &&
-                                q_idx[1] < ima.rows; // filter out border cases
+                                q_idx[1] >= r0 &&
+                                q_idx[1] < r1; // filter out border cases
 
                 if (inBorder && dejaVu[q]) // remove first check
                                            // obsolete
@@ -152,15 +229,7 @@ class TBMR_Impl CV_FINAL : public TBMR
                     {
                         parent_ptr[root[r]] = p;
                         // accumulate information
-                        imaAttribute[p][0] += imaAttribute[root[r]][0]; // area
-                        imaAttribute[p][1] += imaAttribute[root[r]][1]; // sum_x
-                        imaAttribute[p][2] += imaAttribute[root[r]][2]; // sum_y
-                        imaAttribute[p][3] +=
-                            imaAttribute[root[r]][3]; // sum_xy
-                        imaAttribute[p][4] +=
-                            imaAttribute[root[r]][4]; // sum_xx
-                        imaAttribute[p][5] +=
-                            imaAttribute[root[r]][5]; // sum_yy
+                        imaAttribute[p] += imaAttribute[root[r]];
 
                         if (rank[x] < rank[r])
                         {
@@ -184,29 +253,183 @@ class TBMR_Impl CV_FINAL : public TBMR
                 }
             }
         }
+
+        // canonization, so that each pixel points to the first pixel of its
+        // level component (the node), and each node to its parent node
+        for (uint i = 0; i < bandSize; ++i)
+        {
+            uint p = tree.maxTree ? bandS[i] : bandS[bandSize - 1 - i];
+            uint q = parent_ptr[p];
+            if (ima_ptr[parent_ptr[q]] == ima_ptr[q])
+                parent_ptr[p] = parent_ptr[q];
+        }
+    }
+
+    // node of the pixel x, i.e. the first pixel of its level component
+    static CV_INLINE uint levelRoot(const uint8_t *ima_ptr, uint *parent_ptr,
+                                    uint x)
+    {
+        uint r = x;
+        while (parent_ptr[r] != r && ima_ptr[parent_ptr[r]] == ima_ptr[r])
+            r = parent_ptr[r];
+        while (parent_ptr[x] != r && x != r)
+        {
+            uint next = parent_ptr[x];
+            parent_ptr[x] = r;
+            x = next;
+        }
+        return r;
     }
 
-    void calculateTBMRs(const Mat &image, std::vector<Elliptic_KeyPoint> &tbmrs,
-                        const Mat &mask, float scale, int octave)
+    // Merge the component trees containing the neighbor pixels p and q: the
+    // ancestors of both are interleaved by level, each node getting the
+    // moments of the nodes of the other branch that are now below it.
+    // Nodes of the same level are fused, keeping the pixel that comes first
+    // in S, so that the result is the same as if the tree had been built at
+    // once.
+    static void connect(const Mat &ima, ComponentTree &tree, uint p, uint q)
+    {
+        const uint NONE = std::numeric_limits<uint>::max();
+        const uint8_t *ima_ptr = ima.ptr<const uint8_t>();
+        uint *parent_ptr = tree.parent.ptr<uint>();
+        Vec<uint, 6> *imaAttribute = tree.imaAttributes.ptr<Vec<uint, 6>>();
+        const bool maxTree = tree.maxTree;
+
+        auto up = [&](uint n) {
+            return parent_ptr[n] == n ? NONE
+                                      : levelRoot(ima_ptr, parent_ptr, parent_ptr[n]);
+        };
+        // is node a below node b in the tree
+        auto below = [&](uint a, uint b) {
+            return maxTree ? ima_ptr[a] > ima_ptr[b] : ima_ptr[a] < ima_ptr[b];
+        };
+
+        uint x = levelRoot(ima_ptr, parent_ptr, p);
+        uint y = levelRoot(ima_ptr, parent_ptr, q);
+        // moments of the other branch to add to x and y
+        Vec<uint, 6> ax, ay;
+        uint prev = NONE;
+
+        while (x != y)
+        {
+            uint n;
+            if (y == NONE || (x != NONE && below(x, y)))
+            {
+                Vec<uint, 6> oldx = imaAttribute[x];
+                imaAttribute[x] += ax;
+                ay = oldx;
+                n = x;
+                x = up(x);
+            }
+            else if (x == NONE || below(y, x))
+            {
+                Vec<uint, 6> oldy = imaAttribute[y];
+                imaAttribute[y] += ay;
+                ax = oldy;
+                n = y;
+                y = up(y);
+            }
+            else
+            {
+                // same level, fuse the two nodes
+                Vec<uint, 6> oldx = imaAttribute[x], oldy = imaAttribute[y];
+                uint zx = up(x), zy = up(y);
+                n = (maxTree ? x < y : x > y) ? x : y;
+                parent_ptr[n == x ? y : x] = n;
+                imaAttribute[n] = oldx + oldy;
+                ax = oldy;
+                ay = oldx;
+                x = zx;
+                y = zy;
+            }
+            if (prev != NONE)
+                parent_ptr[prev] = n;
+            prev = n;
+        }
+        if (prev != NONE)
+            parent_ptr[prev] = x == NONE ? prev : x;
+    }
+
+    // Calculate the max tree and the min tree of the image, each band of rows
+    // in parallel, then merge the bands along their borders
+    void calcMinMaxTrees(const Mat &ima)
+    {
+        int rs = ima.rows;
+        int cs = ima.cols;
+        uint imSize = (uint)rs * cs;
+
+        int nbands = std::max(1, std::min(rs / 16, getNumThreads()));
+        std::vector<int> bandRows(nbands + 1);
+        for (int b = 0; b <= nbands; b++)
+            bandRows[b] = (int)((int64)rs * b / nbands);
+
+        Mat bandS;
+        sortPixels(ima, bandRows, trees[0].S, bandS);
+        flip(trees[0].S, trees[1].S, -1);
+
+        for (int t = 0; t < 2; t++)
+        {
+            ComponentTree &tree = trees[t];
+            tree.maxTree = t == 0;
+            tree.parent.create(rs, cs, CV_32S); // unsigned
+            tree.imaAttributes.create(rs, cs, CV_32SC(6));
+        }
+
+        AutoBuffer<uint> zparb(2 * (size_t)imSize), rootb(2 * (size_t)imSize),
+            rankb(2 * (size_t)imSize);
+        AutoBuffer<bool> dejaVub(2 * (size_t)imSize);
+        UnionFind uf[2];
+        for (int t = 0; t < 2; t++)
+        {
+            uf[t].zpar = zparb.data() + (size_t)t * imSize;
+            uf[t].root = rootb.data() + (size_t)t * imSize;
+            uf[t].rank = rankb.data() + (size_t)t * imSize;
+            uf[t].dejaVu = dejaVub.data() + (size_t)t * imSize;
+        }
+
+        const uint *bandS_ptr = bandS.ptr<const uint>();
+        parallel_for_(Range(0, 2 * nbands), [&](const Range &range) {
+            for (int i = range.start; i < range.end; i++)
+            {
+                int b = i % nbands;
+                calcBandTree(ima, trees[i / nbands], uf[i / nbands], bandS_ptr,
+                             bandRows[b], bandRows[b + 1]);
+            }
+        });
+
+        // merge pairs of adjacent groups of bands, the groups of a step
+        // being disjoint
+        for (int step = 1; step < nbands; step *= 2)
+        {
+            int ngroups = (nbands + 2 * step - 1) / (2 * step);
+            parallel_for_(Range(0, 2 * ngroups), [&](const Range &range) {
+                for (int i = range.start; i < range.end; i++)
+                {
+                    int b = (i % ngroups) * 2 * step + step;
+                    if (b >= nbands)
+                        continue;
+                    uint border = (uint)bandRows[b] * cs;
+                    for (uint p = border; p < border + cs; p++)
+                        connect(ima, trees[i / ngroups], p - cs, p);
+                }
+            });
+        }
+    }
+
+    void calculateTBMRs(const Mat &image, ComponentTree &tree,
+                        std::vector<Elliptic_KeyPoint> &tbmrs,
+                        const Mat &mask, float scale, int octave) const
     {
         uint imSize = image.cols * image.rows;
         uint maxArea =
             static_cast<uint>(params.maxAreaRelative * imSize * scale);
         uint minArea = static_cast<uint>(params.minArea * scale);
 
-        if (parent.empty() || parent.size != image.size)
-            parent = Mat(image.rows, image.cols, CV_32S);
-
-        if (imaAttributes.empty() || imaAttributes.size != image.size)
-            imaAttributes = Mat(image.rows, image.cols, CV_32SC(6));
-
-        calcMinMaxTree(image);
-
         const Vec<uint, 6> *imaAttribute =
-            imaAttributes.ptr<const Vec<uint, 6>>();
+            tree.imaAttributes.ptr<const Vec<uint, 6>>();
         const uint8_t *ima_ptr = image.ptr<const uint8_t>();
-        const uint *S_ptr = S.ptr<const uint>();
-        uint *parent_ptr = parent.ptr<uint>();
+        const uint *S_ptr = tree.S.ptr<const uint>();
+        uint *parent_ptr = tree.parent.ptr<uint>();
 
         // canonization
         for (uint i = 0; i < imSize; ++i)
@@ -453,12 +676,8 @@ class TBMR_Impl CV_FINAL : public TBMR
 
     Mat tempsrc;
 
-    // component tree representation (parent,S): see
-    // https://ieeexplore.ieee.org/document/6850018
-    Mat parent;
-    Mat S;
-    // moments: compound type of: (area, x, y, xy, xx, yy)
-    Mat imaAttributes;
+    // max tree and min tree
+    ComponentTree trees[2];
 
     Params params;
 };
@@ -523,14 +742,16 @@ void TBMR_Impl::detect(InputArray _image,
         float scale = ((float)s.cols) / pyr.begin()->cols;
         std::vector<Elliptic_KeyPoint> kpts;
 
-        // append max tree tbmrs
-        sortIdx(s.reshape(1, 1), S,
-                SortFlags::SORT_ASCENDING | SortFlags::SORT_EVERY_ROW);
-        calculateTBMRs(s, kpts, mask, scale, oct);
+        calcMinMaxTrees(s);
 
-        // reverse instead of sort
-        flip(S, S, -1);
-        calculateTBMRs(s, kpts, mask, scale, oct);
+        // max tree tbmrs, then min tree ones
+        std::vector<Elliptic_KeyPoint> treeKpts[2];
+        parallel_for_(Range(0, 2), [&](const Range &range) {
+            for (int t = range.start; t < range.end; t++)
+                calculateTBMRs(s, trees[t], treeKpts[t], mask, scale, oct);
+        });
+        kpts.insert(kpts.end(), treeKpts[0].begin(), treeKpts[0].end());
+        kpts.insert(kpts.end(), treeKpts[1].begin(), treeKpts[1].end());
 
         if (oct == 0)
         {
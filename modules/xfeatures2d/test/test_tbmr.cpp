@@ -0,0 +1,77 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#include "test_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+// The component trees are built over one band of rows per thread and then merged,
+// so the keypoints must not depend on the number of threads.
+static void detectTBMR(const Mat& image, int nthreads, std::vector<KeyPoint>& keypoints)
+{
+    int prevThreads = getNumThreads();
+    setNumThreads(nthreads);
+    Ptr<TBMR> tbmr = TBMR::create(10, 0.05f);
+    tbmr->detect(image, keypoints);
+    setNumThreads(prevThreads);
+}
+
+static void checkBandsMerge(const Mat& image)
+{
+    std::vector<KeyPoint> ref;
+    detectTBMR(image, 1, ref);
+
+    const int nthreads[] = { 2, 3, 5, 8 };
+    for (size_t i = 0; i < sizeof(nthreads) / sizeof(nthreads[0]); i++)
+    {
+        std::vector<KeyPoint> keypoints;
+        detectTBMR(image, nthreads[i], keypoints);
+
+        ASSERT_EQ(ref.size(), keypoints.size()) << "threads=" << nthreads[i];
+        for (size_t k = 0; k < ref.size(); k++)
+        {
+            EXPECT_EQ(ref[k].pt, keypoints[k].pt) << "threads=" << nthreads[i] << " k=" << k;
+            EXPECT_EQ(ref[k].size, keypoints[k].size) << "threads=" << nthreads[i] << " k=" << k;
+            EXPECT_EQ(ref[k].angle, keypoints[k].angle) << "threads=" << nthreads[i] << " k=" << k;
+            EXPECT_EQ(ref[k].octave, keypoints[k].octave) << "threads=" << nthreads[i] << " k=" << k;
+        }
+    }
+}
+
+static void skipIfSingleThreaded()
+{
+    int prevThreads = getNumThreads();
+    setNumThreads(2);
+    int nthreads = getNumThreads();
+    setNumThreads(prevThreads);
+    if (nthreads < 2)
+        throw SkipTestException("The trees are built in a single band without a parallel backend");
+}
+
+TEST(Features2d_TBMR, bands_merge_random)
+{
+    skipIfSingleThreaded();
+    Mat image(192, 160, CV_8UC1);
+    cvtest::randUni(TS::ptr()->get_rng(), image, Scalar::all(0), Scalar::all(256));
+    checkBandsMerge(image);
+}
+
+TEST(Features2d_TBMR, bands_merge_flat)
+{
+    skipIfSingleThreaded();
+    Mat image(192, 160, CV_8UC1, Scalar::all(128));
+    checkBandsMerge(image);
+}
+
+TEST(Features2d_TBMR, bands_merge_smooth)
+{
+    skipIfSingleThreaded();
+    Mat noise(192, 160, CV_8UC1), image;
+    cvtest::randUni(TS::ptr()->get_rng(), noise, Scalar::all(0), Scalar::all(256));
+    GaussianBlur(noise, image, Size(0, 0), 6.0);
+    normalize(image, image, 0, 255, NORM_MINMAX);
+    checkBandsMerge(image);
+}
+
+}} // namespace
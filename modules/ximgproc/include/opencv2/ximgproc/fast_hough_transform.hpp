@@ -136,6 +136,37 @@ CV_EXPORTS_W void FastHoughTransform( InputArray  src,
                                       int         op = FHT_ADD,
                                       int         makeSkew = HDO_DESKEW );
 
+/**
+* @brief   Calculates 2D Fast Hough transforms of a sequence of images.
+*
+* The class computes the same transform as cv::ximgproc::FastHoughTransform, but
+* keeps its intermediate images between calls, so that repeated transforms of
+* images with the same size and type do not reallocate them. An instance must
+* not be used from several threads at once.
+*/
+class CV_EXPORTS_W FastHoughTransformer : public Algorithm
+{
+public:
+    /**
+    * @brief   Calculates 2D Fast Hough transform of an image.
+    * @param   src         The source (input) image.
+    * @param   dst         The destination image, result of transformation.
+    */
+    CV_WRAP virtual void apply(InputArray src, OutputArray dst) = 0;
+};
+
+/**
+* @brief   Creates a FastHoughTransformer instance.
+* @param   dstMatDepth The depth of destination image
+* @param   angleRange  The part of Hough space to calculate, see cv::AngleRangeOption
+* @param   op          The operation to be applied, see cv::HoughOp
+* @param   makeSkew    Specifies to do or not to do image skewing, see cv::HoughDeskewOption
+*/
+CV_EXPORTS_W Ptr<FastHoughTransformer> createFastHoughTransformer( int dstMatDepth,
+                                                                   int angleRange = ARO_315_135,
+                                                                   int op = FHT_ADD,
+                                                                   int makeSkew = HDO_DESKEW );
+
 /**
 * @brief   Calculates coordinates of line segment corresponded by point in Hough space.
 * @param   houghPoint  Point in Hough space.
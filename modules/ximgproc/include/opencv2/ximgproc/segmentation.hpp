@@ -226,6 +226,9 @@ namespace cv {
 
                             /** @brief Add a new strategy in the list of strategy to process.
                                 @param s The strategy
+
+                                Built-in strategies are run concurrently by process() when no strategy, or sub-strategy,
+                                is shared between them. Otherwise, or if a custom strategy is added, they are run one after the other.
                             */
                             CV_WRAP virtual void addStrategy(Ptr<SelectiveSearchSegmentationStrategy> s) = 0;
 
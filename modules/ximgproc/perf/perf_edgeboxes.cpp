@@ -0,0 +1,67 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace  {
+
+typedef tuple<Size, int> EdgeBoxesTestParam;
+typedef TestBaseWithParam<EdgeBoxesTestParam> EdgeBoxesTest;
+
+// Edge and orientation maps of random blurred shapes, in the format of StructuredEdgeDetection
+static void makeEdgeMaps(Size sz, Mat &edges, Mat &orientations)
+{
+    RNG rng(0);
+    Mat img(sz, CV_8UC1, Scalar::all(0));
+    for (int i = 0; i < 40; i++)
+    {
+        Point p1(rng.uniform(0, sz.width), rng.uniform(0, sz.height));
+        Point p2(rng.uniform(0, sz.width), rng.uniform(0, sz.height));
+        Scalar color = Scalar::all(rng.uniform(64, 256));
+        if (i % 2)
+            rectangle(img, p1, p2, color, FILLED);
+        else
+            circle(img, p1, rng.uniform(8, std::max(9, sz.height / 6)), color, FILLED);
+    }
+    GaussianBlur(img, img, Size(5, 5), 1.5);
+
+    Mat dx, dy;
+    Sobel(img, dx, CV_32F, 1, 0);
+    Sobel(img, dy, CV_32F, 0, 1);
+    magnitude(dx, dy, edges);
+    normalize(edges, edges, 0, 1, NORM_MINMAX);
+
+    orientations.create(sz, CV_32F);
+    for (int y = 0; y < sz.height; y++)
+    {
+        const float *dx_ptr = dx.ptr<float>(y), *dy_ptr = dy.ptr<float>(y);
+        float *o_ptr = orientations.ptr<float>(y);
+        for (int x = 0; x < sz.width; x++)
+        {
+            float o = std::atan2(dy_ptr[x], dx_ptr[x]);
+            o_ptr[x] = o < 0 ? o + (float)CV_PI : o;
+        }
+    }
+}
+
+PERF_TEST_P(EdgeBoxesTest, perf, Combine(Values(sz480p, sz720p), Values(100, 1000)))
+{
+    EdgeBoxesTestParam params = GetParam();
+    Size sz = get<0>(params);
+    int maxBoxes = get<1>(params);
+
+    Mat edges, orientations;
+    makeEdgeMaps(sz, edges, orientations);
+
+    Ptr<EdgeBoxes> edgeboxes = createEdgeBoxes();
+    edgeboxes->setMaxBoxes(maxBoxes);
+
+    std::vector<Rect> boxes;
+    std::vector<float> scores;
+
+    TEST_CYCLE() edgeboxes->getBoundingBoxes(edges, orientations, boxes, scores);
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
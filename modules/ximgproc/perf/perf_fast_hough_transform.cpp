@@ -76,6 +76,34 @@ PERF_TEST_P(srcSize_srcType_dstDepth, FastHoughTransform,
     SANITY_CHECK_NOTHING();
 }
 
+PERF_TEST_P(srcSize_srcType_dstDepth, FastHoughTransformer,
+            testing::Combine(
+                testing::Values(TYPICAL_MAT_SIZES),
+                testing::Values(TYPICAL_MAT_TYPES),
+                testing::Values(ALL_MAT_DEPHTS)
+                )
+            )
+{
+    Size srcSize  = get<0>(GetParam());
+    int  srcType  = get<1>(GetParam());
+    int  dstDepth = get<2>(GetParam());
+
+    Mat src(srcSize, srcType);
+    Mat fht;
+
+    declare.in(src, WARMUP_RNG);
+
+    Ptr<FastHoughTransformer> transformer = createFastHoughTransformer(dstDepth);
+    transformer->apply(src, fht);
+
+    TEST_CYCLE_N(3)
+    {
+        transformer->apply(src, fht);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
 #undef ALL_MAT_DEPHTS
 
 }} // namespace
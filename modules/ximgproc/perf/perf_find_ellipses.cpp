@@ -24,4 +24,29 @@ PERF_TEST_P(FindEllipsesTest, perf, Combine(SZ_TYPICAL, Values(CV_8U), Values(1,
 
     SANITY_CHECK_NOTHING();
 }
+
+PERF_TEST_P(FindEllipsesTest, synthetic_ellipses, Combine(SZ_TYPICAL, Values(CV_8U), Values(1)))
+{
+    FindEllipsesTestParam params = GetParam();
+    Size sz = get<0>(params);
+    int matType = get<1>(params);
+    int srcCn = get<2>(params);
+
+    // a few dozens of ellipses on a flat background, closer to real inspection images than noise
+    Mat src(sz, CV_MAKE_TYPE(matType, srcCn), Scalar::all(32));
+    RNG rng(0);
+    for (int i = 0; i < 24; i++)
+    {
+        Point center(rng.uniform(0, sz.width), rng.uniform(0, sz.height));
+        Size axes(rng.uniform(8, std::max(9, sz.width / 8)), rng.uniform(8, std::max(9, sz.height / 8)));
+        ellipse(src, center, axes, rng.uniform(0., 180.), 0, 360, Scalar::all(rng.uniform(96, 256)), 2);
+    }
+    Mat dst(sz, CV_32FC(6));
+
+    declare.in(src).out(dst);
+
+    TEST_CYCLE() findEllipses(src, dst, 0.7f, 0.5f, 0.05f);
+
+    SANITY_CHECK_NOTHING();
+}
 }} // namespace
\ No newline at end of file
@@ -0,0 +1,37 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+typedef tuple<Size, MatType> GraphSegmentationPerfTestParam;
+typedef perf::TestBaseWithParam<GraphSegmentationPerfTestParam> GraphSegmentationPerfTest;
+
+PERF_TEST_P(GraphSegmentationPerfTest, perf,
+    testing::Combine(
+        testing::Values(sz480p, sz720p),
+        testing::Values(CV_8UC1, CV_8UC3)
+    )
+)
+{
+    Size srcSize = get<0>(GetParam());
+    int  srcType = get<1>(GetParam());
+
+    Mat src(srcSize, srcType);
+    Mat dst;
+
+    declare.in(src, WARMUP_RNG);
+
+    Ptr<ximgproc::segmentation::GraphSegmentation> gs = ximgproc::segmentation::createGraphSegmentation();
+
+    TEST_CYCLE()
+    {
+        gs->processImage(src, dst);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
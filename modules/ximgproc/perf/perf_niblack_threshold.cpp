@@ -0,0 +1,30 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+typedef tuple<Size, int, int> NiblackTestParam;
+typedef TestBaseWithParam<NiblackTestParam> NiblackThresholdTest;
+
+PERF_TEST_P(NiblackThresholdTest, perf,
+            Combine(Values(sz1080p, Size(2480, 3508)), Values(15, 51),
+                    Values((int)BINARIZATION_NIBLACK, (int)BINARIZATION_SAUVOLA, (int)BINARIZATION_WOLF, (int)BINARIZATION_NICK)))
+{
+    NiblackTestParam params = GetParam();
+    Size sz = get<0>(params);
+    int blockSize = get<1>(params);
+    int method = get<2>(params);
+
+    Mat src(sz, CV_8UC1);
+    Mat dst(sz, CV_8UC1);
+
+    declare.in(src, WARMUP_RNG).out(dst);
+
+    TEST_CYCLE() niBlackThreshold(src, dst, 255, THRESH_BINARY, blockSize, 0.2, method, 128);
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
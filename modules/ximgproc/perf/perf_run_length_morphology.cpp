@@ -33,5 +33,29 @@ PERF_TEST_P(RLMorphologyPerfTest, perf, Combine(Values(1,7, 21), Values(sz720p,
     SANITY_CHECK_NOTHING();
 }
 
+typedef TestBaseWithParam<Size> RLThresholdPerfTest;
+
+PERF_TEST_P(RLThresholdPerfTest, page, Values(sz2160p, Size(4960, 7016)))
+{
+    Size sz = GetParam();
+
+    // a white page with lines of dark "characters", like a scanned document
+    Mat src(sz, CV_8U, Scalar::all(235));
+    RNG rng(0);
+    for (int y = 40; y < sz.height - 60; y += 60)
+        for (int x = 40; x < sz.width - 40; x += rng.uniform(20, 40))
+            rectangle(src, Rect(x, y + rng.uniform(0, 10), rng.uniform(4, 16), rng.uniform(20, 40)), Scalar::all(20), FILLED);
+    Mat thresholded, dstRLE;
+    Mat se = rl::getStructuringElement(MORPH_RECT, cv::Size(5, 5));
+
+    TEST_CYCLE_N(4)
+    {
+        rl::threshold(src, thresholded, 128.0, THRESH_BINARY_INV);
+        rl::morphologyEx(thresholded, dstRLE, MORPH_CLOSE, se);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
 }
 } // namespace
\ No newline at end of file
@@ -0,0 +1,78 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+typedef TestBaseWithParam<Size> SuperpixelsPerfTest;
+
+static const int regionSize = 16;
+
+// Blurred random shapes, so that superpixel boundaries have something to follow
+static Mat makeImage(Size sz)
+{
+    RNG rng(0);
+    Mat img(sz, CV_8UC3, Scalar::all(128));
+    for (int i = 0; i < 60; i++)
+    {
+        Point p1(rng.uniform(0, sz.width), rng.uniform(0, sz.height));
+        Point p2(rng.uniform(0, sz.width), rng.uniform(0, sz.height));
+        Scalar color(rng.uniform(0, 256), rng.uniform(0, 256), rng.uniform(0, 256));
+        if (i % 2)
+            rectangle(img, p1, p2, color, FILLED);
+        else
+            circle(img, p1, rng.uniform(8, std::max(9, sz.height / 6)), color, FILLED);
+    }
+    GaussianBlur(img, img, Size(5, 5), 1.5);
+    cvtColor(img, img, COLOR_BGR2Lab);
+    return img;
+}
+
+PERF_TEST_P(SuperpixelsPerfTest, SEEDS, Values(sz480p, sz720p))
+{
+    Size sz = GetParam();
+    Mat img = makeImage(sz);
+    int numSuperpixels = sz.area() / (regionSize * regionSize);
+
+    Ptr<ximgproc::SuperpixelSEEDS> seeds =
+        ximgproc::createSuperpixelSEEDS(sz.width, sz.height, img.channels(), numSuperpixels, 4);
+
+    TEST_CYCLE()
+    {
+        seeds->iterate(img, 4);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+PERF_TEST_P(SuperpixelsPerfTest, SLIC, Values(sz480p, sz720p))
+{
+    Size sz = GetParam();
+    Mat img = makeImage(sz);
+
+    TEST_CYCLE()
+    {
+        Ptr<ximgproc::SuperpixelSLIC> slic = ximgproc::createSuperpixelSLIC(img, ximgproc::SLICO, regionSize);
+        slic->iterate(10);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+PERF_TEST_P(SuperpixelsPerfTest, LSC, Values(sz480p, sz720p))
+{
+    Size sz = GetParam();
+    Mat img = makeImage(sz);
+
+    TEST_CYCLE()
+    {
+        Ptr<ximgproc::SuperpixelLSC> lsc = ximgproc::createSuperpixelLSC(img, regionSize);
+        lsc->iterate(10);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
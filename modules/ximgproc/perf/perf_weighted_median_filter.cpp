@@ -44,5 +44,31 @@ PERF_TEST_P(WeightedMedianFilterTest, perf,
     SANITY_CHECK_NOTHING();
 }
 
+typedef tuple<Size, int> WMFLargeRadiusTestParam;
+typedef TestBaseWithParam<WMFLargeRadiusTestParam> WeightedMedianFilterLargeRadiusTest;
+
+PERF_TEST_P(WeightedMedianFilterLargeRadiusTest, perf,
+    Combine(
+    Values(sz720p, sz1080p),
+    Values(10, 20))
+)
+{
+    Size sz = get<0>(GetParam());
+    int r   = get<1>(GetParam());
+
+    Mat joint(sz, CV_8UC1);
+    Mat src(sz, CV_32FC1);
+    Mat dst(sz, src.type());
+
+    declare.in(joint, src, WARMUP_RNG).out(dst);
+
+    TEST_CYCLE_N(1)
+    {
+        weightedMedianFilter(joint, src, dst, r, 25.0, WMF_EXP);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
 
 }} // namespace
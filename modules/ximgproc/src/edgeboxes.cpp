@@ -160,18 +160,23 @@ private:
     vector<float> _scaleNorm;
     float _sxStep, _ayStep, _xyStepRatio;
 
-    // data structures for efficiency (see scoreBox)
-    Mat _sWts;
-    Mat _sDone, _sMap, _sIds;
-    int _sId;
+    // data structures for efficiency (see scoreBox), one set per thread
+    struct ScoreBuffers
+    {
+        vector<float> sWts;
+        vector<int> sDone, sMap, sIds;
+        int sId;
+
+        explicit ScoreBuffers(int n) : sWts(n, 0), sDone(n, -1), sMap(n, 0), sIds(n, 0), sId(0) {}
+    };
 
     // helper routines
     static bool boxesCompare(const Box &a, const Box &b) { return a.score < b.score; }
     void clusterEdges(Mat &edgeMap, Mat &orientationMap);
     void prepDataStructs(Mat &edgeMap);
     void scoreAllBoxes(Boxes &boxes);
-    void scoreBox(Box &box);
-    void refineBox(Box &box);
+    void scoreBox(Box &box, ScoreBuffers &buf) const;
+    void refineBox(Box &box, ScoreBuffers &buf) const;
     float boxesOverlap(Box &a, Box &b);
     void boxesNms(Boxes &boxes, float thr, float eta, int maxBoxes);
 };
@@ -561,25 +566,17 @@ void EdgeBoxesImpl::prepDataStructs(Mat &edgeMap)
             _vIdxImg.at<int>(x, y) = (int)_vIdxs[x].size() - 1;
         }
     }
-
-    // initialize scoreBox() data structures
-    int n = _segCnt + 1;
-    _sWts = Mat::zeros(n, 1, DataType<float>::type);
-    _sDone = Mat(n, 1, DataType<int>::type,Scalar(-1));
-    _sMap = Mat::zeros(n, 1, DataType<int>::type);
-    _sIds = Mat::zeros(n, 1, DataType<int>::type);
-    _sId = 0;
 }
 
 
-void EdgeBoxesImpl::scoreBox(Box &box)
+void EdgeBoxesImpl::scoreBox(Box &box, ScoreBuffers &buf) const
 {
     int i, j, k, q, bh, bw, y0, x0, y1, x1, y0m, y1m, x0m, x1m;
-    float *sWts = (float *)_sWts.data;
-    int *sDone = (int *)_sDone.data;
-    int *sMap = (int *)_sMap.data;
-    int *sIds = (int *)_sIds.data;
-    int sId = _sId++;
+    float *sWts = &buf.sWts[0];
+    int *sDone = &buf.sDone[0];
+    int *sMap = &buf.sMap[0];
+    int *sIds = &buf.sIds[0];
+    int sId = buf.sId++;
 
     // add edge count inside box
     y1 = clamp(box.y + box.h, 0, h - 1);
@@ -708,7 +705,7 @@ void EdgeBoxesImpl::scoreBox(Box &box)
 }
 
 
-void EdgeBoxesImpl::refineBox(Box &box)
+void EdgeBoxesImpl::refineBox(Box &box, ScoreBuffers &buf) const
 {
     int yStep = (int)(box.h * _xyStepRatio);
     int xStep = (int)(box.w * _xyStepRatio);
@@ -725,53 +722,53 @@ void EdgeBoxesImpl::refineBox(Box &box)
         B = box;
         B.y = box.y - yStep;
         B.h = B.h + yStep;
-        scoreBox(B);
+        scoreBox(B, buf);
 
         if (B.score <= box.score)
         {
             B = box;
             B.y = box.y + yStep;
             B.h = B.h - yStep;
-            scoreBox(B);
+            scoreBox(B, buf);
         }
         if (B.score > box.score) box = B;
         // search over y end
         B = box;
         B.h = B.h + yStep;
-        scoreBox(B);
+        scoreBox(B, buf);
 
         if (B.score <= box.score)
         {
             B = box;
             B.h = B.h - yStep;
-            scoreBox(B);
+            scoreBox(B, buf);
         }
         if (B.score > box.score) box = B;
         // search over x start
         B = box;
         B.x = box.x - xStep;
         B.w = B.w + xStep;
-        scoreBox(B);
+        scoreBox(B, buf);
 
         if (B.score <= box.score)
         {
             B = box;
             B.x = box.x + xStep;
             B.w = B.w - xStep;
-            scoreBox(B);
+            scoreBox(B, buf);
         }
 
         if (B.score > box.score) box = B;
         // search over x end
         B = box;
         B.w = B.w + xStep;
-        scoreBox(B);
+        scoreBox(B, buf);
 
         if (B.score <= box.score)
         {
             B = box;
             B.w = B.w - xStep;
-            scoreBox(B);
+            scoreBox(B, buf);
         }
         if (B.score > box.score) box = B;
     }
@@ -813,14 +810,26 @@ void EdgeBoxesImpl::scoreAllBoxes(Boxes &boxes)
         }
     }
 
-    // score all boxes, refine top candidates
-    int i, k = 0, m = (int)boxes.size();
-    for (i = 0; i < m; i++)
+    // score all boxes, refine top candidates. Boxes are independent, so they are split in
+    // stripes over all scales and aspect ratios, each stripe with its own scoreBox() buffers
+    int m = (int)boxes.size();
+    int nstripes = min(m, max(1, getNumThreads()) * 8);
+    int n = _segCnt + 1;
+    parallel_for_(Range(0, m), [&](const Range &range)
+    {
+        ScoreBuffers buf(n);
+        for (int i = range.start; i < range.end; i++)
+        {
+            scoreBox(boxes[i], buf);
+            if (!boxes[i].score) continue;
+            refineBox(boxes[i], buf);
+        }
+    }, nstripes);
+
+    int k = 0;
+    for (int i = 0; i < m; i++)
     {
-        scoreBox(boxes[i]);
-        if (!boxes[i].score) continue;
-        k++;
-        refineBox(boxes[i]);
+        if (boxes[i].score) k++;
     }
     sort(boxes.rbegin(), boxes.rend(), boxesCompare);
     boxes.resize(k);
@@ -859,33 +868,72 @@ void EdgeBoxesImpl::boxesNms(Boxes &boxes, float thr, float eta, int maxBoxes)
     const float step = 1 / thr;
     const float lstep = log(step);
 
-    vector<Boxes> kept;
-    kept.resize(nBin + 1);
     int n = (int) boxes.size();
     int i = 0;
-    int j, k, b;
+    int k, b;
     int m = 0;
     int d = 1;
 
+    // kept boxes are also registered in a coarse spatial grid: boxes overlapping by more than
+    // thr >= 0 share at least one pixel, hence one cell, so only boxes of the cells covered by
+    // the current box are compared. A single cell holding all boxes is used for thr < 0.
+    const int cellSize = thr < 0 ? max(w, h) : max(16, max(w, h) / 32);
+    const int gw = (w + cellSize - 1) / cellSize, gh = (h + cellSize - 1) / cellSize;
+    vector<vector<int> > grid(gw * gh);
+    Boxes keptBoxes;
+    vector<int> keptBins, keptChecked;
+
     while (i < n && m < maxBoxes)
     {
         b = boxes[i].w * boxes[i].h;
 
         bool keep = 1;
         b = clamp((int)(ceil(log(float(b)) / lstep)), d, nBin - d);
-        for (j = b - d; j <= b + d; j++)
+
+        int cx0, cx1, cy0, cy1;
+        if (thr < 0)
+        {
+            cx0 = cx1 = cy0 = cy1 = 0;
+        }
+        else
+        {
+            cx0 = clamp(boxes[i].x / cellSize, 0, gw - 1);
+            cx1 = clamp((boxes[i].x + boxes[i].w - 1) / cellSize, 0, gw - 1);
+            cy0 = clamp(boxes[i].y / cellSize, 0, gh - 1);
+            cy1 = clamp((boxes[i].y + boxes[i].h - 1) / cellSize, 0, gh - 1);
+            if (boxes[i].w <= 0 || boxes[i].h <= 0) cx1 = cx0 - 1; // can not overlap anything
+        }
+
+        for (int cy = cy0; cy <= cy1 && keep; cy++)
         {
-            for (k = 0; k < (int)kept[j].size(); k++)
+            for (int cx = cx0; cx <= cx1 && keep; cx++)
             {
-                if (keep)
-                    keep = boxesOverlap(boxes[i], kept[j][k]) <= thr;
+                const vector<int> &cell = grid[cy * gw + cx];
+                for (k = 0; k < (int)cell.size() && keep; k++)
+                {
+                    int c = cell[k];
+                    if (keptChecked[c] == i || abs(keptBins[c] - b) > d) continue;
+                    keptChecked[c] = i;
+                    keep = boxesOverlap(boxes[i], keptBoxes[c]) <= thr;
+                }
             }
         }
 
         if (keep)
         {
-            kept[b].push_back(boxes[i]);
             m++;
+
+            int c = (int)keptBoxes.size();
+            keptBoxes.push_back(boxes[i]);
+            keptBins.push_back(b);
+            keptChecked.push_back(i);
+            for (int cy = cy0; cy <= cy1; cy++)
+            {
+                for (int cx = cx0; cx <= cx1; cx++)
+                {
+                    grid[cy * gw + cx].push_back(c);
+                }
+            }
         }
 
         i++;
@@ -896,16 +944,8 @@ void EdgeBoxesImpl::boxesNms(Boxes &boxes, float thr, float eta, int maxBoxes)
         }
     }
 
-    boxes.resize(m);
-    i = 0;
-    for (j = 0; j < nBin; j++)
-    {
-        for (k = 0; k < (int)kept[j].size(); k++)
-        {
-            boxes[i++] = kept[j][k];
-        }
-    }
-    sort(boxes.rbegin(), boxes.rend(), boxesCompare);
+    // boxes are kept in decreasing score order
+    boxes.swap(keptBoxes);
 }
 
 
@@ -42,6 +42,7 @@
 //M*/
 
 #include "precomp.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 
 namespace cv { namespace ximgproc {
 
@@ -49,26 +50,200 @@ namespace cv { namespace ximgproc {
     typedef __int32 int32_t;
 #endif
 
+#if CV_SIMD128
+template<typename T> struct HoughVec { enum { enabled = 0 }; };
+#define DEFINE_HOUGHVEC(T, VT)                                                \
+    template<> struct HoughVec<T> { enum { enabled = 1 }; typedef VT vec; };
+DEFINE_HOUGHVEC(uchar,  v_uint8x16)
+DEFINE_HOUGHVEC(schar,  v_int8x16)
+DEFINE_HOUGHVEC(ushort, v_uint16x8)
+DEFINE_HOUGHVEC(short,  v_int16x8)
+DEFINE_HOUGHVEC(int,    v_int32x4)
+DEFINE_HOUGHVEC(float,  v_float32x4)
+#if CV_SIMD128_64F
+DEFINE_HOUGHVEC(double, v_float64x2)
+#endif
+#undef DEFINE_HOUGHVEC
+
+template<HoughOp Op> struct HoughVecOp { };
+template<> struct HoughVecOp<FHT_ADD> {
+    template<typename V> static inline V apply(const V &a, const V &b) { return v_add(a, b); }
+};
+template<> struct HoughVecOp<FHT_MIN> {
+    template<typename V> static inline V apply(const V &a, const V &b) { return v_min(a, b); }
+};
+template<> struct HoughVecOp<FHT_MAX> {
+    template<typename V> static inline V apply(const V &a, const V &b) { return v_max(a, b); }
+};
+
+// Processes the vectorizable head of a row, returns the number of processed elements
+template<typename T, HoughOp Op, int Enabled = HoughVec<T>::enabled>
+struct HoughSimd {
+    static inline int operate(T *, const T *, const T *, int) { return 0; }
+};
+template<typename T, HoughOp Op>
+struct HoughSimd<T, Op, 1> {
+    static inline int operate(T *pDst, const T *pSrc0, const T *pSrc1, int len)
+    {
+        typedef typename HoughVec<T>::vec V;
+        const int nlanes = VTraits<V>::vlanes();
+        int i = 0;
+        for (; i <= len - nlanes; i += nlanes)
+            v_store(pDst + i, HoughVecOp<Op>::apply(v_load(pSrc0 + i),
+                                                    v_load(pSrc1 + i)));
+        return i;
+    }
+};
+#else
+template<typename T, HoughOp Op>
+struct HoughSimd {
+    static inline int operate(T *, const T *, const T *, int) { return 0; }
+};
+#endif
+
 template<typename T, int D, HoughOp Op>
 struct HoughOperator { };
 #define SPECIALIZE_HOUGHOP(TOp, body)                                         \
     template<typename T, int D>                                               \
     struct HoughOperator<T, D, TOp> {                                         \
         static void operate(T *pDst, T *pSrc0, T* pSrc1, int len) {           \
-            Mat dst (Size(1, len), D, pDst);                                  \
-            Mat src0(Size(1, len), D, pSrc0);                                 \
-            Mat src1(Size(1, len), D, pSrc1);                                 \
-            body;                                                             \
+            int i = HoughSimd<T, TOp>::operate(pDst, pSrc0, pSrc1, len);      \
+            for (; i < len; i++)                                              \
+                body;                                                         \
         }                                                                     \
     };
-SPECIALIZE_HOUGHOP(FHT_ADD, add(src0, src1, dst));
-SPECIALIZE_HOUGHOP(FHT_MIN, min(src0, src1, dst));
-SPECIALIZE_HOUGHOP(FHT_MAX, max(src0, src1, dst));
-SPECIALIZE_HOUGHOP(FHT_AVE, addWeighted(src0, 0.5, src1, 0.5, 0.0, dst));
+SPECIALIZE_HOUGHOP(FHT_ADD, pDst[i] = saturate_cast<T>(pSrc0[i] + pSrc1[i]));
+SPECIALIZE_HOUGHOP(FHT_MIN, pDst[i] = std::min(pSrc0[i], pSrc1[i]));
+SPECIALIZE_HOUGHOP(FHT_MAX, pDst[i] = std::max(pSrc0[i], pSrc1[i]));
 #undef SPECIALIZE_HOUGHOP
 
+// Rounds the same way as addWeighted(src0, 0.5, src1, 0.5, 0.0, dst) does
+template<typename T> struct HoughAveWork { typedef float type; };
+template<> struct HoughAveWork<int> { typedef double type; };
+template<> struct HoughAveWork<double> { typedef double type; };
+
+template<typename T, int D>
+struct HoughOperator<T, D, FHT_AVE> {
+    static void operate(T *pDst, T *pSrc0, T* pSrc1, int len) {
+        typedef typename HoughAveWork<T>::type WT;
+        const WT half = (WT)0.5;
+        for (int i = 0; i < len; i++)
+            pDst[i] = saturate_cast<T>(pSrc0[i] * half + pSrc1[i] * half);
+    }
+};
+
 //----------------------fht----------------------------------------------------
 
+// Images smaller than this are transformed on a single thread, the butterfly
+// levels are too short to amortize the parallel_for_ calls.
+static const size_t FHT_PARALLEL_MIN_AREA = 1 << 16;
+
+static inline bool fhtRunsInParallel(const Mat &img)
+{
+    return getNumThreads() > 1 && img.total() >= FHT_PARALLEL_MIN_AREA;
+}
+
+template <typename T, int D, HoughOp OP>
+void fhtMergeRow(Mat     &img0,
+                 Mat     &img1,
+                 int32_t  y0,
+                 int32_t  h,
+                 int32_t  s,
+                 bool     isPositiveShift,
+                 int      level,
+                 double   aspl)
+{
+    const int32_t k = h >> 1;
+    int au = 2 * k - 2;
+    int ad = 2 * h - 2 * k - 2;
+    int b = h - 1;
+    int d = 2 * h - 2;
+    int w = img0.cols;
+    int wm = (h / w + 1) * w;
+
+    int su = (s * au + b) / d;
+    int sd = (s * ad + b) / d;
+    int rd = isPositiveShift ? sd - s : s - sd;
+    rd = (rd + wm) % w;
+    uchar *pLine0 = img0.data + img0.step * (y0 + s);
+    uchar *pLineU = img1.data + img1.step * (y0 + su);
+    uchar *pLineD = img1.data + img1.step * (y0 + k + sd);
+    int w0 = img0.channels() * rd;
+    int w1 = img0.channels() * (w - rd);
+
+    if ((aspl != 0.0) && (level == 1))
+    {
+        int dU = cvRound((y0 + su) * aspl);
+        dU = dU % w;
+        dU *= img0.channels();
+        int dD = cvRound((y0 + k + sd) * aspl);
+        dD = dD % w;
+        dD *= img0.channels();
+        int wB = w * img0.channels();
+
+        int dX = dD - dU;
+        if (w0 >= dX)
+        {
+            if (w0 >= dD)
+            {
+                HoughOperator<T, D, OP>::operate((T *)pLine0 + dU,
+                                           (T *)pLineU,
+                                           (T *)pLineD + (w0 - dX),
+                                           w1 + dX);
+                HoughOperator<T, D, OP>::operate((T *)pLine0 + (w1 + dD),
+                                           (T *)pLineU + (w1 + dX),
+                                           (T *)pLineD,
+                                           w0 - dD);
+                HoughOperator<T, D, OP>::operate((T *)pLine0,
+                                           (T *)pLineU + (wB - dU),
+                                           (T *)pLineD + (w0 - dD),
+                                           dU);
+            }
+            else
+            {
+                HoughOperator<T, D, OP>::operate((T *)pLine0 + dU,
+                                           (T *)pLineU,
+                                           (T *)pLineD + (w0 - dX),
+                                           wB - dU);
+                HoughOperator<T, D, OP>::operate((T *)pLine0,
+                                           (T *)pLineU + (wB - dU),
+                                           (T *)pLineD + (w0 + wB - dD),
+                                           dD - w0);
+                HoughOperator<T, D, OP>::operate((T *)pLine0 + (dD - w0),
+                                           (T *)pLineU + (w1 + dX),
+                                           (T *)pLineD,
+                                           w0 - dX);
+            }
+        }
+        else
+        {
+            HoughOperator<T, D, OP>::operate((T *)pLine0 + dU,
+                                       (T *)pLineU,
+                                       (T *)pLineD + (wB - (dX - w0)),
+                                       dX - w0);
+            HoughOperator<T, D, OP>::operate((T *)pLine0 + (dD - w0),
+                                       (T *)pLineU + (dX - w0),
+                                       (T *)pLineD,
+                                       wB - (dX - w0) - dU);
+            HoughOperator<T, D, OP>::operate((T *)pLine0,
+                                       (T *)pLineU + (wB - dU),
+                                       (T *)pLineD + (wB - (dX - w0) - dU),
+                                       dU);
+        }
+    }
+    else
+    {
+        HoughOperator<T, D, OP>::operate((T *)pLine0,
+                                    (T *)pLineU,
+                                    (T *)pLineD + w0,
+                                    w1);
+        HoughOperator<T, D, OP>::operate((T *)pLine0 + w1,
+                                    (T *)pLineU + w1,
+                                    (T *)pLineD,
+                                    w0);
+    }
+}
+
 template <typename T, int D, HoughOp OP>
 void fhtCore(Mat     &img0,
              Mat     &img1,
@@ -110,99 +285,21 @@ void fhtCore(Mat     &img0,
     fhtCore<T, D, OP>(img1, img0, y0 + k, h - k,
                       isPositiveShift, level - 1, aspl);
 
-    int au = 2 * k - 2;
-    int ad = 2 * h - 2 * k - 2;
-    int b = h - 1;
-    int d = 2 * h - 2;
-    int w = img0.cols;
-    int wm = (h / w + 1) * w;
-
     for (int32_t s = 0; s < h; s++)
-    {
-        int su = (s * au + b) / d;
-        int sd = (s * ad + b) / d;
-        int rd = isPositiveShift ? sd - s : s - sd;
-        rd = (rd + wm) % w;
-        uchar *pLine0 = img0.data + img0.step * (y0 + s);
-        uchar *pLineU = img1.data + img1.step * (y0 + su);
-        uchar *pLineD = img1.data + img1.step * (y0 + k + sd);
-        int w0 = img0.channels() * rd;
-        int w1 = img0.channels() * (w - rd);
-
-        if ((aspl != 0.0) && (level == 1))
-        {
-            int dU = cvRound((y0 + su) * aspl);
-            dU = dU % w;
-            dU *= img0.channels();
-            int dD = cvRound((y0 + k + sd) * aspl);
-            dD = dD % w;
-            dD *= img0.channels();
-            int wB = w * img0.channels();
-
-            int dX = dD - dU;
-            if (w0 >= dX)
-            {
-                if (w0 >= dD)
-                {
-                    HoughOperator<T, D, OP>::operate((T *)pLine0 + dU,
-                                               (T *)pLineU,
-                                               (T *)pLineD + (w0 - dX),
-                                               w1 + dX);
-                    HoughOperator<T, D, OP>::operate((T *)pLine0 + (w1 + dD),
-                                               (T *)pLineU + (w1 + dX),
-                                               (T *)pLineD,
-                                               w0 - dD);
-                    HoughOperator<T, D, OP>::operate((T *)pLine0,
-                                               (T *)pLineU + (wB - dU),
-                                               (T *)pLineD + (w0 - dD),
-                                               dU);
-                }
-                else
-                {
-                    HoughOperator<T, D, OP>::operate((T *)pLine0 + dU,
-                                               (T *)pLineU,
-                                               (T *)pLineD + (w0 - dX),
-                                               wB - dU);
-                    HoughOperator<T, D, OP>::operate((T *)pLine0,
-                                               (T *)pLineU + (wB - dU),
-                                               (T *)pLineD + (w0 + wB - dD),
-                                               dD - w0);
-                    HoughOperator<T, D, OP>::operate((T *)pLine0 + (dD - w0),
-                                               (T *)pLineU + (w1 + dX),
-                                               (T *)pLineD,
-                                               w0 - dX);
-                }
-            }
-            else
-            {
-                HoughOperator<T, D, OP>::operate((T *)pLine0 + dU,
-                                           (T *)pLineU,
-                                           (T *)pLineD + (wB - (dX - w0)),
-                                           dX - w0);
-                HoughOperator<T, D, OP>::operate((T *)pLine0 + (dD - w0),
-                                           (T *)pLineU + (dX - w0),
-                                           (T *)pLineD,
-                                           wB - (dX - w0) - dU);
-                HoughOperator<T, D, OP>::operate((T *)pLine0,
-                                           (T *)pLineU + (wB - dU),
-                                           (T *)pLineD + (wB - (dX - w0) - dU),
-                                           dU);
-            }
-        }
-        else
-        {
-            HoughOperator<T, D, OP>::operate((T *)pLine0,
-                                        (T *)pLineU,
-                                        (T *)pLineD + w0,
-                                        w1);
-            HoughOperator<T, D, OP>::operate((T *)pLine0 + w1,
-                                        (T *)pLineU + w1,
-                                        (T *)pLineD,
-                                        w0);
-        }
-    }
+        fhtMergeRow<T, D, OP>(img0, img1, y0, h, s, isPositiveShift, level, aspl);
 }
 
+struct FHTBlock
+{
+    int32_t y0;
+    int32_t h;
+    int     level;
+    bool    swapped; // img0 and img1 exchange their roles at odd recursion depths
+
+    FHTBlock(int32_t _y0, int32_t _h, int _level, bool _swapped)
+        : y0(_y0), h(_h), level(_level), swapped(_swapped) { }
+};
+
 template <typename T, int D, HoughOp Op>
 void fhtVoT(Mat    &img0,
             Mat    &img1,
@@ -213,7 +310,79 @@ void fhtVoT(Mat    &img0,
     for (int thres = 1; img0.rows > thres; thres <<= 1)
         level++;
 
-    fhtCore<T, D, Op>(img0, img1, 0, img0.rows, isPositiveShift, level, aspl);
+    if (!fhtRunsInParallel(img0))
+    {
+        fhtCore<T, D, Op>(img0, img1, 0, img0.rows, isPositiveShift, level, aspl);
+        return;
+    }
+
+    // Unroll the upper levels of the fhtCore recursion until there are enough
+    // independent subtrees to keep all threads busy. The subtrees cover disjoint
+    // row ranges and are computed concurrently, then the unrolled levels are
+    // merged deepest first, each of them row-parallel.
+    const size_t minLeaves = (size_t)getNumThreads() * 4;
+    std::vector<std::vector<FHTBlock> > merges;
+    std::vector<FHTBlock> leaves, cur(1, FHTBlock(0, img0.rows, level, false));
+    while (!cur.empty())
+    {
+        if (cur.size() >= minLeaves)
+        {
+            leaves.insert(leaves.end(), cur.begin(), cur.end());
+            break;
+        }
+        std::vector<FHTBlock> next, merge;
+        for (size_t i = 0; i < cur.size(); i++)
+        {
+            const FHTBlock &b = cur[i];
+            if (b.level <= 0 || b.h == 1)
+            {
+                leaves.push_back(b);
+                continue;
+            }
+            const int32_t k = b.h >> 1;
+            next.push_back(FHTBlock(b.y0, k, b.level - 1, !b.swapped));
+            next.push_back(FHTBlock(b.y0 + k, b.h - k, b.level - 1, !b.swapped));
+            merge.push_back(b);
+        }
+        merges.push_back(merge);
+        cur.swap(next);
+    }
+
+    parallel_for_(Range(0, (int)leaves.size()), [&](const Range &range)
+    {
+        for (int i = range.start; i < range.end; i++)
+        {
+            const FHTBlock &b = leaves[i];
+            fhtCore<T, D, Op>(b.swapped ? img1 : img0, b.swapped ? img0 : img1,
+                              b.y0, b.h, isPositiveShift, b.level, aspl);
+        }
+    });
+
+    for (size_t depth = merges.size(); depth-- > 0; )
+    {
+        const std::vector<FHTBlock> &blocks = merges[depth];
+        if (blocks.empty())
+            continue;
+
+        std::vector<int> offsets(blocks.size() + 1, 0);
+        for (size_t i = 0; i < blocks.size(); i++)
+            offsets[i + 1] = offsets[i] + blocks[i].h;
+
+        parallel_for_(Range(0, offsets.back()), [&](const Range &range)
+        {
+            size_t bi = std::upper_bound(offsets.begin(), offsets.end(), range.start)
+                        - offsets.begin() - 1;
+            for (int i = range.start; i < range.end; i++)
+            {
+                while (i >= offsets[bi + 1])
+                    bi++;
+                const FHTBlock &b = blocks[bi];
+                fhtMergeRow<T, D, Op>(b.swapped ? img1 : img0, b.swapped ? img0 : img1,
+                                      b.y0, b.h, i - offsets[bi],
+                                      isPositiveShift, b.level, aspl);
+            }
+        });
+    }
 }
 
 template <typename T, int D>
@@ -281,6 +450,8 @@ static void fhtVo(Mat    &img0,
 
 static void FHT(Mat       &dst,
                 const Mat &src,
+                Mat       &tmp,
+                Mat       &tmpT,
                 int        operation,
                 bool       isVertical,
                 bool       isClockwise,
@@ -293,10 +464,15 @@ static void FHT(Mat       &dst,
     else
         CV_Assert(src.cols == dst.rows && src.rows == dst.cols);
 
-    Mat tmp;
-    src.convertTo(tmp, dst.type());
-    if (!isVertical)
-        transpose(tmp, tmp);
+    if (isVertical)
+    {
+        src.convertTo(tmp, dst.type());
+    }
+    else
+    {
+        src.convertTo(tmpT, dst.type());
+        transpose(tmpT, tmp);
+    }
     tmp.copyTo(dst);
 
     fhtVo(dst, tmp,
@@ -306,6 +482,8 @@ static void FHT(Mat       &dst,
 
 static void calculateFHTQuadrant(Mat       &dst,
                                  const Mat &src,
+                                 Mat       &tmp,
+                                 Mat       &tmpT,
                                  int        operation,
                                  int        quadrant)
 {
@@ -344,7 +522,7 @@ static void calculateFHTQuadrant(Mat       &dst,
         CV_Error_(Error::StsNotImplemented, ("Unknown quadrant %d", quadrant));
     }
 
-  FHT(dst, src, operation, bVert, bClock, aspl);
+  FHT(dst, src, tmp, tmpT, operation, bVert, bClock, aspl);
 }
 
 static void createDstFhtMat(OutputArray dst,
@@ -412,7 +590,7 @@ static void createFHTSrc(Mat       &srcFull,
 
     int wd = verticalTiling ? src.cols : src.cols + src.rows;
     int ht = verticalTiling ? src.cols + src.rows : src.rows;
-    srcFull = Mat(ht, wd, src.type());
+    srcFull.create(ht, wd, src.type());
 
     Mat imgReg;
     if (verticalTiling)
@@ -541,127 +719,178 @@ static void skewQuadrant(Mat         &quad,
     }
 }
 
-void FastHoughTransform(InputArray  src,
-                        OutputArray dst,
-                        int         dstMatDepth,
-                        int         angleRange,
-                        int         operation,
-                        int         makeSkew)
+// Intermediate images of a Fast Hough transform, kept by FastHoughTransformer
+// so that same-size frames do not reallocate them
+struct FHTBuffers
+{
+    Mat srcFull[2];             // source tiled for vertical and horizontal quadrants
+    Mat quadrant[4];            // quadrant images when quadrants are computed concurrently
+    Mat tmp[4];                 // per-quadrant scratch images of FHT()
+    Mat tmpT[4];
+    std::vector<uchar> line[4]; // per-quadrant line buffers of skewQuadrant()
+};
+
+static inline bool isHorizontalQuadrant(int quadrant)
+{
+    return quadrant == ARO_45_90 || quadrant == ARO_90_135 || quadrant == ARO_CTR_HOR;
+}
+
+static void processFHTQuadrant(Mat                &dst,
+                               const Mat          &imgSrc,
+                               Mat                &tmp,
+                               Mat                &tmpT,
+                               std::vector<uchar> &line,
+                               int                 operation,
+                               int                 quadrant,
+                               int                 makeSkew)
+{
+    calculateFHTQuadrant(dst, imgSrc, tmp, tmpT, operation, quadrant);
+    if (quadrant == ARO_315_0 || quadrant == ARO_45_90 || quadrant == ARO_CTR_VER)
+        flip(dst, dst, 0);
+    if (HDO_DESKEW == makeSkew)
+    {
+        const int len = dst.cols * static_cast<int>(dst.elemSize());
+        CV_Assert(len > 0);
+        line.resize(len);
+        skewQuadrant(dst, imgSrc, &line[0], quadrant);
+    }
+}
+
+static void fastHoughTransform(const Mat   &srcMat,
+                               OutputArray  dst,
+                               int          dstMatDepth,
+                               int          angleRange,
+                               int          operation,
+                               int          makeSkew,
+                               FHTBuffers  &buffers)
 {
-    Mat srcMat = src.getMat();
-    if (!srcMat.isContinuous())
-        srcMat = srcMat.clone();
     CV_Assert(srcMat.cols > 0 && srcMat.rows > 0);
 
-    createDstFhtMat(dst, src, dstMatDepth, angleRange);
+    createDstFhtMat(dst, srcMat, dstMatDepth, angleRange);
     Mat dstMat = dst.getMat();
 
-    Mat imgRegDst;
-    const int len = dstMat.cols * static_cast<int>(dstMat.elemSize());
-    CV_Assert(len > 0);
-    std::vector<uchar> buf_(len);
-    uchar *buf(&buf_[0]);
+    int quadrants[4];
+    int nQuads = 0;
+    switch (angleRange)
+    {
+    case ARO_315_135:
+        quadrants[nQuads++] = ARO_315_0;
+        quadrants[nQuads++] = ARO_0_45;
+        quadrants[nQuads++] = ARO_45_90;
+        quadrants[nQuads++] = ARO_90_135;
+        break;
+    case ARO_315_45:
+        quadrants[nQuads++] = ARO_315_0;
+        quadrants[nQuads++] = ARO_0_45;
+        break;
+    case ARO_45_135:
+        quadrants[nQuads++] = ARO_45_90;
+        quadrants[nQuads++] = ARO_90_135;
+        break;
+    default:
+        quadrants[nQuads++] = angleRange;
+    }
 
-    if (angleRange == ARO_315_135)
+    bool srcReady[2] = { false, false };
+    for (int i = 0; i < nQuads; i++)
     {
+        const int t = isHorizontalQuadrant(quadrants[i]) ? 1 : 0;
+        if (!srcReady[t])
         {
-            Mat imgSrc;
-            createFHTSrc(imgSrc, srcMat, ARO_315_45);
-
-            setFHTDstRegion(imgRegDst, dstMat, srcMat, ARO_315_0, angleRange);
-            calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_315_0);
-            flip(imgRegDst, imgRegDst, 0);
-            if (HDO_DESKEW == makeSkew)
-                skewQuadrant(imgRegDst, imgSrc, buf, ARO_315_0);
-
-            setFHTDstRegion(imgRegDst, dstMat, srcMat, ARO_0_45, angleRange);
-            calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_0_45);
-            if (HDO_DESKEW == makeSkew)
-                skewQuadrant(imgRegDst, imgSrc, buf, ARO_0_45);
+            createFHTSrc(buffers.srcFull[t], srcMat, quadrants[i]);
+            srcReady[t] = true;
         }
+    }
+
+    if (nQuads == 1)
+    {
+        const Mat &imgSrc = buffers.srcFull[isHorizontalQuadrant(quadrants[0]) ? 1 : 0];
+        processFHTQuadrant(dstMat, imgSrc, buffers.tmp[0], buffers.tmpT[0], buffers.line[0],
+                           operation, quadrants[0], makeSkew);
+        return;
+    }
+
+    // Large quadrants are computed one after another, each of them spreads its
+    // butterflies over all threads. Small ones are computed concurrently into
+    // separate images, because neighbouring quadrants share their border row.
+    if (fhtRunsInParallel(buffers.srcFull[isHorizontalQuadrant(quadrants[0]) ? 1 : 0]))
+    {
+        for (int i = 0; i < nQuads; i++)
         {
-            Mat imgSrc;
-            createFHTSrc(imgSrc, srcMat, ARO_45_135);
-
-            setFHTDstRegion(imgRegDst, dstMat, srcMat, ARO_45_90, angleRange);
-            calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_45_90);
-            flip(imgRegDst, imgRegDst, 0);
-            if (HDO_DESKEW == makeSkew)
-                skewQuadrant(imgRegDst, imgSrc, buf, ARO_45_90);
-
-            setFHTDstRegion(imgRegDst, dstMat, srcMat, ARO_90_135, angleRange);
-            calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_90_135);
-            if (HDO_DESKEW == makeSkew)
-                skewQuadrant(imgRegDst, imgSrc, buf, ARO_90_135);
+            Mat imgRegDst;
+            setFHTDstRegion(imgRegDst, dstMat, srcMat, quadrants[i], angleRange);
+            processFHTQuadrant(imgRegDst, buffers.srcFull[isHorizontalQuadrant(quadrants[i]) ? 1 : 0],
+                               buffers.tmp[0], buffers.tmpT[0], buffers.line[0],
+                               operation, quadrants[i], makeSkew);
         }
         return;
     }
 
-    Mat imgSrc;
-    createFHTSrc(imgSrc, srcMat, angleRange);
+    parallel_for_(Range(0, nQuads), [&](const Range &range)
+    {
+        for (int i = range.start; i < range.end; i++)
+        {
+            Mat imgRegDst;
+            setFHTDstRegion(imgRegDst, dstMat, srcMat, quadrants[i], angleRange);
+            buffers.quadrant[i].create(imgRegDst.size(), imgRegDst.type());
+            processFHTQuadrant(buffers.quadrant[i], buffers.srcFull[isHorizontalQuadrant(quadrants[i]) ? 1 : 0],
+                               buffers.tmp[i], buffers.tmpT[i], buffers.line[i],
+                               operation, quadrants[i], makeSkew);
+        }
+    });
+    for (int i = 0; i < nQuads; i++)
+    {
+        Mat imgRegDst;
+        setFHTDstRegion(imgRegDst, dstMat, srcMat, quadrants[i], angleRange);
+        buffers.quadrant[i].copyTo(imgRegDst);
+    }
+}
 
-    switch (angleRange)
+void FastHoughTransform(InputArray  src,
+                        OutputArray dst,
+                        int         dstMatDepth,
+                        int         angleRange,
+                        int         operation,
+                        int         makeSkew)
+{
+    Mat srcMat = src.getMat();
+    if (!srcMat.isContinuous())
+        srcMat = srcMat.clone();
+
+    FHTBuffers buffers;
+    fastHoughTransform(srcMat, dst, dstMatDepth, angleRange, operation, makeSkew, buffers);
+}
+
+class FastHoughTransformerImpl CV_FINAL : public FastHoughTransformer
+{
+public:
+    FastHoughTransformerImpl(int dstMatDepth, int angleRange, int op, int makeSkew)
+        : dstMatDepth_(dstMatDepth), angleRange_(angleRange), op_(op), makeSkew_(makeSkew)
+    { }
+
+    void apply(InputArray src, OutputArray dst) CV_OVERRIDE
     {
-    case ARO_315_0:
-        calculateFHTQuadrant(dstMat, imgSrc, operation, angleRange);
-        flip(dstMat, dstMat, 0);
-        if (HDO_DESKEW == makeSkew)
-            skewQuadrant(dstMat, imgSrc, buf, angleRange);
-        return;
-    case ARO_0_45:
-        calculateFHTQuadrant(dstMat, imgSrc, operation, angleRange);
-        if (HDO_DESKEW == makeSkew)
-            skewQuadrant(dstMat, imgSrc, buf, angleRange);
-        return;
-    case ARO_45_90:
-        calculateFHTQuadrant(dstMat, imgSrc, operation, angleRange);
-        flip(dstMat, dstMat, 0);
-        if (HDO_DESKEW == makeSkew)
-            skewQuadrant(dstMat, imgSrc, buf, angleRange);
-        return;
-    case ARO_90_135:
-        calculateFHTQuadrant(dstMat, imgSrc, operation, angleRange);
-        if (HDO_DESKEW == makeSkew)
-            skewQuadrant(dstMat, imgSrc, buf, angleRange);
-        return;
-    case ARO_315_45:
-        setFHTDstRegion(imgRegDst, dstMat, srcMat, ARO_315_0, angleRange);
-        calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_315_0);
-        flip(imgRegDst, imgRegDst, 0);
-        if (HDO_DESKEW == makeSkew)
-            skewQuadrant(imgRegDst, imgSrc, buf, ARO_315_0);
-
-        setFHTDstRegion(imgRegDst, dstMat, srcMat, ARO_0_45, angleRange);
-        calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_0_45);
-        if (HDO_DESKEW == makeSkew)
-            skewQuadrant(imgRegDst, imgSrc, buf, ARO_0_45);
-        return;
-    case ARO_45_135:
-        setFHTDstRegion(imgRegDst, dstMat, srcMat, ARO_45_90, angleRange);
-        calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_45_90);
-        flip(imgRegDst, imgRegDst, 0);
-        if (HDO_DESKEW == makeSkew)
-            skewQuadrant(imgRegDst, imgSrc, buf, ARO_45_90);
-
-        setFHTDstRegion(imgRegDst, dstMat, srcMat, ARO_90_135, angleRange);
-        calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_90_135);
-        if (HDO_DESKEW == makeSkew)
-            skewQuadrant(imgRegDst, imgSrc, buf, ARO_90_135);
-        return;
-    case ARO_CTR_VER:
-        calculateFHTQuadrant(dstMat, imgSrc, operation, angleRange);
-        flip(dstMat, dstMat, 0);
-        if (HDO_DESKEW == makeSkew)
-            skewQuadrant(dstMat, imgSrc, buf, angleRange);
-        return;
-    case ARO_CTR_HOR:
-        calculateFHTQuadrant(dstMat, imgSrc, operation, angleRange);
-        if (HDO_DESKEW == makeSkew)
-            skewQuadrant(dstMat, imgSrc, buf, angleRange);
-        return;
-    default:
-        CV_Error_(Error::StsNotImplemented, ("Unknown angleRange %d", angleRange));
+        Mat srcMat = src.getMat();
+        if (!srcMat.isContinuous())
+            srcMat = srcMat.clone();
+
+        fastHoughTransform(srcMat, dst, dstMatDepth_, angleRange_, op_, makeSkew_, buffers_);
     }
+
+private:
+    int dstMatDepth_;
+    int angleRange_;
+    int op_;
+    int makeSkew_;
+    FHTBuffers buffers_;
+};
+
+Ptr<FastHoughTransformer> createFastHoughTransformer(int dstMatDepth,
+                                                     int angleRange,
+                                                     int op,
+                                                     int makeSkew)
+{
+    return makePtr<FastHoughTransformerImpl>(dstMatDepth, angleRange, op, makeSkew);
 }
 
 //-----------------------------------------------------------------------------
@@ -5,6 +5,7 @@
 #include "precomp.hpp"
 #include <opencv2/core.hpp>
 #include <unordered_map>
+#include <unordered_set>
 #include <numeric>
 
 namespace cv {
@@ -181,6 +182,19 @@ struct EllipseData {
     std::vector<float> Sa, Sb;
 };
 
+// state of one of the four triplet searches, they run concurrently
+struct TripletSearch {
+    std::unordered_map<uint, EllipseData> centers; // hash map for reusing already computed EllipseData
+    // getFastCenter is not symmetric, so a pair of arcs shared with a search that comes before in the
+    // sequential order (124, 231, 342, 413) is computed with the arguments of that search
+    const std::unordered_set<uint> *pairsBefore = nullptr; // pairs requested by the searches before
+    bool collectPairs = false; // only collect the requested pairs, without computing anything
+    std::unordered_set<uint> pairs; // pairs requested by the search, see collectPairs
+    std::vector<int> accN, accR, accA; // accumulators
+    std::vector<Ellipse> ellipses; // detected ellipses
+    int countsOfFindEllipse = 0;
+};
+
 // implement of ellipse detector
 class EllipseDetectorImpl {
 
@@ -213,7 +227,6 @@ class EllipseDetectorImpl {
     Size _imgSize; // input image size
 
     int ACC_N_SIZE, ACC_R_SIZE, ACC_A_SIZE; // size of accumulator
-    int *accN, *accR, *accA; // pointer to accumulator
 
 public:
     float countsOfFindEllipse;
@@ -253,25 +266,21 @@ private:
 
     void
     findEllipses(Point2f &center, VP &edge_i, VP &edge_j, VP &edge_k, EllipseData &data_ij,
-                 EllipseData &data_ik, std::vector<Ellipse> &ellipses);
+                 EllipseData &data_ik, TripletSearch &search);
 
     static Point2f getCenterCoordinates(EllipseData &data_ij, EllipseData &data_ik);
 
     void
-    getTriplets124(VVP &pi, VVP &pj, VVP &pk, std::unordered_map<uint, EllipseData> &data,
-                   std::vector<Ellipse> &ellipses);
+    getTriplets124(VVP &pi, VVP &pj, VVP &pk, TripletSearch &search);
 
     void
-    getTriplets231(VVP &pi, VVP &pj, VVP &pk, std::unordered_map<uint, EllipseData> &data,
-                   std::vector<Ellipse> &ellipses);
+    getTriplets231(VVP &pi, VVP &pj, VVP &pk, TripletSearch &search);
 
     void
-    getTriplets342(VVP &pi, VVP &pj, VVP &pk, std::unordered_map<uint, EllipseData> &data,
-                   std::vector<Ellipse> &ellipses);
+    getTriplets342(VVP &pi, VVP &pj, VVP &pk, TripletSearch &search);
 
     void
-    getTriplets413(VVP &pi, VVP &pj, VVP &pk, std::unordered_map<uint, EllipseData> &data,
-                   std::vector<Ellipse> &ellipses);
+    getTriplets413(VVP &pi, VVP &pj, VVP &pk, TripletSearch &search);
 
     static void labeling(Mat1b &image, VVP &segments, int minLength);
 };
@@ -349,7 +358,6 @@ float EllipseDetectorImpl::getMedianSlope(std::vector<Point2f> &med, Point2f &ce
 
 void EllipseDetectorImpl::getFastCenter(std::vector<Point> &e1, std::vector<Point> &e2,
                                         EllipseData &data) {
-    countsOfGetFastCenter++;
     data.isValid = true;
 
     auto size_1 = unsigned(e1.size());
@@ -821,9 +829,9 @@ void EllipseDetectorImpl::detectEdges24(Mat1b &DN, VVP &points_2, VVP &points_4)
 #define T342 pif,pim,pil,pjf,pjm,pjl
 #define T413 pif,pim,pil,pjl,pjm,pjf
 
-void EllipseDetectorImpl::getTriplets124(VVP &pi, VVP &pj, VVP &pk,
-                                         std::unordered_map<uint, EllipseData> &data,
-                                         std::vector<Ellipse> &ellipses) {
+void EllipseDetectorImpl::getTriplets124(VVP &pi, VVP &pj, VVP &pk, TripletSearch &search) {
+    std::unordered_map<uint, EllipseData> &data = search.centers;
+
     // get arcs length
     auto sz_i = ushort(pi.size());
     auto sz_j = ushort(pj.size());
@@ -875,6 +883,12 @@ void EllipseDetectorImpl::getTriplets124(VVP &pi, VVP &pj, VVP &pk,
 
                 uint key_ik = generateKey(PAIR_14, i, k);
 
+                if (search.collectPairs) {
+                    search.pairs.insert(key_ij);
+                    search.pairs.insert(key_ik);
+                    continue;
+                }
+
                 // find centers
                 EllipseData data_ij, data_ik;
 
@@ -911,15 +925,15 @@ void EllipseDetectorImpl::getTriplets124(VVP &pi, VVP &pj, VVP &pk,
                 // get the coordinates of the center (xc, yc)
                 Point2f center = getCenterCoordinates(data_ij, data_ik);
                 // find remaining parameters (A, B, rho)
-                findEllipses(center, edge_i, edge_j, edge_k, data_ij, data_ik, ellipses);
+                findEllipses(center, edge_i, edge_j, edge_k, data_ij, data_ik, search);
             }
         }
     }
 }
 
-void EllipseDetectorImpl::getTriplets231(VVP &pi, VVP &pj, VVP &pk,
-                                         std::unordered_map<uint, EllipseData> &data,
-                                         std::vector<Ellipse> &ellipses) {
+void EllipseDetectorImpl::getTriplets231(VVP &pi, VVP &pj, VVP &pk, TripletSearch &search) {
+    std::unordered_map<uint, EllipseData> &data = search.centers;
+
     // get arc length
     auto sz_i = ushort(pi.size());
     auto sz_j = ushort(pj.size());
@@ -974,6 +988,12 @@ void EllipseDetectorImpl::getTriplets231(VVP &pi, VVP &pj, VVP &pk,
 
                 uint key_ik = generateKey(PAIR_12, k, i);
 
+                if (search.collectPairs) {
+                    search.pairs.insert(key_ij);
+                    search.pairs.insert(key_ik);
+                    continue;
+                }
+
                 // find centers
                 EllipseData data_ij, data_ik;
 
@@ -1013,15 +1033,15 @@ void EllipseDetectorImpl::getTriplets231(VVP &pi, VVP &pj, VVP &pk,
                 // get the coordinates of the center (xc, yc)
                 Point2f center = getCenterCoordinates(data_ij, data_ik);
                 // find remaining parameters (A, B, rho)
-                findEllipses(center, edge_i, edge_j, edge_k, data_ij, data_ik, ellipses);
+                findEllipses(center, edge_i, edge_j, edge_k, data_ij, data_ik, search);
             }
         }
     }
 }
 
-void EllipseDetectorImpl::getTriplets342(VVP &pi, VVP &pj, VVP &pk,
-                                         std::unordered_map<uint, EllipseData> &data,
-                                         std::vector<Ellipse> &ellipses) {
+void EllipseDetectorImpl::getTriplets342(VVP &pi, VVP &pj, VVP &pk, TripletSearch &search) {
+    std::unordered_map<uint, EllipseData> &data = search.centers;
+
     // get arcs length
     auto sz_i = ushort(pi.size());
     auto sz_j = ushort(pj.size());
@@ -1076,6 +1096,12 @@ void EllipseDetectorImpl::getTriplets342(VVP &pi, VVP &pj, VVP &pk,
 
                 uint key_ik = generateKey(PAIR_23, k, i);
 
+                if (search.collectPairs) {
+                    search.pairs.insert(key_ij);
+                    search.pairs.insert(key_ik);
+                    continue;
+                }
+
                 // find centers
                 EllipseData data_ij, data_ik;
 
@@ -1095,7 +1121,10 @@ void EllipseDetectorImpl::getTriplets342(VVP &pi, VVP &pj, VVP &pk,
                     VP rev_k(edge_k.size());
                     std::reverse_copy(edge_k.begin(), edge_k.end(), rev_k.begin());
 
-                    getFastCenter(rev_i, rev_k, data_ik);
+                    if (search.pairsBefore && search.pairsBefore->count(key_ik))
+                        getFastCenter(rev_k, rev_i, data_ik);
+                    else
+                        getFastCenter(rev_i, rev_k, data_ik);
                     data.insert(std::pair<uint, EllipseData>(key_ik, data_ik));
                 } else {
                     // otherwise, just lookup the data in the hash table
@@ -1115,16 +1144,16 @@ void EllipseDetectorImpl::getTriplets342(VVP &pi, VVP &pj, VVP &pk,
                 // get the coordinates of the center (xc, yc)
                 Point2f center = getCenterCoordinates(data_ij, data_ik);
                 // find remaining parameters (A, B, rho)
-                findEllipses(center, edge_i, edge_j, edge_k, data_ij, data_ik, ellipses);
+                findEllipses(center, edge_i, edge_j, edge_k, data_ij, data_ik, search);
             }
         }
 
     }
 }
 
-void EllipseDetectorImpl::getTriplets413(VVP &pi, VVP &pj, VVP &pk,
-                                         std::unordered_map<uint, EllipseData> &data,
-                                         std::vector<Ellipse> &ellipses) {
+void EllipseDetectorImpl::getTriplets413(VVP &pi, VVP &pj, VVP &pk, TripletSearch &search) {
+    std::unordered_map<uint, EllipseData> &data = search.centers;
+
     // get arch length
     auto sz_i = ushort(pi.size());
     auto sz_j = ushort(pj.size());
@@ -1176,12 +1205,21 @@ void EllipseDetectorImpl::getTriplets413(VVP &pi, VVP &pj, VVP &pk,
 
                 uint key_ik = generateKey(PAIR_34, k, i);
 
+                if (search.collectPairs) {
+                    search.pairs.insert(key_ij);
+                    search.pairs.insert(key_ik);
+                    continue;
+                }
+
                 // find centers
                 EllipseData data_ij, data_ik;
 
                 // if the data for the pair i-j have not been computed yet
                 if (data.count(key_ij) == 0) {
-                    getFastCenter(edge_i, edge_j, data_ij);
+                    if (search.pairsBefore && search.pairsBefore->count(key_ij))
+                        getFastCenter(edge_j, edge_i, data_ij);
+                    else
+                        getFastCenter(edge_i, edge_j, data_ij);
                     // insert computed date in the hash table
                     data.insert(std::pair<uint, EllipseData>(key_ij, data_ij));
                 } else {
@@ -1191,7 +1229,10 @@ void EllipseDetectorImpl::getTriplets413(VVP &pi, VVP &pj, VVP &pk,
 
                 // if the data for the pair i-k have not been computed yet
                 if (data.count(key_ik) == 0) {
-                    getFastCenter(rev_i, edge_k, data_ik);
+                    if (search.pairsBefore && search.pairsBefore->count(key_ik))
+                        getFastCenter(edge_k, rev_i, data_ik);
+                    else
+                        getFastCenter(rev_i, edge_k, data_ik);
                     data.insert(std::pair<uint, EllipseData>(key_ik, data_ik));
                 } else {
                     // otherwise, just lookup the data in the hash table
@@ -1211,7 +1252,7 @@ void EllipseDetectorImpl::getTriplets413(VVP &pi, VVP &pj, VVP &pk,
                 // get the coordinates of the center (xc, yc)
                 Point2f center = getCenterCoordinates(data_ij, data_ik);
                 // find remaining parameters (A, B, rho)
-                findEllipses(center, edge_i, edge_j, edge_k, data_ij, data_ik, ellipses);
+                findEllipses(center, edge_i, edge_j, edge_k, data_ij, data_ik, search);
 
             }
         }
@@ -1236,9 +1277,25 @@ void EllipseDetectorImpl::preProcessing(Mat1b &image, Mat1b &dp, Mat1b &dn) {
     Mat1f magGrad(imgSize.height, imgSize.width, 0.f);
     float maxGrad(0);
     for (int i = 0; i < imgSize.height; i++) {
+        const short *tmpDx = dx.ptr<short>(i);
+        const short *tmpDy = dy.ptr<short>(i);
         auto *tmpMag = magGrad.ptr<float>(i);
-        for (int j = 0; j < imgSize.width; j++) {
-            auto val = float(abs(dx[i][j]) + abs(dy[i][j]));
+        int j = 0;
+#if CV_SIMD128
+        // |dx| + |dy| of a 3x3 Sobel of 8-bit image fits in 16 bits
+        v_uint16x8 vMaxGrad = v_setzero_u16();
+        for (; j <= imgSize.width - 8; j += 8) {
+            v_uint16x8 vMag = v_add(v_abs(v_load(tmpDx + j)), v_abs(v_load(tmpDy + j)));
+            vMaxGrad = v_max(vMaxGrad, vMag);
+            v_uint32x4 vMag0, vMag1;
+            v_expand(vMag, vMag0, vMag1);
+            v_store(tmpMag + j, v_cvt_f32(v_reinterpret_as_s32(vMag0)));
+            v_store(tmpMag + j + 4, v_cvt_f32(v_reinterpret_as_s32(vMag1)));
+        }
+        maxGrad = max(maxGrad, float(v_reduce_max(vMaxGrad)));
+#endif
+        for (; j < imgSize.width; j++) {
+            auto val = float(abs(tmpDx[j]) + abs(tmpDy[j]));
             tmpMag[j] = val;
             maxGrad = (val > maxGrad) ? val : maxGrad;
         }
@@ -1459,7 +1516,26 @@ void EllipseDetectorImpl::preProcessing(Mat1b &image, Mat1b &dp, Mat1b &dn) {
         auto *tmpDp = dp.ptr<uchar>(i);
         auto *tmpDn = dn.ptr<uchar>(i);
 
-        for (int j = 0; j < imgSize.width; j++) {
+        int j = 0;
+#if CV_SIMD128
+        // phi = -dx / dy is positive iff dx and dy have opposite signs
+        const v_int16x8 vZero = v_setzero_s16();
+        for (; j <= imgSize.width - 16; j += 16) {
+            v_int16x8 vDx0 = v_load(tmpDx + j), vDx1 = v_load(tmpDx + j + 8);
+            v_int16x8 vDy0 = v_load(tmpDy + j), vDy1 = v_load(tmpDy + j + 8);
+            v_int16x8 vValid0 = v_and(v_ne(vDx0, vZero), v_ne(vDy0, vZero));
+            v_int16x8 vValid1 = v_and(v_ne(vDx1, vZero), v_ne(vDy1, vZero));
+            v_int16x8 vOpposite0 = v_lt(v_xor(vDx0, vDy0), vZero);
+            v_int16x8 vOpposite1 = v_lt(v_xor(vDx1, vDy1), vZero);
+
+            v_uint8x16 vValid = v_and(v_reinterpret_as_u8(v_pack(vValid0, vValid1)),
+                                      v_ne(v_load(tmpE + j), v_setzero_u8()));
+            v_uint8x16 vOpposite = v_reinterpret_as_u8(v_pack(vOpposite0, vOpposite1));
+            v_store(tmpDp + j, v_and(vValid, vOpposite));
+            v_store(tmpDn + j, v_and(vValid, v_not(vOpposite)));
+        }
+#endif
+        for (; j < imgSize.width; j++) {
             if (!((tmpE[j] <= 0) || (tmpDx[j] == 0) || (tmpDy[j] == 0))) {
                 // angle of the tangent
                 float phi = -(float(tmpDx[j])) / float(tmpDy[j]);
@@ -1486,12 +1562,8 @@ void EllipseDetectorImpl::detect(Mat1b &image, std::vector<Ellipse> &ellipses) {
     // initialize accumulator dimensions
     ACC_N_SIZE = 101, ACC_R_SIZE = 180, ACC_A_SIZE = max(_imgSize.height, _imgSize.width);
 
-    // allocate accumulators
-    accN = new int[ACC_N_SIZE], accR = new int[ACC_R_SIZE], accA = new int[ACC_A_SIZE];
-
     // other temporary
     VVP points_1, points_2, points_3, points_4; // vector of points, one for each convexity class
-    std::unordered_map<uint, EllipseData> centers; // hash map for reusing already computed EllipseData
 
     // preprocessing
     // find edge point with coarse convexity along positive (dp) or negative (dn) diagonal
@@ -1501,31 +1573,68 @@ void EllipseDetectorImpl::detect(Mat1b &image, std::vector<Ellipse> &ellipses) {
     detectEdges13(dp, points_1, points_3);
     detectEdges24(dn, points_2, points_4);
 
-    // find triplets
-    getTriplets124(points_1, points_2, points_4, centers, ellipses);
-    getTriplets231(points_2, points_3, points_1, centers, ellipses);
-    getTriplets342(points_3, points_4, points_2, centers, ellipses);
-    getTriplets413(points_4, points_1, points_3, centers, ellipses);
+    // find triplets, the four searches only read the arcs and have their own accumulators.
+    // The pairs of arcs shared by two searches get their center computed in both.
+    TripletSearch searches[4];
+    auto runSearch = [&](int t) {
+        TripletSearch &search = searches[t];
+        switch (t) {
+            case 0: getTriplets124(points_1, points_2, points_4, search); break;
+            case 1: getTriplets231(points_2, points_3, points_1, search); break;
+            case 2: getTriplets342(points_3, points_4, points_2, search); break;
+            default: getTriplets413(points_4, points_1, points_3, search); break;
+        }
+    };
+
+    // first find the pairs requested by the searches 124, 231 and 342, which 342 and 413 share:
+    // 231 -> 342 (PAIR_23), 124 -> 413 (PAIR_14) and 342 -> 413 (PAIR_34)
+    parallel_for_(Range(0, 3), [&](const Range &range) {
+        for (int t = range.start; t < range.end; t++) {
+            searches[t].collectPairs = true;
+            runSearch(t);
+            searches[t].collectPairs = false;
+        }
+    });
+    std::unordered_set<uint> pairsBefore413(searches[0].pairs);
+    pairsBefore413.insert(searches[2].pairs.begin(), searches[2].pairs.end());
+    searches[2].pairsBefore = &searches[1].pairs;
+    searches[3].pairsBefore = &pairsBefore413;
+
+    parallel_for_(Range(0, 4), [&](const Range &range) {
+        for (int t = range.start; t < range.end; t++) {
+            TripletSearch &search = searches[t];
+            search.accN.resize(ACC_N_SIZE);
+            search.accR.resize(ACC_R_SIZE);
+            search.accA.resize(ACC_A_SIZE);
+            runSearch(t);
+        }
+    });
+
+    // gather the detections in the sequential order
+    std::unordered_set<uint> computedPairs;
+    for (int t = 0; t < 4; t++) {
+        ellipses.insert(ellipses.end(), searches[t].ellipses.begin(), searches[t].ellipses.end());
+        countsOfFindEllipse += float(searches[t].countsOfFindEllipse);
+        for (const auto &center : searches[t].centers)
+            computedPairs.insert(center.first);
+    }
+    countsOfGetFastCenter = float(computedPairs.size());
 
     // std::sort by score
     std::sort(ellipses.begin(), ellipses.end());
 
-    // free accumulator memory
-    delete[]accN;
-    delete[]accR;
-    delete[]accA;
-
     // cluster detections
     clusterEllipses(ellipses);
 }
 
 void EllipseDetectorImpl::findEllipses(Point2f &center, VP &edge_i, VP &edge_j, VP &edge_k,
                                        EllipseData &data_ij, EllipseData &data_ik,
-                                       std::vector<Ellipse> &ellipses) {
-    countsOfFindEllipse++;
+                                       TripletSearch &search) {
+    search.countsOfFindEllipse++;
     // find ellipse parameters
 
     // 0-initialize accumulators
+    int *accN = search.accN.data(), *accR = search.accR.data(), *accA = search.accA.data();
     memset(accN, 0, sizeof(int) * ACC_N_SIZE);
     memset(accR, 0, sizeof(int) * ACC_R_SIZE);
     memset(accA, 0, sizeof(int) * ACC_A_SIZE);
@@ -1872,7 +1981,7 @@ void EllipseDetectorImpl::findEllipses(Point2f &center, VP &edge_i, VP &edge_j,
     ell.score = (score + rel) * 0.5f;
 
     // the tentative detection has been confirmed
-    ellipses.emplace_back(ell);
+    search.ellipses.emplace_back(ell);
 }
 
 void EllipseDetectorImpl::clusterEllipses(std::vector<Ellipse> &ellipses) {
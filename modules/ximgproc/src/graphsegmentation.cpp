@@ -40,6 +40,7 @@ the use of this software, even if advised of the possibility of such damage.
 
 #include "precomp.hpp"
 #include "opencv2/ximgproc/segmentation.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 
 #include <iostream>
 
@@ -49,17 +50,117 @@ namespace cv {
 
             // Helpers
 
-            // Represent an edge between two pixels
-            class Edge {
-                public:
-                    int from;
-                    int to;
-                    float weight;
+            // The edges of the graph link each pixel to its right and bottom neighbours. They are
+            // stored as two arrays: their weights, as the bits of the (non negative) float weights,
+            // which compare as the weights do, and their ids: 2 * pixel for the edge to the right
+            // neighbour, 2 * pixel + 1 for the edge to the bottom one.
+            static inline int edgeFrom(int edge) {
+                return edge >> 1;
+            }
+
+            static inline int edgeTo(int edge, int cols) {
+                return (edge >> 1) + ((edge & 1) ? cols : 1);
+            }
+
+            static inline float edgeWeight(unsigned weight) {
+                Cv32suf w;
+                w.u = weight;
+                return w.f;
+            }
 
-                    bool operator <(const Edge& e) const {
-                        return weight < e.weight;
+            // Compute the weights of the edges between the pixels of a and b
+            static void computeEdgeWeights(const float* a, const float* b, int nb_pixels, int nb_channels, unsigned* weights) {
+
+                int j = 0;
+#if CV_SIMD128
+                if (nb_channels == 1) {
+                    for (; j <= nb_pixels - 4; j += 4) {
+                        v_float32x4 diff = v_sub(v_load(a + j), v_load(b + j));
+                        v_store(weights + j, v_reinterpret_as_u32(v_sqrt(v_mul(diff, diff))));
                     }
-            };
+                } else if (nb_channels == 3) {
+                    for (; j <= nb_pixels - 4; j += 4) {
+                        v_float32x4 a0, a1, a2, b0, b1, b2;
+                        v_load_deinterleave(a + j * 3, a0, a1, a2);
+                        v_load_deinterleave(b + j * 3, b0, b1, b2);
+                        v_float32x4 diff0 = v_sub(a0, b0), diff1 = v_sub(a1, b1), diff2 = v_sub(a2, b2);
+                        v_float32x4 total = v_add(v_add(v_mul(diff0, diff0), v_mul(diff1, diff1)), v_mul(diff2, diff2));
+                        v_store(weights + j, v_reinterpret_as_u32(v_sqrt(total)));
+                    }
+                }
+#endif
+                for (; j < nb_pixels; j++) {
+                    float tmp_total = 0;
+
+                    for (int channel = 0; channel < nb_channels; channel++) {
+                        float tmp_diff = a[j * nb_channels + channel] - b[j * nb_channels + channel];
+                        tmp_total += tmp_diff * tmp_diff;
+                    }
+
+                    Cv32suf w;
+                    w.f = sqrt(tmp_total);
+                    weights[j] = w.u;
+                }
+            }
+
+            // Stable LSD radix sort of the edges by weight, the passes are split in chunks of edges
+            // which are counted and scattered in parallel
+            static void sortEdges(std::vector<unsigned> &weights, std::vector<int> &edges) {
+
+                const int nb_edges = (int)weights.size();
+                const int nb_buckets = 256;
+                const int nb_chunks = nb_edges < (1 << 16) ? 1 : std::max(1, getNumThreads()) * 2;
+
+                std::vector<unsigned> weights_tmp(nb_edges);
+                std::vector<int> edges_tmp(nb_edges);
+                std::vector<int> offsets(nb_chunks * nb_buckets);
+
+                for (int shift = 0; shift < 32; shift += 8) {
+
+                    std::fill(offsets.begin(), offsets.end(), 0);
+
+                    parallel_for_(Range(0, nb_chunks), [&](const Range& range) {
+                        for (int c = range.start; c < range.end; c++) {
+                            int* count = &offsets[c * nb_buckets];
+                            int end = (int)((int64)nb_edges * (c + 1) / nb_chunks);
+                            for (int i = (int)((int64)nb_edges * c / nb_chunks); i < end; i++)
+                                count[(weights[i] >> shift) & (nb_buckets - 1)]++;
+                        }
+                    });
+
+                    // Turn the counts into the positions of the buckets of each chunk, the pass is
+                    // skipped when all the edges are in the same bucket
+                    bool skip = false;
+                    int position = 0;
+                    for (int b = 0; b < nb_buckets; b++) {
+                        for (int c = 0; c < nb_chunks; c++) {
+                            int count = offsets[c * nb_buckets + b];
+                            if (count == nb_edges)
+                                skip = true;
+                            offsets[c * nb_buckets + b] = position;
+                            position += count;
+                        }
+                    }
+
+                    if (skip)
+                        continue;
+
+                    parallel_for_(Range(0, nb_chunks), [&](const Range& range) {
+                        for (int c = range.start; c < range.end; c++) {
+                            int* position_c = &offsets[c * nb_buckets];
+                            int end = (int)((int64)nb_edges * (c + 1) / nb_chunks);
+                            for (int i = (int)((int64)nb_edges * c / nb_chunks); i < end; i++) {
+                                int pos = position_c[(weights[i] >> shift) & (nb_buckets - 1)]++;
+                                weights_tmp[pos] = weights[i];
+                                edges_tmp[pos] = edges[i];
+                            }
+                        }
+                    });
+
+                    weights.swap(weights_tmp);
+                    edges.swap(edges_tmp);
+                }
+            }
 
             // A point in the sets of points
             class PointSetElement {
@@ -145,13 +246,13 @@ namespace cv {
                     void filter(const Mat &img, Mat &img_filtered);
 
                     // Build the graph between each pixels
-                    void buildGraph(Edge **edges, int &nb_edges, const Mat &img_filtered);
+                    void buildGraph(std::vector<unsigned> &weights, std::vector<int> &edges, const Mat &img_filtered);
 
                     // Segment the graph
-                    void segmentGraph(Edge * edges, const int &nb_edges, const Mat & img_filtered, PointSet **es);
+                    void segmentGraph(std::vector<unsigned> &weights, std::vector<int> &edges, const Mat & img_filtered, PointSet **es);
 
                     // Remove areas too small
-                    void filterSmallAreas(Edge *edges, const int &nb_edges, PointSet *es);
+                    void filterSmallAreas(const std::vector<unsigned> &weights, const std::vector<int> &edges, int cols, PointSet *es);
 
                     // Map the segemented graph to a Mat with uniques, sequentials ids
                     void finalMapping(PointSet *es, Mat &output);
@@ -168,57 +269,49 @@ namespace cv {
                 GaussianBlur(img_converted, img_filtered, Size(0, 0), sigma, sigma);
             }
 
-            void GraphSegmentationImpl::buildGraph(Edge **edges, int &nb_edges, const Mat &img_filtered) {
-
-                *edges = new Edge[img_filtered.rows * img_filtered.cols * 4];
+            void GraphSegmentationImpl::buildGraph(std::vector<unsigned> &weights, std::vector<int> &edges, const Mat &img_filtered) {
 
-                nb_edges = 0;
+                const int rows = img_filtered.rows;
+                const int cols = img_filtered.cols;
+                const int nb_channels = img_filtered.channels();
 
-                int nb_channels = img_filtered.channels();
+                // Each row has cols - 1 edges to the right, then cols edges to the bottom (except the last row)
+                const int nb_edges = rows * (cols - 1) + (rows - 1) * cols;
+                weights.resize(nb_edges);
+                edges.resize(nb_edges);
 
-                for (int i = 0; i < (int)img_filtered.rows; i++) {
-                    const float* p = img_filtered.ptr<float>(i);
+                if (nb_edges <= 0)
+                    return;
 
-                    for (int j = 0; j < (int)img_filtered.cols; j++) {
+                parallel_for_(Range(0, rows), [&](const Range& range) {
+                    for (int i = range.start; i < range.end; i++) {
+                        const float* p = img_filtered.ptr<float>(i);
+                        size_t offset = (size_t)i * (2 * cols - 1);
 
-                        //Take the right, left, top and down pixel
-                        for (int delta = -1; delta <= 1; delta += 2) {
-                            for (int delta_j = 0, delta_i = 1; delta_j <= 1; delta_j++ || delta_i--) {
+                        // Right neighbours
+                        computeEdgeWeights(p, p + nb_channels, cols - 1, nb_channels, weights.data() + offset);
+                        for (int j = 0; j < cols - 1; j++)
+                            edges[offset + j] = 2 * (i * cols + j);
 
-                                int i2 = i + delta * delta_i;
-                                int j2 = j + delta * delta_j;
-
-                                if (i2 >= 0 && i2 < img_filtered.rows && j2 >= 0 && j2 < img_filtered.cols) {
-                                    const float* p2 = img_filtered.ptr<float>(i2);
-
-                                    float tmp_total = 0;
-
-                                    for ( int channel = 0; channel < nb_channels; channel++) {
-                                        float tmp_diff = p[j * nb_channels + channel] - p2[j2 * nb_channels + channel];
-                                        tmp_total += tmp_diff * tmp_diff;
-                                    }
-
-                                    float diff = 0;
-                                    diff = sqrt(tmp_total);
-
-                                    (*edges)[nb_edges].weight = diff;
-                                    (*edges)[nb_edges].from = i * img_filtered.cols +  j;
-                                    (*edges)[nb_edges].to = i2 * img_filtered.cols + j2;
-
-                                    nb_edges++;
-                                }
-                            }
+                        // Bottom neighbours
+                        if (i + 1 < rows) {
+                            offset += cols - 1;
+                            computeEdgeWeights(p, img_filtered.ptr<float>(i + 1), cols, nb_channels, weights.data() + offset);
+                            for (int j = 0; j < cols; j++)
+                                edges[offset + j] = 2 * (i * cols + j) + 1;
                         }
                     }
-                }
+                });
             }
 
-            void GraphSegmentationImpl::segmentGraph(Edge *edges, const int &nb_edges, const Mat &img_filtered, PointSet **es) {
+            void GraphSegmentationImpl::segmentGraph(std::vector<unsigned> &weights, std::vector<int> &edges, const Mat &img_filtered, PointSet **es) {
 
                 int total_points = ( int)(img_filtered.rows * img_filtered.cols);
+                int nb_edges = (int)edges.size();
+                int cols = img_filtered.cols;
 
                 // Sort edges
-                std::sort(edges, edges + nb_edges);
+                sortEdges(weights, edges);
 
                 // Create a set with all point (by default mapped to themselves)
                 *es = new PointSet(img_filtered.cols * img_filtered.rows);
@@ -231,16 +324,17 @@ namespace cv {
 
                 for ( int i = 0; i < nb_edges; i++) {
 
-                    int p_a = (*es)->getBasePoint(edges[i].from);
-                    int p_b = (*es)->getBasePoint(edges[i].to);
+                    int p_a = (*es)->getBasePoint(edgeFrom(edges[i]));
+                    int p_b = (*es)->getBasePoint(edgeTo(edges[i], cols));
+                    float weight = edgeWeight(weights[i]);
 
                     if (p_a != p_b) {
-                        if (edges[i].weight <= thresholds[p_a] && edges[i].weight <= thresholds[p_b]) {
+                        if (weight <= thresholds[p_a] && weight <= thresholds[p_b]) {
                             (*es)->joinPoints(p_a, p_b);
                             p_a = (*es)->getBasePoint(p_a);
-                            thresholds[p_a] = edges[i].weight + k / (*es)->size(p_a);
+                            thresholds[p_a] = weight + k / (*es)->size(p_a);
 
-                            edges[i].weight = 0;
+                            weights[i] = 0;
                         }
                     }
                 }
@@ -248,14 +342,16 @@ namespace cv {
                 delete [] thresholds;
             }
 
-            void GraphSegmentationImpl::filterSmallAreas(Edge *edges, const int &nb_edges, PointSet *es) {
+            void GraphSegmentationImpl::filterSmallAreas(const std::vector<unsigned> &weights, const std::vector<int> &edges, int cols, PointSet *es) {
+
+                int nb_edges = (int)edges.size();
 
                 for ( int i = 0; i < nb_edges; i++) {
 
-                    if (edges[i].weight > 0) {
+                    if (edgeWeight(weights[i]) > 0) {
 
-                        int p_a = es->getBasePoint(edges[i].from);
-                        int p_b = es->getBasePoint(edges[i].to);
+                        int p_a = es->getBasePoint(edgeFrom(edges[i]));
+                        int p_b = es->getBasePoint(edgeTo(edges[i], cols));
 
                         if (p_a != p_b && (es->size(p_a) < min_size || es->size(p_b) < min_size)) {
                             es->joinPoints(p_a, p_b);
@@ -317,23 +413,22 @@ namespace cv {
                 filter(img, img_filtered);
 
                 // Build graph
-                Edge *edges;
-                int nb_edges;
+                std::vector<unsigned> weights;
+                std::vector<int> edges;
 
-                buildGraph(&edges, nb_edges, img_filtered);
+                buildGraph(weights, edges, img_filtered);
 
                 // Segment graph
                 PointSet *es;
 
-                segmentGraph(edges, nb_edges, img_filtered, &es);
+                segmentGraph(weights, edges, img_filtered, &es);
 
                 // Remove small areas
-                filterSmallAreas(edges, nb_edges, es);
+                filterSmallAreas(weights, edges, img_filtered.cols, es);
 
                 // Map to final output
                 finalMapping(es, output);
 
-                delete [] edges;
                 delete es;
 
             }
@@ -367,13 +462,12 @@ namespace cv {
 
                  int base_p = p;
 
+                // Make each visited point skip its parent (path halving) for faster acces later
                 while (base_p != mapping[base_p].p) {
+                    mapping[base_p].p = mapping[mapping[base_p].p].p;
                     base_p = mapping[base_p].p;
                 }
 
-                // Save mapping for faster acces later
-                mapping[p].p = base_p;
-
                 return base_p;
             }
 
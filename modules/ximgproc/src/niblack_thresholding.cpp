@@ -46,6 +46,260 @@
 namespace cv {
 namespace ximgproc {
 
+namespace {
+
+// Parameters of the local threshold of 8-bit images
+struct NiblackParams
+{
+    int method;
+    int type;
+    float k, r;
+    float srcMin, stddevMax; // only used by BINARIZATION_WOLF
+    uchar maxValue;
+};
+
+// Largest block for which the window sums of squares of 8-bit pixels fit in an int
+static const int NIBLACK_MAX_BLOCK_SIZE_8U = 181;
+
+static inline float niblackThreshold(const NiblackParams& p, float sum, float sqsum, float scale)
+{
+    float mean = sum * scale;
+    float sqmean = sqsum * scale;
+    float variance = std::max(sqmean - mean * mean, 0.f);
+    float stddev = std::sqrt(variance);
+    switch (p.method)
+    {
+    case BINARIZATION_NIBLACK:
+        return mean + p.k * stddev;
+    case BINARIZATION_SAUVOLA:
+        return mean * (1.f + p.k * (stddev / p.r - 1.f));
+    case BINARIZATION_WOLF:
+        return mean - p.k * (mean - p.srcMin - stddev * (mean - p.srcMin) / p.stddevMax);
+    default: // BINARIZATION_NICK
+        return mean + p.k * std::sqrt(variance + sqmean);
+    }
+}
+
+static inline uchar niblackApply(int type, uchar src, uchar thresh, uchar maxValue)
+{
+    bool above = src > thresh;
+    switch (type)
+    {
+    case THRESH_BINARY:     return above ? maxValue : 0;
+    case THRESH_BINARY_INV: return above ? 0 : maxValue;
+    case THRESH_TRUNC:      return above ? thresh : src;
+    case THRESH_TOZERO:     return above ? src : 0;
+    default:                return above ? 0 : src; // THRESH_TOZERO_INV
+    }
+}
+
+#if CV_SIMD128
+static inline v_float32x4 niblackThreshold(const NiblackParams& p, const v_float32x4& vSum, const v_float32x4& vSqSum,
+                                           const v_float32x4& vScale)
+{
+    v_float32x4 vMean = v_mul(vSum, vScale);
+    v_float32x4 vSqMean = v_mul(vSqSum, vScale);
+    v_float32x4 vVariance = v_max(v_sub(vSqMean, v_mul(vMean, vMean)), v_setzero_f32());
+    v_float32x4 vStddev = v_sqrt(vVariance);
+    v_float32x4 vK = v_setall_f32(p.k);
+    switch (p.method)
+    {
+    case BINARIZATION_NIBLACK:
+        return v_add(vMean, v_mul(vK, vStddev));
+    case BINARIZATION_SAUVOLA:
+        return v_mul(vMean, v_add(v_setall_f32(1.f),
+                                  v_mul(vK, v_sub(v_div(vStddev, v_setall_f32(p.r)), v_setall_f32(1.f)))));
+    case BINARIZATION_WOLF:
+    {
+        v_float32x4 vMeanMin = v_sub(vMean, v_setall_f32(p.srcMin));
+        return v_sub(vMean, v_mul(vK, v_sub(vMeanMin, v_div(v_mul(vStddev, vMeanMin), v_setall_f32(p.stddevMax)))));
+    }
+    default: // BINARIZATION_NICK
+        return v_add(vMean, v_mul(vK, v_sqrt(v_add(vVariance, vSqMean))));
+    }
+}
+
+static inline v_int16x8 niblackApply(int type, const v_int16x8& vSrc, const v_int16x8& vThresh, const v_int16x8& vMaxValue)
+{
+    v_int16x8 vAbove = v_gt(vSrc, vThresh);
+    switch (type)
+    {
+    case THRESH_BINARY:     return v_and(vAbove, vMaxValue);
+    case THRESH_BINARY_INV: return v_andnot(vMaxValue, vAbove);
+    case THRESH_TRUNC:      return v_select(vAbove, vThresh, vSrc);
+    case THRESH_TOZERO:     return v_and(vAbove, vSrc);
+    default:                return v_andnot(vSrc, vAbove); // THRESH_TOZERO_INV
+    }
+}
+#endif
+
+// Thresholds the rows [rowBegin, rowEnd) of an 8-bit image in a single pass. The sums over the
+// vertical extent of the window are updated from row to row, and the sums of each window are
+// taken from the integral of those column sums along the row. Borders are replicated.
+// If maxVariance is given, only the largest local variance is computed.
+static void niBlackThresholdBand8u(const Mat& src, Mat& dst, int rowBegin, int rowEnd, int radius,
+                                   const NiblackParams& p, float* maxVariance)
+{
+    if (rowBegin >= rowEnd)
+        return;
+
+    const int width = src.cols, height = src.rows;
+    const int blockSize = 2 * radius + 1;
+    const int extWidth = width + 2 * radius;
+    const float scale = 1.f / (blockSize * blockSize);
+
+    // the sums are unsigned so that the integrals along the row may wrap around,
+    // the window sums themselves always fit in an int
+    AutoBuffer<unsigned> buffer(2 * width + 2 * (extWidth + 1));
+    unsigned* colSum = buffer.data();
+    unsigned* colSqSum = colSum + width;
+    unsigned* rowInt = colSqSum + width;
+    unsigned* rowSqInt = rowInt + extWidth + 1;
+
+    memset(colSum, 0, width * sizeof(unsigned));
+    memset(colSqSum, 0, width * sizeof(unsigned));
+    for (int dy = -radius; dy <= radius; dy++)
+    {
+        const uchar* srcRow = src.ptr<uchar>(std::min(std::max(rowBegin + dy, 0), height - 1));
+        for (int x = 0; x < width; x++)
+        {
+            unsigned v = srcRow[x];
+            colSum[x] += v;
+            colSqSum[x] += v * v;
+        }
+    }
+
+    float maxVar = 0.f;
+    for (int y = rowBegin; y < rowEnd; y++)
+    {
+        if (y > rowBegin)
+        {
+            // slide the window down by one row
+            const uchar* addRow = src.ptr<uchar>(std::min(y + radius, height - 1));
+            const uchar* subRow = src.ptr<uchar>(std::max(y - radius - 1, 0));
+            int x = 0;
+#if CV_SIMD128
+            for (; x <= width - 8; x += 8)
+            {
+                v_uint16x8 vAdd = v_load_expand(addRow + x), vSub = v_load_expand(subRow + x);
+                v_uint32x4 vAdd0, vAdd1, vSub0, vSub1;
+                v_expand(vAdd, vAdd0, vAdd1);
+                v_expand(vSub, vSub0, vSub1);
+                v_store(colSum + x, v_sub(v_add(v_load(colSum + x), vAdd0), vSub0));
+                v_store(colSum + x + 4, v_sub(v_add(v_load(colSum + x + 4), vAdd1), vSub1));
+                v_mul_expand(vAdd, vAdd, vAdd0, vAdd1);
+                v_mul_expand(vSub, vSub, vSub0, vSub1);
+                v_store(colSqSum + x, v_sub(v_add(v_load(colSqSum + x), vAdd0), vSub0));
+                v_store(colSqSum + x + 4, v_sub(v_add(v_load(colSqSum + x + 4), vAdd1), vSub1));
+            }
+#endif
+            for (; x < width; x++)
+            {
+                unsigned a = addRow[x], b = subRow[x];
+                colSum[x] += a - b;
+                colSqSum[x] += a * a - b * b;
+            }
+        }
+
+        // integrals of the column sums along the row, with replicated borders
+        rowInt[0] = rowSqInt[0] = 0;
+        for (int i = 0; i < extWidth; i++)
+        {
+            int x = std::min(std::max(i - radius, 0), width - 1);
+            rowInt[i + 1] = rowInt[i] + colSum[x];
+            rowSqInt[i + 1] = rowSqInt[i] + colSqSum[x];
+        }
+
+        if (maxVariance)
+        {
+            for (int x = 0; x < width; x++)
+            {
+                float mean = (float)(int)(rowInt[x + blockSize] - rowInt[x]) * scale;
+                float sqmean = (float)(int)(rowSqInt[x + blockSize] - rowSqInt[x]) * scale;
+                maxVar = std::max(maxVar, sqmean - mean * mean);
+            }
+            continue;
+        }
+
+        const uchar* srcRow = src.ptr<uchar>(y);
+        uchar* dstRow = dst.ptr<uchar>(y);
+        int x = 0;
+#if CV_SIMD128
+        const v_float32x4 vScale = v_setall_f32(scale);
+        const v_int16x8 vMaxValue = v_setall_s16(p.maxValue);
+        const v_int16x8 vZero = v_setzero_s16(), v255 = v_setall_s16(255);
+        for (; x <= width - 8; x += 8)
+        {
+            v_int32x4 vSum0 = v_reinterpret_as_s32(v_sub(v_load(rowInt + x + blockSize), v_load(rowInt + x)));
+            v_int32x4 vSum1 = v_reinterpret_as_s32(v_sub(v_load(rowInt + x + blockSize + 4), v_load(rowInt + x + 4)));
+            v_int32x4 vSqSum0 = v_reinterpret_as_s32(v_sub(v_load(rowSqInt + x + blockSize), v_load(rowSqInt + x)));
+            v_int32x4 vSqSum1 = v_reinterpret_as_s32(v_sub(v_load(rowSqInt + x + blockSize + 4), v_load(rowSqInt + x + 4)));
+
+            v_int32x4 vThresh0 = v_round(niblackThreshold(p, v_cvt_f32(vSum0), v_cvt_f32(vSqSum0), vScale));
+            v_int32x4 vThresh1 = v_round(niblackThreshold(p, v_cvt_f32(vSum1), v_cvt_f32(vSqSum1), vScale));
+            v_int16x8 vThresh = v_min(v_max(v_pack(vThresh0, vThresh1), vZero), v255);
+
+            v_int16x8 vSrc = v_reinterpret_as_s16(v_load_expand(srcRow + x));
+            v_pack_u_store(dstRow + x, niblackApply(p.type, vSrc, vThresh, vMaxValue));
+        }
+#endif
+        for (; x < width; x++)
+        {
+            float sum = (float)(int)(rowInt[x + blockSize] - rowInt[x]);
+            float sqsum = (float)(int)(rowSqInt[x + blockSize] - rowSqInt[x]);
+            uchar thresh = saturate_cast<uchar>(niblackThreshold(p, sum, sqsum, scale));
+            dstRow[x] = niblackApply(p.type, srcRow[x], thresh, p.maxValue);
+        }
+    }
+
+    if (maxVariance)
+        *maxVariance = maxVar;
+}
+
+static void niBlackThreshold8u(const Mat& src, Mat& dst, double maxValue, int type, int blockSize,
+                               double k, int binarizationMethod, double r)
+{
+    NiblackParams p;
+    p.method = binarizationMethod;
+    p.type = type;
+    p.k = static_cast<float>(k);
+    p.r = static_cast<float>(r);
+    p.srcMin = 0.f;
+    p.stddevMax = 0.f;
+    p.maxValue = saturate_cast<uchar>(maxValue);
+
+    const int radius = blockSize / 2;
+
+    // bands are processed in parallel, each one starts with the sums of a whole window
+    int nBands = std::min(src.rows, std::max(1, getNumThreads()) * 2);
+    nBands = std::max(1, std::min(nBands, src.rows / blockSize));
+
+    if (binarizationMethod == BINARIZATION_WOLF)
+    {
+        double srcMin;
+        minMaxIdx(src, &srcMin);
+        p.srcMin = static_cast<float>(srcMin);
+
+        std::vector<float> maxVariances(nBands, 0.f);
+        parallel_for_(Range(0, nBands), [&](const Range& range)
+        {
+            for (int band = range.start; band < range.end; band++)
+                niBlackThresholdBand8u(src, dst, src.rows * band / nBands, src.rows * (band + 1) / nBands,
+                                       radius, p, &maxVariances[band]);
+        });
+        p.stddevMax = std::sqrt(*std::max_element(maxVariances.begin(), maxVariances.end()));
+    }
+
+    parallel_for_(Range(0, nBands), [&](const Range& range)
+    {
+        for (int band = range.start; band < range.end; band++)
+            niBlackThresholdBand8u(src, dst, src.rows * band / nBands, src.rows * (band + 1) / nBands,
+                                   radius, p, NULL);
+    });
+}
+
+} // namespace
+
 void niBlackThreshold( InputArray _src, OutputArray _dst, double maxValue,
         int type, int blockSize, double k, int binarizationMethod, double r)
 {
@@ -59,6 +313,21 @@ void niBlackThreshold( InputArray _src, OutputArray _dst, double maxValue,
     }
     type &= THRESH_MASK;
 
+    // 8-bit images are thresholded in a single parallel pass, without intermediate images
+    if (src.depth() == CV_8U && blockSize <= NIBLACK_MAX_BLOCK_SIZE_8U &&
+        (binarizationMethod == BINARIZATION_NIBLACK || binarizationMethod == BINARIZATION_SAUVOLA ||
+         binarizationMethod == BINARIZATION_WOLF || binarizationMethod == BINARIZATION_NICK) &&
+        (type == THRESH_BINARY || type == THRESH_BINARY_INV || type == THRESH_TRUNC ||
+         type == THRESH_TOZERO || type == THRESH_TOZERO_INV))
+    {
+        _dst.create(src.size(), src.type());
+        Mat dst = _dst.getMat();
+        CV_Assert(src.data != dst.data);  // no inplace processing
+
+        niBlackThreshold8u(src, dst, maxValue, type, blockSize, k, binarizationMethod, r);
+        return;
+    }
+
     // Compute local threshold (T = mean + k * stddev)
     // using mean and standard deviation in the neighborhood of each pixel
     // (intermediate calculations are done with floating-point precision)
@@ -5,6 +5,101 @@
 #include "precomp.hpp"
 
 namespace cv {namespace ximgproc {
+    // Restricts [xmin, xmax] to the x for which lo < a + b * x < hi
+    static void clipLine(double a, double b, double lo, double hi, double& xmin, double& xmax)
+    {
+        if (std::abs(b) < DBL_EPSILON) {
+            if (a <= lo || a >= hi) {
+                xmin = 1;
+                xmax = 0;
+            }
+            return;
+        }
+        double t1 = (lo - a) / b, t2 = (hi - a) / b;
+        xmin = std::max(xmin, std::min(t1, t2));
+        xmax = std::min(xmax, std::max(t1, t2));
+    }
+
+    // Projections of the source for the angles [range.start, range.end). Each projection is the
+    // sum along the rows of the source rotated by the angle, as warpAffine with bilinear
+    // interpolation and a constant zero border would rotate it, but without the rotated image:
+    // the samples are taken directly along the rotated rows, only where they can hit _content.
+    template <typename T, typename WT, typename OT>
+    static void radonProjections(const Mat& _src, Mat& _radon, const Rect& _content, Point _center,
+                                 double theta, double start_angle, const Range& range)
+    {
+        const int _size = _src.rows;
+        const double _lo_x = _content.x - 2, _hi_x = _content.x + _content.width + 1;
+        const double _lo_y = _content.y - 2, _hi_y = _content.y + _content.height + 1;
+        // fixed-point coordinates, as computed by warpAffine
+        const int _ab_bits = std::max(10, (int)INTER_BITS);
+        const int _ab_scale = 1 << _ab_bits;
+        const int _round_delta = _ab_scale / INTER_TAB_SIZE / 2;
+        const double _scale = 1. / INTER_TAB_SIZE;
+
+        for (int _col = range.start; _col < range.end; _col++) {
+            double _t = start_angle + _col * theta;
+            Mat _r_matrix = getRotationMatrix2D(_center, _t, 1), _inv_matrix;
+            invertAffineTransform(_r_matrix, _inv_matrix);
+            const double* _m = _inv_matrix.ptr<double>();
+
+            for (int _row = 0; _row < _size; _row++) {
+                // source position of (x, _row) is (_ax + x * _m[0], _ay + x * _m[3])
+                double _ax = _m[1] * _row + _m[2];
+                double _ay = _m[4] * _row + _m[5];
+                double _xmin = 0, _xmax = _size - 1;
+                clipLine(_ax, _m[0], _lo_x, _hi_x, _xmin, _xmax);
+                clipLine(_ay, _m[3], _lo_y, _hi_y, _xmin, _xmax);
+
+                WT _sum = 0;
+                int _x0 = saturate_cast<int>(_ax * _ab_scale) + _round_delta;
+                int _y0 = saturate_cast<int>(_ay * _ab_scale) + _round_delta;
+                int _x_begin = 0, _x_end = -1;
+                if (_xmin <= _xmax) {
+                    _x_begin = std::max(cvFloor(_xmin), 0);
+                    _x_end = std::min(cvCeil(_xmax), _size - 1);
+                }
+                for (int x = _x_begin; x <= _x_end; x++) {
+                    // sample position with the sub-pixel precision of warpAffine
+                    int _sx = (_x0 + saturate_cast<int>(_m[0] * x * _ab_scale)) >> (_ab_bits - INTER_BITS);
+                    int _sy = (_y0 + saturate_cast<int>(_m[3] * x * _ab_scale)) >> (_ab_bits - INTER_BITS);
+                    int _ix = _sx >> INTER_BITS, _iy = _sy >> INTER_BITS;
+                    double _fx = (_sx & (INTER_TAB_SIZE - 1)) * _scale;
+                    double _fy = (_sy & (INTER_TAB_SIZE - 1)) * _scale;
+
+                    double _v00 = 0, _v01 = 0, _v10 = 0, _v11 = 0;
+                    if ((unsigned)_ix < (unsigned)(_size - 1) && (unsigned)_iy < (unsigned)(_size - 1)) {
+                        const T* _p0 = _src.ptr<T>(_iy) + _ix;
+                        const T* _p1 = _src.ptr<T>(_iy + 1) + _ix;
+                        _v00 = _p0[0]; _v01 = _p0[1];
+                        _v10 = _p1[0]; _v11 = _p1[1];
+                    }
+                    else {
+                        if (_ix < -1 || _ix >= _size || _iy < -1 || _iy >= _size)
+                            continue;
+                        bool _in0 = _ix >= 0, _in1 = _ix + 1 < _size;
+                        if (_iy >= 0) {
+                            const T* _p0 = _src.ptr<T>(_iy) + _ix;
+                            _v00 = _in0 ? _p0[0] : 0;
+                            _v01 = _in1 ? _p0[1] : 0;
+                        }
+                        if (_iy + 1 < _size) {
+                            const T* _p1 = _src.ptr<T>(_iy + 1) + _ix;
+                            _v10 = _in0 ? _p1[0] : 0;
+                            _v11 = _in1 ? _p1[1] : 0;
+                        }
+                    }
+
+                    double _v = (_v00 * (1 - _fx) + _v01 * _fx) * (1 - _fy) +
+                                (_v10 * (1 - _fx) + _v11 * _fx) * _fy;
+                    // the rotated image has the type of the source
+                    _sum += saturate_cast<T>(_v);
+                }
+                _radon.at<OT>(_row, _col) = saturate_cast<OT>(_sum);
+            }
+        }
+    }
+
     void RadonTransform(InputArray src,
                              OutputArray dst,
                              double theta,
@@ -24,6 +119,7 @@ namespace cv {namespace ximgproc {
         transpose(_srcMat, _srcMat);
         Mat _masked_src;
         cv::Point _center;
+        cv::Rect _content;
 
         if (_srcMat.type() == CV_32FC1 || _srcMat.type() == CV_64FC1) {
             _out_mat_type = CV_64FC1;
@@ -45,37 +141,60 @@ namespace cv {namespace ximgproc {
             _center = Point(_srcMat.cols / 2, _srcMat.rows / 2);
             circle(_mask, _center, _srcMat.cols / 2, Scalar(255), FILLED);
             _srcMat.copyTo(_masked_src, _mask);
+            _content = Rect(0, 0, _row_num, _row_num);
         }
         else {
             // avoid cropping corner when rotating
             _row_num = cvCeil(sqrt(_srcMat.rows * _srcMat.rows + _srcMat.cols * _srcMat.cols));
             _masked_src = Mat(Size(_row_num, _row_num), _srcMat.type(), Scalar(0));
             _center = Point(_masked_src.cols / 2, _masked_src.rows / 2);
-            _srcMat.copyTo(_masked_src(Rect(
+            _content = Rect(
                 (_row_num - _srcMat.cols) / 2,
                 (_row_num - _srcMat.rows) / 2,
-                _srcMat.cols, _srcMat.rows)));
+                _srcMat.cols, _srcMat.rows);
+            _srcMat.copyTo(_masked_src(_content));
+        }
+
+        // the projections are written directly into dst unless they have to be normalized
+        Mat _radon;
+        if (norm) {
+            _radon.create(_row_num, _col_num, _out_mat_type);
+        }
+        else {
+            dst.create(_row_num, _col_num, _out_mat_type);
+            _radon = dst.getMat();
         }
 
-        double _t;
-        Mat _rotated_src;
-        Mat _radon(_row_num, _col_num, _out_mat_type);
-
-        for (int _col = 0; _col < _col_num; _col++) {
-            // rotate the source by _t
-            _t = (start_angle + _col * theta);
-            cv::Mat _r_matrix = cv::getRotationMatrix2D(_center, _t, 1);
-            cv::warpAffine(_masked_src, _rotated_src, _r_matrix, _masked_src.size());
-            Mat _col_mat = _radon.col(_col);
-            // make projection
-            cv::reduce(_rotated_src, _col_mat, 1, REDUCE_SUM, _out_mat_type);
+        typedef void (*RadonProjectionsFunc)(const Mat&, Mat&, const Rect&, Point, double, double, const Range&);
+        RadonProjectionsFunc _func = NULL;
+        switch (_masked_src.depth()) {
+        case CV_8U:
+            _func = radonProjections<uchar, int64, int>;
+            break;
+        case CV_16U:
+            _func = radonProjections<ushort, int64, int>;
+            break;
+        case CV_16S:
+            _func = radonProjections<short, int64, int>;
+            break;
+        case CV_32F:
+            _func = radonProjections<float, double, double>;
+            break;
+        case CV_64F:
+            _func = radonProjections<double, double, double>;
+            break;
+        default:
+            CV_Error(Error::StsUnsupportedFormat, "unsupported image type");
         }
 
+        // angles are independent, each one is projected by a single thread
+        parallel_for_(Range(0, _col_num), [&](const Range& range) {
+            _func(_masked_src, _radon, _content, _center, theta, start_angle, range);
+        });
+
         if (norm) {
-            normalize(_radon, _radon, 0, 255, NORM_MINMAX, CV_8UC1);
+            normalize(_radon, dst, 0, 255, NORM_MINMAX, CV_8UC1);
         }
-
-        _radon.copyTo(dst);
         return;
     }
 } }
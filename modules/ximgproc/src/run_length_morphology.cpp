@@ -54,27 +54,112 @@ struct rlType
 
 typedef std::vector<rlType> rlVec;
 
+// number of row bands to process in parallel, a single one for small amounts of work
+static int _getNumBands(int nRows, double dWork)
+{
+  if (nRows < 2 || dWork < (1 << 16))
+    return 1;
+  return std::min(nRows, std::max(1, getNumThreads()) * 4);
+}
+
+// concatenates the runs of consecutive row bands
+static void _concatBands(std::vector<rlVec>& bands, rlVec& res)
+{
+  size_t nRuns = 0;
+  for (size_t i = 0; i < bands.size(); ++i)
+    nRuns += bands[i].size();
+  res.reserve(res.size() + nRuns);
+  for (size_t i = 0; i < bands.size(); ++i)
+    res.insert(res.end(), bands[i].begin(), bands[i].end());
+}
+
+// returns the first index from j on of a block of pixels that are not all above (bAbove)
+// or all below or equal to the threshold, whole vectors of uniform pixels are skipped
+template <class T>
+inline int _skipUniformPixels(const T*, int j, int, T, bool)
+{
+  return j;
+}
+
+#if CV_SIMD128
+template <class T, class VT>
+inline int _skipUniformPixelsSimd(const T* pData, int j, int nWidth, const VT& vThreshold, bool bAbove)
+{
+  const int nLanes = VTraits<VT>::vlanes();
+  for (; j <= nWidth - nLanes; j += nLanes)
+  {
+    VT vAbove = v_gt(v_load(pData + j), vThreshold);
+    if (bAbove ? !v_check_all(vAbove) : v_check_any(vAbove))
+      break;
+  }
+  return j;
+}
+
+template <>
+inline int _skipUniformPixels<uchar>(const uchar* pData, int j, int nWidth, uchar threshold, bool bAbove)
+{
+  return _skipUniformPixelsSimd(pData, j, nWidth, v_setall_u8(threshold), bAbove);
+}
+
+template <>
+inline int _skipUniformPixels<schar>(const schar* pData, int j, int nWidth, schar threshold, bool bAbove)
+{
+  return _skipUniformPixelsSimd(pData, j, nWidth, v_setall_s8(threshold), bAbove);
+}
+
+template <>
+inline int _skipUniformPixels<ushort>(const ushort* pData, int j, int nWidth, ushort threshold, bool bAbove)
+{
+  return _skipUniformPixelsSimd(pData, j, nWidth, v_setall_u16(threshold), bAbove);
+}
+
+template <>
+inline int _skipUniformPixels<short>(const short* pData, int j, int nWidth, short threshold, bool bAbove)
+{
+  return _skipUniformPixelsSimd(pData, j, nWidth, v_setall_s16(threshold), bAbove);
+}
+
+template <>
+inline int _skipUniformPixels<int>(const int* pData, int j, int nWidth, int threshold, bool bAbove)
+{
+  return _skipUniformPixelsSimd(pData, j, nWidth, v_setall_s32(threshold), bAbove);
+}
+
+template <>
+inline int _skipUniformPixels<float>(const float* pData, int j, int nWidth, float threshold, bool bAbove)
+{
+  return _skipUniformPixelsSimd(pData, j, nWidth, v_setall_f32(threshold), bAbove);
+}
+#endif
+
 template <class T>
 void _thresholdLine(T* pData, int nWidth, int nRow, T threshold, int type, rlVec& res)
 {
+  // at most one vector of pixels is checked one by one after skipping a uniform part
+  const int nScalarBlock = 16;
   bool bOn = false;
   int nStartSegment = 0;
-  for (int j = 0; j < nWidth; j++)
+  int j = 0;
+  while (j < nWidth)
   {
-    bool bAboveThreshold = (pData[j] > threshold);
-    bool bCurOn = (bAboveThreshold == (THRESH_BINARY == type));
-    if (!bOn && bCurOn)
+    j = _skipUniformPixels<T>(pData, j, nWidth, threshold, bOn == (THRESH_BINARY == type));
+    int nBlockEnd = std::min(nWidth, j + nScalarBlock);
+    for (; j < nBlockEnd; j++)
     {
-      nStartSegment = j;
-      bOn = true;
-    }
-    else if (bOn && !bCurOn)
-    {
-      rlType chord(nStartSegment, j - 1, nRow);
-      res.push_back(chord);
-      bOn = false;
+      bool bAboveThreshold = (pData[j] > threshold);
+      bool bCurOn = (bAboveThreshold == (THRESH_BINARY == type));
+      if (!bOn && bCurOn)
+      {
+        nStartSegment = j;
+        bOn = true;
+      }
+      else if (bOn && !bCurOn)
+      {
+        rlType chord(nStartSegment, j - 1, nRow);
+        res.push_back(chord);
+        bOn = false;
+      }
     }
-
   }
   if (bOn)
   {
@@ -83,41 +168,49 @@ void _thresholdLine(T* pData, int nWidth, int nRow, T threshold, int type, rlVec
   }
 }
 
+template <class T>
+static void _thresholdImage(cv::Mat& img, T threshold, int type, rlVec& res)
+{
+  int nBands = _getNumBands(img.rows, (double)img.total());
+  std::vector<rlVec> bands(nBands);
+  parallel_for_(Range(0, nBands), [&](const Range& range)
+  {
+    for (int band = range.start; band < range.end; ++band)
+    {
+      int nRowBegin = img.rows * band / nBands;
+      int nRowEnd = img.rows * (band + 1) / nBands;
+      for (int i = nRowBegin; i < nRowEnd; ++i)
+        _thresholdLine<T>((T*) img.ptr(i), img.cols, i, threshold, type, bands[band]);
+    }
+  });
+  _concatBands(bands, res);
+}
+
 static void _threshold(cv::Mat& img, rlVec& res, double threshold, int type)
 {
   res.clear();
   switch (img.depth())
   {
   case CV_8U:
-    for (int i = 0; i < img.rows; ++i)
-      _thresholdLine<uchar>(img.ptr(i), img.cols, i, (uchar) threshold, type, res);
+    _thresholdImage<uchar>(img, (uchar) threshold, type, res);
     break;
   case CV_8S:
-    for (int i = 0; i < img.rows; ++i)
-      _thresholdLine<schar>((schar*) img.ptr(i), img.cols, i, (schar) threshold, type, res);
+    _thresholdImage<schar>(img, (schar) threshold, type, res);
     break;
   case CV_16U:
-      for (int i = 0; i < img.rows; ++i)
-      {
-          _thresholdLine<unsigned short>((unsigned short*)img.ptr(i), img.cols, i,
-              (unsigned short)threshold, type, res);
-      }
+    _thresholdImage<unsigned short>(img, (unsigned short) threshold, type, res);
     break;
   case CV_16S:
-    for (int i = 0; i < img.rows; ++i)
-      _thresholdLine<short>((short*) img.ptr(i), img.cols, i, (short) threshold, type, res);
+    _thresholdImage<short>(img, (short) threshold, type, res);
     break;
   case CV_32S:
-    for (int i = 0; i < img.rows; ++i)
-      _thresholdLine<int>((int*) img.ptr(i), img.cols, i, (int) threshold, type, res);
+    _thresholdImage<int>(img, (int) threshold, type, res);
     break;
   case CV_32F:
-    for (int i = 0; i < img.rows; ++i)
-      _thresholdLine<float>((float*) img.ptr(i), img.cols, i, (float) threshold, type, res);
+    _thresholdImage<float>(img, (float) threshold, type, res);
     break;
   case CV_64F:
-    for (int i = 0; i < img.rows; ++i)
-      _thresholdLine<double>((double*) img.ptr(i), img.cols, i, threshold, type, res);
+    _thresholdImage<double>(img, threshold, type, res);
     break;
   default:
     CV_Error( Error::StsUnsupportedFormat, "unsupported image type" );
@@ -127,15 +220,13 @@ static void _threshold(cv::Mat& img, rlVec& res, double threshold, int type)
 
 static void convertToOutputArray(rlVec& runs, Size size, OutputArray& res)
 {
-    size_t nRuns = runs.size();
-    std::vector<cv::Point3i> segments(nRuns + 1);
-    segments[0] = cv::Point3i(size.width, size.height, 0);
-    for (size_t i = 0; i < nRuns; ++i)
-    {
-        rlType& curRun = runs[i];
-        segments[i + 1] = Point3i(curRun.cb, curRun.ce, curRun.r);
-    }
-    Mat(segments).copyTo(res);
+    // rlType has the layout of Point3i (see paint())
+    int nRuns = (int) runs.size();
+    res.create(nRuns + 1, 1, CV_32SC3);
+    Mat segments = res.getMat();
+    segments.at<Point3i>(0) = cv::Point3i(size.width, size.height, 0);
+    if (nRuns > 0)
+        memcpy(segments.ptr<Point3i>(1), &runs[0], nRuns * sizeof(rlType));
 }
 
 
@@ -258,7 +349,7 @@ static void erode_rle (rlVec& regIn, rlVec& regOut, rlVec& se)
     vector<int> pIdxChord1(nRows);
     vector<int> pIdxNextRow(nRows);
 
-    int i,j;
+    int i;
 
     for (i=1;i<nRows;i++)
     {
@@ -283,85 +374,108 @@ static void erode_rle (rlVec& regIn, rlVec& regOut, rlVec& se)
 
     assert(nRowsSE == (int) se.size());
 
-    vector<int> pCurIdxRow(nRowsSE);
+    int nFirstRow = nMinRow - nMinRowSE;
+    int nLastRow = nMaxRow - nMaxRowSE;
+    if (nLastRow < nFirstRow)
+        return;
+
+    // the result rows are independent, they are computed in bands
+    int nResultRows = nLastRow - nFirstRow + 1;
+    int nBands = _getNumBands(nResultRows, (double) regIn.size() * nRowsSE);
+    vector<rlVec> bands(nBands);
 
-    // loop through all possible rows
-    for (i=nMinRow - nMinRowSE; i<= nMaxRow - nMaxRowSE; i++)
+    parallel_for_(Range(0, nBands), [&](const Range& range)
     {
-        // check whether all relevant rows are available
-        bool bNextRow = false;
+        vector<int> pCurIdxRow(nRowsSE);
 
-        for (j=0; j < nRowsSE; j++)
+        for (int band = range.start; band < range.end; band++)
         {
-            // get idx of first chord in regIn for this row of the se
-            pCurIdxRow[j] = pIdxChord1[ j + nMinRowSE + i - nMinRow];
-            if (pCurIdxRow[j] == -1)
+            rlVec& bandOut = bands[band];
+            int nBandBegin = nFirstRow + nResultRows * band / nBands;
+            int nBandEnd = nFirstRow + nResultRows * (band + 1) / nBands;
+
+            // loop through all possible rows
+            for (int i = nBandBegin; i < nBandEnd; i++)
             {
-                bNextRow = true;
-                break;
-            }
-        }
+                int j;
 
-        if (bNextRow)
-            continue;
+                // check whether all relevant rows are available
+                bool bNextRow = false;
 
-        while (!bNextRow)
-        {
-          int nPossibleStart = std::numeric_limits<int>::min();
-
-          // search for row with max( cb - se.cb) (the leftmost possible position of a result chord
-          for (j=0;j<nRowsSE;j++)
-              nPossibleStart = max(nPossibleStart, regIn[pCurIdxRow[j]].cb - se[j].cb);
-
-          // for all rows skip chords whose end is left from the point
-          // where it can contribute to a result
-          bool bHaveResult = true;
-          int nLimitingRow = 0;
-          int nChordEnd = std::numeric_limits<int>::max(); //INT_MAX;
-
-          for (j=0;j<nRowsSE;j++)
-          {
-              while (regIn[pCurIdxRow[j]].ce < nPossibleStart + se[j].ce &&
-                  pCurIdxRow[j] != pIdxNextRow[j + nMinRowSE + i - nMinRow])
-              {
-                  pCurIdxRow[j]++;
-              }
-
-              // if all chords in this row skipped -> next row
-              if (pCurIdxRow[j] == pIdxNextRow[ j + nMinRowSE + i - nMinRow])
-              {
-                  bNextRow = true;
-                  bHaveResult = false;
-                  break;
-              }
-              else if ( bHaveResult )
-              {
-              // can the found chord contribute to a result ?
-              if (regIn[ pCurIdxRow[j] ].cb - se[j].cb <= nPossibleStart)
-              {
-                  int nCurPossibleEnd = regIn[ pCurIdxRow[j] ].ce - se[j].ce;
-                  if (nCurPossibleEnd < nChordEnd)
+                for (j=0; j < nRowsSE; j++)
+                {
+                    // get idx of first chord in regIn for this row of the se
+                    pCurIdxRow[j] = pIdxChord1[ j + nMinRowSE + i - nMinRow];
+                    if (pCurIdxRow[j] == -1)
+                    {
+                        bNextRow = true;
+                        break;
+                    }
+                }
+
+                if (bNextRow)
+                    continue;
+
+                while (!bNextRow)
+                {
+                  int nPossibleStart = std::numeric_limits<int>::min();
+
+                  // search for row with max( cb - se.cb) (the leftmost possible position of a result chord
+                  for (j=0;j<nRowsSE;j++)
+                      nPossibleStart = max(nPossibleStart, regIn[pCurIdxRow[j]].cb - se[j].cb);
+
+                  // for all rows skip chords whose end is left from the point
+                  // where it can contribute to a result
+                  bool bHaveResult = true;
+                  int nLimitingRow = 0;
+                  int nChordEnd = std::numeric_limits<int>::max(); //INT_MAX;
+
+                  for (j=0;j<nRowsSE;j++)
                   {
-                      nChordEnd = nCurPossibleEnd;
-                      nLimitingRow = j;
+                      while (regIn[pCurIdxRow[j]].ce < nPossibleStart + se[j].ce &&
+                          pCurIdxRow[j] != pIdxNextRow[j + nMinRowSE + i - nMinRow])
+                      {
+                          pCurIdxRow[j]++;
+                      }
+
+                      // if all chords in this row skipped -> next row
+                      if (pCurIdxRow[j] == pIdxNextRow[ j + nMinRowSE + i - nMinRow])
+                      {
+                          bNextRow = true;
+                          bHaveResult = false;
+                          break;
+                      }
+                      else if ( bHaveResult )
+                      {
+                      // can the found chord contribute to a result ?
+                      if (regIn[ pCurIdxRow[j] ].cb - se[j].cb <= nPossibleStart)
+                      {
+                          int nCurPossibleEnd = regIn[ pCurIdxRow[j] ].ce - se[j].ce;
+                          if (nCurPossibleEnd < nChordEnd)
+                          {
+                              nChordEnd = nCurPossibleEnd;
+                              nLimitingRow = j;
+                          }
+                      }
+                      else
+                          bHaveResult = false;
+                      }
                   }
-              }
-              else
-                  bHaveResult = false;
-              }
-          }
 
-        if (bHaveResult)
-        {
-            regOut.push_back(rlType(nPossibleStart, nChordEnd, i));
-            pCurIdxRow[nLimitingRow]++;
+                if (bHaveResult)
+                {
+                    bandOut.push_back(rlType(nPossibleStart, nChordEnd, i));
+                    pCurIdxRow[nLimitingRow]++;
 
-            if (pCurIdxRow[nLimitingRow] == pIdxNextRow[ nLimitingRow + nMinRowSE + i - nMinRow])
-                  bNextRow = true;
-        }
-        } // end while (!bNextRow
-    } // end for
+                    if (pCurIdxRow[nLimitingRow] == pIdxNextRow[ nLimitingRow + nMinRowSE + i - nMinRow])
+                          bNextRow = true;
+                }
+                } // end while (!bNextRow
+            } // end for
+        } // end for band
+    });
 
+    _concatBands(bands, regOut);
 }
 
 static void convertInputArrayToRuns(InputArray& theArray, rlVec& runs, Size& theSize)
@@ -374,16 +488,13 @@ static void convertInputArrayToRuns(InputArray& theArray, rlVec& runs, Size& the
       runs.clear();
       return;
   }
-  runs.resize(N - 1);
   Point3i pt = _runs.at<Point3i>(0);
   theSize.width = pt.x;
   theSize.height = pt.y;
 
-  for (int i = 1; i < N; ++i)
-  {
-    pt = _runs.at<Point3i>(i);
-    runs[i-1] = rlType(pt.x, pt.y, pt.z);
-  }
+  // no run follows the header for an empty image, at<>(1) would be out of range
+  const rlType* pRuns = (const rlType*) (_runs.ptr<Point3i>() + 1);
+  runs.assign(pRuns, pRuns + N - 1);
 }
 
 static void sortChords(rlVec& lChords)
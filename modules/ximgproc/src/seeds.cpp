@@ -123,6 +123,12 @@ private:
     //main loop for block updates
     void updateBlocks(int level, float req_confidence = 0.0f);
 
+    // run func(y_begin, y_end, band, owner) on horizontal bands of a grid of top level labels
+    // (the labels or a parent level). Bands of the same parity are processed in parallel,
+    // owner[label] is the only band allowed to update label in the current pass, or -1
+    template<typename Func>
+    void parallelBands(const int* grid, int grid_width, int grid_height, const Func& func);
+
     /* go to next block level */
     int goDownOneLevel();
 
@@ -473,135 +479,217 @@ void SuperpixelSEEDSImpl::computeHistograms(int until_level)
 
 void SuperpixelSEEDSImpl::updateBlocks(int level, float req_confidence)
 {
-    int labelA;
-    int labelB;
-    int sublabel;
-    bool done;
     int step = nr_wh[2 * level];
+    int nr_h = nr_wh[2 * level + 1];
 
     // horizontal bidirectional block updating
-    for (int y = 1; y < nr_wh[2 * level + 1] - 1; y++)
+    parallelBands(parent[level], step, nr_h, [&](int y_begin, int y_end, int band, const vector<int>& owner)
     {
-        for (int x = 1; x < nr_wh[2 * level] - 2; x++)
+        int labelA;
+        int labelB;
+        int sublabel;
+        bool done;
+        for (int y = std::max(y_begin, 1); y < std::min(y_end, nr_h - 1); y++)
         {
-            // choose a label at the current level
-            sublabel = y * step + x;
-            // get the label at the top level (= superpixel label)
-            labelA = parent[level][y * step + x];
-            // get the neighboring label at the top level (= superpixel label)
-            labelB = parent[level][y * step + x + 1];
-
-            if( labelA == labelB )
-                continue;
-
-            // get the surrounding labels at the top level, to check for splitting
-            int a11 = parent[level][(y - 1) * step + (x - 1)];
-            int a12 = parent[level][(y - 1) * step + (x)];
-            int a21 = parent[level][(y) * step + (x - 1)];
-            int a22 = parent[level][(y) * step + (x)];
-            int a31 = parent[level][(y + 1) * step + (x - 1)];
-            int a32 = parent[level][(y + 1) * step + (x)];
-            done = false;
-
-            if( nr_partitions[labelA] == 2 || (nr_partitions[labelA] > 2 // 3 or more partitions
-                    && checkSplit_hf(a11, a12, a21, a22, a31, a32)) )
+            for (int x = 1; x < nr_wh[2 * level] - 2; x++)
             {
-                // run algorithm as usual
-                float conf = intersectConf(seeds_top_level, labelB, labelA, level, sublabel);
-                if( conf > req_confidence )
+                // choose a label at the current level
+                sublabel = y * step + x;
+                // get the label at the top level (= superpixel label)
+                labelA = parent[level][y * step + x];
+                // get the neighboring label at the top level (= superpixel label)
+                labelB = parent[level][y * step + x + 1];
+
+                if( labelA == labelB || owner[labelA] != band || owner[labelB] != band )
+                    continue;
+
+                // get the surrounding labels at the top level, to check for splitting
+                int a11 = parent[level][(y - 1) * step + (x - 1)];
+                int a12 = parent[level][(y - 1) * step + (x)];
+                int a21 = parent[level][(y) * step + (x - 1)];
+                int a22 = parent[level][(y) * step + (x)];
+                int a31 = parent[level][(y + 1) * step + (x - 1)];
+                int a32 = parent[level][(y + 1) * step + (x)];
+                done = false;
+
+                if( nr_partitions[labelA] == 2 || (nr_partitions[labelA] > 2 // 3 or more partitions
+                        && checkSplit_hf(a11, a12, a21, a22, a31, a32)) )
                 {
-                    deleteBlockToplevel(labelA, level, sublabel);
-                    addBlockToplevel(labelB, level, sublabel);
-                    done = true;
+                    // run algorithm as usual
+                    float conf = intersectConf(seeds_top_level, labelB, labelA, level, sublabel);
+                    if( conf > req_confidence )
+                    {
+                        deleteBlockToplevel(labelA, level, sublabel);
+                        addBlockToplevel(labelB, level, sublabel);
+                        done = true;
+                    }
+                }
+
+                if( !done && (nr_partitions[labelB] > MINIMUM_NR_SUBLABELS) )
+                {
+                    // try opposite direction
+                    sublabel = y * step + x + 1;
+                    int a13 = parent[level][(y - 1) * step + (x + 1)];
+                    int a14 = parent[level][(y - 1) * step + (x + 2)];
+                    int a23 = parent[level][(y) * step + (x + 1)];
+                    int a24 = parent[level][(y) * step + (x + 2)];
+                    int a33 = parent[level][(y + 1) * step + (x + 1)];
+                    int a34 = parent[level][(y + 1) * step + (x + 2)];
+                    if( nr_partitions[labelB] <= 2 // == 2
+                            || (nr_partitions[labelB] > 2 && checkSplit_hb(a13, a14, a23, a24, a33, a34)) )
+                    {
+                        // run algorithm as usual
+                        float conf = intersectConf(seeds_top_level, labelA, labelB, level, sublabel);
+                        if( conf > req_confidence )
+                        {
+                            deleteBlockToplevel(labelB, level, sublabel);
+                            addBlockToplevel(labelA, level, sublabel);
+                            x++;
+                        }
+                    }
                 }
             }
+        }
+
+    });
 
-            if( !done && (nr_partitions[labelB] > MINIMUM_NR_SUBLABELS) )
+    // vertical bidirectional
+    parallelBands(parent[level], step, nr_h, [&](int y_begin, int y_end, int band, const vector<int>& owner)
+    {
+        int labelA;
+        int labelB;
+        int sublabel;
+        bool done;
+        for (int x = 1; x < nr_wh[2 * level] - 1; x++)
+        {
+            for (int y = std::max(y_begin, 1); y < std::min(y_end, nr_h - 2); y++)
             {
-                // try opposite direction
-                sublabel = y * step + x + 1;
+                // choose a label at the current level
+                sublabel = y * step + x;
+                // get the label at the top level (= superpixel label)
+                labelA = parent[level][y * step + x];
+                // get the neighboring label at the top level (= superpixel label)
+                labelB = parent[level][(y + 1) * step + x];
+
+                if( labelA == labelB || owner[labelA] != band || owner[labelB] != band )
+                    continue;
+
+                int a11 = parent[level][(y - 1) * step + (x - 1)];
+                int a12 = parent[level][(y - 1) * step + (x)];
                 int a13 = parent[level][(y - 1) * step + (x + 1)];
-                int a14 = parent[level][(y - 1) * step + (x + 2)];
+                int a21 = parent[level][(y) * step + (x - 1)];
+                int a22 = parent[level][(y) * step + (x)];
                 int a23 = parent[level][(y) * step + (x + 1)];
-                int a24 = parent[level][(y) * step + (x + 2)];
-                int a33 = parent[level][(y + 1) * step + (x + 1)];
-                int a34 = parent[level][(y + 1) * step + (x + 2)];
-                if( nr_partitions[labelB] <= 2 // == 2
-                        || (nr_partitions[labelB] > 2 && checkSplit_hb(a13, a14, a23, a24, a33, a34)) )
+
+                done = false;
+                if( nr_partitions[labelA] == 2 || (nr_partitions[labelA] > 2 // 3 or more partitions
+                        && checkSplit_vf(a11, a12, a13, a21, a22, a23)) )
                 {
                     // run algorithm as usual
-                    float conf = intersectConf(seeds_top_level, labelA, labelB, level, sublabel);
+                    float conf = intersectConf(seeds_top_level, labelB, labelA, level, sublabel);
                     if( conf > req_confidence )
                     {
-                        deleteBlockToplevel(labelB, level, sublabel);
-                        addBlockToplevel(labelA, level, sublabel);
-                        x++;
+                        deleteBlockToplevel(labelA, level, sublabel);
+                        addBlockToplevel(labelB, level, sublabel);
+                        done = true;
+                    }
+                }
+
+                if( !done && (nr_partitions[labelB] > MINIMUM_NR_SUBLABELS) )
+                {
+                    // try opposite direction
+                    sublabel = (y + 1) * step + x;
+                    int a31 = parent[level][(y + 1) * step + (x - 1)];
+                    int a32 = parent[level][(y + 1) * step + (x)];
+                    int a33 = parent[level][(y + 1) * step + (x + 1)];
+                    int a41 = parent[level][(y + 2) * step + (x - 1)];
+                    int a42 = parent[level][(y + 2) * step + (x)];
+                    int a43 = parent[level][(y + 2) * step + (x + 1)];
+                    if( nr_partitions[labelB] <= 2 // == 2
+                            || (nr_partitions[labelB] > 2 && checkSplit_vb(a31, a32, a33, a41, a42, a43)) )
+                    {
+                        // run algorithm as usual
+                        float conf = intersectConf(seeds_top_level, labelA, labelB, level, sublabel);
+                        if( conf > req_confidence )
+                        {
+                            deleteBlockToplevel(labelB, level, sublabel);
+                            addBlockToplevel(labelA, level, sublabel);
+                            y++;
+                        }
                     }
                 }
             }
         }
-    }
+    });
+}
 
-    // vertical bidirectional
-    for (int x = 1; x < nr_wh[2 * level] - 1; x++)
+template<typename Func>
+void SuperpixelSEEDSImpl::parallelBands(const int* grid, int grid_width, int grid_height,
+        const Func& func)
+{
+    /* The grid is split in bands about two superpixels high, which do not depend on the number
+     * of threads so that the result is deterministic. An update reads the rows next to the
+     * updated ones and, in the vertical direction, writes the first row of the next band, so
+     * bands processed together are separated by a band of at least 3 rows. A superpixel
+     * histogram is only modified by the band owning it: the single band of the current parity
+     * the superpixel was spanning when the pass started. */
+    int nr_labels = nrLabels(seeds_top_level);
+    int band_height = std::max(3, 2 * grid_height / nr_wh[2 * seeds_top_level + 1]);
+    int nr_bands = std::max(1, grid_height / band_height);
+
+    vector<uchar> present((size_t)nr_bands * nr_labels);
+    vector<int> first_band(nr_labels), last_band(nr_labels);
+    vector<int> owner(nr_labels);
+
+    for (int parity = 0; parity < 2 && parity < nr_bands; parity++)
     {
-        for (int y = 1; y < nr_wh[2 * level + 1] - 2; y++)
+        // find the bands spanned by each superpixel
+        std::fill(present.begin(), present.end(), (uchar)0);
+        parallel_for_(Range(0, nr_bands), [&](const Range& range)
         {
-            // choose a label at the current level
-            sublabel = y * step + x;
-            // get the label at the top level (= superpixel label)
-            labelA = parent[level][y * step + x];
-            // get the neighboring label at the top level (= superpixel label)
-            labelB = parent[level][(y + 1) * step + x];
-
-            if( labelA == labelB )
-                continue;
-
-            int a11 = parent[level][(y - 1) * step + (x - 1)];
-            int a12 = parent[level][(y - 1) * step + (x)];
-            int a13 = parent[level][(y - 1) * step + (x + 1)];
-            int a21 = parent[level][(y) * step + (x - 1)];
-            int a22 = parent[level][(y) * step + (x)];
-            int a23 = parent[level][(y) * step + (x + 1)];
-
-            done = false;
-            if( nr_partitions[labelA] == 2 || (nr_partitions[labelA] > 2 // 3 or more partitions
-                    && checkSplit_vf(a11, a12, a13, a21, a22, a23)) )
+            for (int band = range.start; band < range.end; band++)
             {
-                // run algorithm as usual
-                float conf = intersectConf(seeds_top_level, labelB, labelA, level, sublabel);
-                if( conf > req_confidence )
+                uchar* band_present = &present[(size_t)band * nr_labels];
+                int y_end = (band + 1) * grid_height / nr_bands;
+                for (int y = band * grid_height / nr_bands; y < y_end; y++)
                 {
-                    deleteBlockToplevel(labelA, level, sublabel);
-                    addBlockToplevel(labelB, level, sublabel);
-                    done = true;
+                    const int* row = grid + y * grid_width;
+                    for (int x = 0; x < grid_width; x++)
+                        band_present[row[x]] = 1;
                 }
             }
+        });
 
-            if( !done && (nr_partitions[labelB] > MINIMUM_NR_SUBLABELS) )
+        std::fill(first_band.begin(), first_band.end(), nr_bands);
+        std::fill(last_band.begin(), last_band.end(), -1);
+        for (int band = 0; band < nr_bands; band++)
+        {
+            const uchar* band_present = &present[(size_t)band * nr_labels];
+            for (int label = 0; label < nr_labels; label++)
             {
-                // try opposite direction
-                sublabel = (y + 1) * step + x;
-                int a31 = parent[level][(y + 1) * step + (x - 1)];
-                int a32 = parent[level][(y + 1) * step + (x)];
-                int a33 = parent[level][(y + 1) * step + (x + 1)];
-                int a41 = parent[level][(y + 2) * step + (x - 1)];
-                int a42 = parent[level][(y + 2) * step + (x)];
-                int a43 = parent[level][(y + 2) * step + (x + 1)];
-                if( nr_partitions[labelB] <= 2 // == 2
-                        || (nr_partitions[labelB] > 2 && checkSplit_vb(a31, a32, a33, a41, a42, a43)) )
+                if( band_present[label] )
                 {
-                    // run algorithm as usual
-                    float conf = intersectConf(seeds_top_level, labelA, labelB, level, sublabel);
-                    if( conf > req_confidence )
-                    {
-                        deleteBlockToplevel(labelB, level, sublabel);
-                        addBlockToplevel(labelA, level, sublabel);
-                        y++;
-                    }
+                    first_band[label] = std::min(first_band[label], band);
+                    last_band[label] = band;
                 }
             }
         }
+
+        for (int label = 0; label < nr_labels; label++)
+        {
+            int band = first_band[label] + ((first_band[label] + parity) & 1);
+            owner[label] = (band <= last_band[label] && band + 2 > last_band[label]) ? band : -1;
+        }
+
+        parallel_for_(Range(0, (nr_bands - parity + 1) / 2), [&](const Range& range)
+        {
+            for (int i = range.start; i < range.end; i++)
+            {
+                int band = 2 * i + parity;
+                func(band * grid_height / nr_bands, (band + 1) * grid_height / nr_bands,
+                        band, owner);
+            }
+        });
     }
 }
 
@@ -637,197 +725,210 @@ int SuperpixelSEEDSImpl::goDownOneLevel()
 
 void SuperpixelSEEDSImpl::updatePixels()
 {
-    int labelA;
-    int labelB;
-    int priorA = 0;
-    int priorB = 0;
-
-    for (int y = 1; y < height - 1; y++)
+    // horizontal bidirectional pixel updating
+    parallelBands(labels, width, height, [&](int y_begin, int y_end, int band, const vector<int>& owner)
     {
-        for (int x = 1; x < width - 2; x++)
+        int labelA;
+        int labelB;
+        int priorA = 0;
+        int priorB = 0;
+        for (int y = std::max(y_begin, 1); y < std::min(y_end, height - 1); y++)
         {
+            for (int x = 1; x < width - 2; x++)
+            {
 
-            labelA = labels[(y) * width + (x)];
-            labelB = labels[(y) * width + (x + 1)];
+                labelA = labels[(y) * width + (x)];
+                labelB = labels[(y) * width + (x + 1)];
 
-            if( labelA != labelB )
-            {
-                int a22 = labelA;
-                int a23 = labelB;
-                if( forwardbackward )
+                if( labelA != labelB && owner[labelA] == band && owner[labelB] == band )
                 {
-                    // horizontal bidirectional
-                    int a11 = labels[(y - 1) * width + (x - 1)];
-                    int a12 = labels[(y - 1) * width + (x)];
-                    int a21 = labels[(y) * width + (x - 1)];
-                    int a31 = labels[(y + 1) * width + (x - 1)];
-                    int a32 = labels[(y + 1) * width + (x)];
-                    if( checkSplit_hf(a11, a12, a21, a22, a31, a32) )
+                    int a22 = labelA;
+                    int a23 = labelB;
+                    if( forwardbackward )
                     {
-                        if( seeds_prior )
+                        // horizontal bidirectional
+                        int a11 = labels[(y - 1) * width + (x - 1)];
+                        int a12 = labels[(y - 1) * width + (x)];
+                        int a21 = labels[(y) * width + (x - 1)];
+                        int a31 = labels[(y + 1) * width + (x - 1)];
+                        int a32 = labels[(y + 1) * width + (x)];
+                        if( checkSplit_hf(a11, a12, a21, a22, a31, a32) )
                         {
-                            priorA = threebyfour(x, y, labelA);
-                            priorB = threebyfour(x, y, labelB);
-                        }
+                            if( seeds_prior )
+                            {
+                                priorA = threebyfour(x, y, labelA);
+                                priorB = threebyfour(x, y, labelB);
+                            }
 
-                        if( probability(y * width + x, labelA, labelB, priorA, priorB) )
-                        {
-                            update(labelB, y * width + x, labelA);
-                        }
-                        else
-                        {
-                            int a13 = labels[(y - 1) * width + (x + 1)];
-                            int a14 = labels[(y - 1) * width + (x + 2)];
-                            int a24 = labels[(y) * width + (x + 2)];
-                            int a33 = labels[(y + 1) * width + (x + 1)];
-                            int a34 = labels[(y + 1) * width + (x + 2)];
-                            if( checkSplit_hb(a13, a14, a23, a24, a33, a34) )
+                            if( probability(y * width + x, labelA, labelB, priorA, priorB) )
+                            {
+                                update(labelB, y * width + x, labelA);
+                            }
+                            else
                             {
-                                if( probability(y * width + x + 1, labelB, labelA, priorB, priorA) )
+                                int a13 = labels[(y - 1) * width + (x + 1)];
+                                int a14 = labels[(y - 1) * width + (x + 2)];
+                                int a24 = labels[(y) * width + (x + 2)];
+                                int a33 = labels[(y + 1) * width + (x + 1)];
+                                int a34 = labels[(y + 1) * width + (x + 2)];
+                                if( checkSplit_hb(a13, a14, a23, a24, a33, a34) )
                                 {
-                                    update(labelA, y * width + x + 1, labelB);
-                                    x++;
+                                    if( probability(y * width + x + 1, labelB, labelA, priorB, priorA) )
+                                    {
+                                        update(labelA, y * width + x + 1, labelB);
+                                        x++;
+                                    }
                                 }
                             }
                         }
                     }
-                }
-                else
-                { // forward backward
-                    // horizontal bidirectional
-                    int a13 = labels[(y - 1) * width + (x + 1)];
-                    int a14 = labels[(y - 1) * width + (x + 2)];
-                    int a24 = labels[(y) * width + (x + 2)];
-                    int a33 = labels[(y + 1) * width + (x + 1)];
-                    int a34 = labels[(y + 1) * width + (x + 2)];
-                    if( checkSplit_hb(a13, a14, a23, a24, a33, a34) )
-                    {
-                        if( seeds_prior )
+                    else
+                    { // forward backward
+                        // horizontal bidirectional
+                        int a13 = labels[(y - 1) * width + (x + 1)];
+                        int a14 = labels[(y - 1) * width + (x + 2)];
+                        int a24 = labels[(y) * width + (x + 2)];
+                        int a33 = labels[(y + 1) * width + (x + 1)];
+                        int a34 = labels[(y + 1) * width + (x + 2)];
+                        if( checkSplit_hb(a13, a14, a23, a24, a33, a34) )
                         {
-                            priorA = threebyfour(x, y, labelA);
-                            priorB = threebyfour(x, y, labelB);
-                        }
+                            if( seeds_prior )
+                            {
+                                priorA = threebyfour(x, y, labelA);
+                                priorB = threebyfour(x, y, labelB);
+                            }
 
-                        if( probability(y * width + x + 1, labelB, labelA, priorB, priorA) )
-                        {
-                            update(labelA, y * width + x + 1, labelB);
-                            x++;
-                        }
-                        else
-                        {
-                            int a11 = labels[(y - 1) * width + (x - 1)];
-                            int a12 = labels[(y - 1) * width + (x)];
-                            int a21 = labels[(y) * width + (x - 1)];
-                            int a31 = labels[(y + 1) * width + (x - 1)];
-                            int a32 = labels[(y + 1) * width + (x)];
-                            if( checkSplit_hf(a11, a12, a21, a22, a31, a32) )
+                            if( probability(y * width + x + 1, labelB, labelA, priorB, priorA) )
                             {
-                                if( probability(y * width + x, labelA, labelB, priorA, priorB) )
+                                update(labelA, y * width + x + 1, labelB);
+                                x++;
+                            }
+                            else
+                            {
+                                int a11 = labels[(y - 1) * width + (x - 1)];
+                                int a12 = labels[(y - 1) * width + (x)];
+                                int a21 = labels[(y) * width + (x - 1)];
+                                int a31 = labels[(y + 1) * width + (x - 1)];
+                                int a32 = labels[(y + 1) * width + (x)];
+                                if( checkSplit_hf(a11, a12, a21, a22, a31, a32) )
                                 {
-                                    update(labelB, y * width + x, labelA);
+                                    if( probability(y * width + x, labelA, labelB, priorA, priorB) )
+                                    {
+                                        update(labelB, y * width + x, labelA);
+                                    }
                                 }
                             }
                         }
                     }
-                }
-            } // labelA != labelB
-        } // for x
-    } // for y
+                } // labelA != labelB
+            } // for x
+        } // for y
+    });
 
-    for (int x = 1; x < width - 1; x++)
+    // vertical bidirectional pixel updating
+    parallelBands(labels, width, height, [&](int y_begin, int y_end, int band, const vector<int>& owner)
     {
-        for (int y = 1; y < height - 2; y++)
+        int labelA;
+        int labelB;
+        int priorA = 0;
+        int priorB = 0;
+        for (int x = 1; x < width - 1; x++)
         {
-
-            labelA = labels[(y) * width + (x)];
-            labelB = labels[(y + 1) * width + (x)];
-            if( labelA != labelB )
+            for (int y = std::max(y_begin, 1); y < std::min(y_end, height - 2); y++)
             {
-                int a22 = labelA;
-                int a32 = labelB;
 
-                if( forwardbackward )
+                labelA = labels[(y) * width + (x)];
+                labelB = labels[(y + 1) * width + (x)];
+                if( labelA != labelB && owner[labelA] == band && owner[labelB] == band )
                 {
-                    // vertical bidirectional
-                    int a11 = labels[(y - 1) * width + (x - 1)];
-                    int a12 = labels[(y - 1) * width + (x)];
-                    int a13 = labels[(y - 1) * width + (x + 1)];
-                    int a21 = labels[(y) * width + (x - 1)];
-                    int a23 = labels[(y) * width + (x + 1)];
-                    if( checkSplit_vf(a11, a12, a13, a21, a22, a23) )
+                    int a22 = labelA;
+                    int a32 = labelB;
+
+                    if( forwardbackward )
                     {
-                        if( seeds_prior )
+                        // vertical bidirectional
+                        int a11 = labels[(y - 1) * width + (x - 1)];
+                        int a12 = labels[(y - 1) * width + (x)];
+                        int a13 = labels[(y - 1) * width + (x + 1)];
+                        int a21 = labels[(y) * width + (x - 1)];
+                        int a23 = labels[(y) * width + (x + 1)];
+                        if( checkSplit_vf(a11, a12, a13, a21, a22, a23) )
                         {
-                            priorA = fourbythree(x, y, labelA);
-                            priorB = fourbythree(x, y, labelB);
-                        }
+                            if( seeds_prior )
+                            {
+                                priorA = fourbythree(x, y, labelA);
+                                priorB = fourbythree(x, y, labelB);
+                            }
 
-                        if( probability(y * width + x, labelA, labelB, priorA, priorB) )
-                        {
-                            update(labelB, y * width + x, labelA);
-                        }
-                        else
-                        {
-                            int a31 = labels[(y + 1) * width + (x - 1)];
-                            int a33 = labels[(y + 1) * width + (x + 1)];
-                            int a41 = labels[(y + 2) * width + (x - 1)];
-                            int a42 = labels[(y + 2) * width + (x)];
-                            int a43 = labels[(y + 2) * width + (x + 1)];
-                            if( checkSplit_vb(a31, a32, a33, a41, a42, a43) )
+                            if( probability(y * width + x, labelA, labelB, priorA, priorB) )
                             {
-                                if( probability((y + 1) * width + x, labelB, labelA, priorB, priorA) )
+                                update(labelB, y * width + x, labelA);
+                            }
+                            else
+                            {
+                                int a31 = labels[(y + 1) * width + (x - 1)];
+                                int a33 = labels[(y + 1) * width + (x + 1)];
+                                int a41 = labels[(y + 2) * width + (x - 1)];
+                                int a42 = labels[(y + 2) * width + (x)];
+                                int a43 = labels[(y + 2) * width + (x + 1)];
+                                if( checkSplit_vb(a31, a32, a33, a41, a42, a43) )
                                 {
-                                    update(labelA, (y + 1) * width + x, labelB);
-                                    y++;
+                                    if( probability((y + 1) * width + x, labelB, labelA, priorB, priorA) )
+                                    {
+                                        update(labelA, (y + 1) * width + x, labelB);
+                                        y++;
+                                    }
                                 }
                             }
                         }
                     }
-                }
-                else
-                { // forwardbackward
-                    // vertical bidirectional
-                    int a31 = labels[(y + 1) * width + (x - 1)];
-                    int a33 = labels[(y + 1) * width + (x + 1)];
-                    int a41 = labels[(y + 2) * width + (x - 1)];
-                    int a42 = labels[(y + 2) * width + (x)];
-                    int a43 = labels[(y + 2) * width + (x + 1)];
-                    if( checkSplit_vb(a31, a32, a33, a41, a42, a43) )
-                    {
-                        if( seeds_prior )
+                    else
+                    { // forwardbackward
+                        // vertical bidirectional
+                        int a31 = labels[(y + 1) * width + (x - 1)];
+                        int a33 = labels[(y + 1) * width + (x + 1)];
+                        int a41 = labels[(y + 2) * width + (x - 1)];
+                        int a42 = labels[(y + 2) * width + (x)];
+                        int a43 = labels[(y + 2) * width + (x + 1)];
+                        if( checkSplit_vb(a31, a32, a33, a41, a42, a43) )
                         {
-                            priorA = fourbythree(x, y, labelA);
-                            priorB = fourbythree(x, y, labelB);
-                        }
+                            if( seeds_prior )
+                            {
+                                priorA = fourbythree(x, y, labelA);
+                                priorB = fourbythree(x, y, labelB);
+                            }
 
-                        if( probability((y + 1) * width + x, labelB, labelA, priorB, priorA) )
-                        {
-                            update(labelA, (y + 1) * width + x, labelB);
-                            y++;
-                        }
-                        else
-                        {
-                            int a11 = labels[(y - 1) * width + (x - 1)];
-                            int a12 = labels[(y - 1) * width + (x)];
-                            int a13 = labels[(y - 1) * width + (x + 1)];
-                            int a21 = labels[(y) * width + (x - 1)];
-                            int a23 = labels[(y) * width + (x + 1)];
-                            if( checkSplit_vf(a11, a12, a13, a21, a22, a23) )
+                            if( probability((y + 1) * width + x, labelB, labelA, priorB, priorA) )
                             {
-                                if( probability(y * width + x, labelA, labelB, priorA, priorB) )
+                                update(labelA, (y + 1) * width + x, labelB);
+                                y++;
+                            }
+                            else
+                            {
+                                int a11 = labels[(y - 1) * width + (x - 1)];
+                                int a12 = labels[(y - 1) * width + (x)];
+                                int a13 = labels[(y - 1) * width + (x + 1)];
+                                int a21 = labels[(y) * width + (x - 1)];
+                                int a23 = labels[(y) * width + (x + 1)];
+                                if( checkSplit_vf(a11, a12, a13, a21, a22, a23) )
                                 {
-                                    update(labelB, y * width + x, labelA);
+                                    if( probability(y * width + x, labelA, labelB, priorA, priorB) )
+                                    {
+                                        update(labelB, y * width + x, labelA);
+                                    }
                                 }
                             }
                         }
                     }
-                }
-            } // labelA != labelB
-        } // for y
-    } // for x
+                } // labelA != labelB
+            } // for y
+        } // for x
+    });
     forwardbackward = !forwardbackward;
 
     // update border pixels
+    int labelA;
+    int labelB;
     for (int x = 0; x < width; x++)
     {
         labelA = labels[x];
@@ -937,8 +1038,11 @@ void SuperpixelSEEDSImpl::deleteBlockToplevel(int label, int sublevel, int subla
 
 void SuperpixelSEEDSImpl::updateLabels()
 {
-    for (int i = 0; i < width * height; ++i)
-        labels[i] = parent[0][labels_bottom[i]];
+    parallel_for_(Range(0, height), [&](const Range& range)
+    {
+        for (int i = range.start * width; i < range.end * width; ++i)
+            labels[i] = parent[0][labels_bottom[i]];
+    });
 }
 
 bool SuperpixelSEEDSImpl::probability(int image_idx, int label1, int label2,
@@ -42,6 +42,7 @@ the use of this software, even if advised of the possibility of such damage.
 #include "opencv2/ximgproc/segmentation.hpp"
 
 #include <iostream>
+#include <queue>
 
 namespace cv {
     namespace ximgproc {
@@ -111,6 +112,17 @@ namespace cv {
                     }
             };
 
+            // Initial segmentation of an image by a graph segmentation, shared by all strategies
+            struct BaseSegmentation {
+                Mat img_regions;
+                Mat_<char> is_neighbour;
+                Mat_<int> sizes;
+                int nb_segs;
+                std::vector<Rect> bounding_rects;
+
+                BaseSegmentation() : nb_segs(0) {}
+            };
+
             /****************************************
              * Stragegy / Color
              ***************************************/
@@ -146,54 +158,73 @@ namespace cv {
 
                 if (image_id == -1 || last_image_id != image_id) {
 
-                    std::vector<Mat> img_planes;
-                    split(img, img_planes);
-
                     int histogram_bins_size = 25;
 
-                    float range[] = {0, 256};
-                    const float* histogram_ranges = {range};
-
                     double min, max;
                     minMaxLoc(regions, &min, &max);
                     int nb_segs = (int)max + 1;
 
-                    histogram_size = histogram_bins_size * img.channels();
-
-                    histograms = Mat_<float>(nb_segs, histogram_size);
-
-                    for (int r = 0; r < nb_segs; r++) {
-
-                        // Generate mask
-                        Mat mask = regions == r;
-
-                        // Compute histogram for each channels
-                        float tt = 0;
+                    int channels = img.channels();
+                    histogram_size = histogram_bins_size * channels;
 
-                        Mat tmp_hists = Mat(histogram_size, 1, CV_32F);
-                        float *tmp_histogram = tmp_hists.ptr<float>(0);
-                        int h_pos = 0;
-                        Mat tmp_hist;
+                    // Bins of all regions are accumulated in a single pass over the image, the same way
+                    // calcHist would do with uniform bins over [0, 256) and a mask for each region
+                    Mat_<int> tmp_histograms = Mat_<int>::zeros(nb_segs, histogram_size);
 
-                        for (int p = 0; p < img.channels(); p++) {
+                    if (img.depth() == CV_8U) {
+                        int bins[256];
+                        for (int v = 0; v < 256; v++) {
+                            bins[v] = v * histogram_bins_size / 256;
+                        }
 
-                            calcHist(&img_planes[p], 1, 0, mask, tmp_hist, 1, &histogram_bins_size, &histogram_ranges);
+                        for (int i = 0; i < img.rows; i++) {
+                            const uchar* p = img.ptr<uchar>(i);
+                            const int* r = regions.ptr<int>(i);
 
-                            float *tmp_hist_ = tmp_hist.ptr<float>(0);
+                            for (int j = 0; j < img.cols; j++) {
+                                int* histogram = tmp_histograms.ptr<int>(r[j]);
 
-                            // Copy local histogram to global histogram
-                            for (int pos = 0; pos < histogram_bins_size; pos++) {
-                                tmp_histogram[pos + h_pos] = tmp_hist_[pos];
-                                tt += tmp_histogram[pos + h_pos];
+                                for (int c = 0; c < channels; c++) {
+                                    histogram[c * histogram_bins_size + bins[p[j * channels + c]]]++;
+                                }
                             }
-                            h_pos += histogram_bins_size;
                         }
+                    } else {
+                        Mat img_float;
+                        img.convertTo(img_float, CV_32F);
+                        double scale = histogram_bins_size / 256.0;
+
+                        for (int i = 0; i < img_float.rows; i++) {
+                            const float* p = img_float.ptr<float>(i);
+                            const int* r = regions.ptr<int>(i);
+
+                            for (int j = 0; j < img_float.cols; j++) {
+                                int* histogram = tmp_histograms.ptr<int>(r[j]);
+
+                                for (int c = 0; c < channels; c++) {
+                                    int bin = cvFloor(p[j * channels + c] * scale);
+                                    if ((unsigned)bin < (unsigned)histogram_bins_size) {
+                                        histogram[c * histogram_bins_size + bin]++;
+                                    }
+                                }
+                            }
+                        }
+                    }
 
-                        // Normalize historgrams
+                    // Normalize historgrams
+                    histograms = Mat_<float>(nb_segs, histogram_size);
+
+                    for (int r = 0; r < nb_segs; r++) {
+                        const int* tmp_histogram = tmp_histograms.ptr<int>(r);
                         float* histogram = histograms.ptr<float>(r);
 
-                        for (int h_pos2 = 0; h_pos2 < histogram_size; h_pos2++) {
-                            histogram[h_pos2] = tmp_histogram[h_pos2] / tt;
+                        float tt = 0;
+                        for (int h_pos = 0; h_pos < histogram_size; h_pos++) {
+                            tt += (float)tmp_histogram[h_pos];
+                        }
+
+                        for (int h_pos = 0; h_pos < histogram_size; h_pos++) {
+                            histogram[h_pos] = (float)tmp_histogram[h_pos] / tt;
                         }
                     }
 
@@ -258,6 +289,8 @@ namespace cv {
                     virtual void addStrategy(Ptr<SelectiveSearchSegmentationStrategy> g, float weight) CV_OVERRIDE;
                     virtual void clearStrategies() CV_OVERRIDE;
 
+                    const std::vector<Ptr<SelectiveSearchSegmentationStrategy> >& getStrategies() const { return strategies; }
+
                 private:
                     String name_;
                     std::vector<Ptr<SelectiveSearchSegmentationStrategy> > strategies;
@@ -731,7 +764,7 @@ namespace cv {
                     std::vector<Ptr<GraphSegmentation> > segmentations;
                     std::vector<Ptr<SelectiveSearchSegmentationStrategy> > strategies;
 
-                    void hierarchicalGrouping(const Mat& img, Ptr<SelectiveSearchSegmentationStrategy>& s, const Mat& img_regions, const Mat_<char>& is_neighbour, const Mat_<int>& sizes, int& nb_segs, const std::vector<Rect>& bounding_rects, std::vector<Region>& regions, int region_id);
+                    void hierarchicalGrouping(const Mat& img, Ptr<SelectiveSearchSegmentationStrategy>& s, const Mat& img_regions, const Mat_<char>& is_neighbour, const Mat_<int>& sizes, int nb_segs, const std::vector<Rect>& bounding_rects, std::vector<Region>& regions, int region_id);
             };
 
             void SelectiveSearchSegmentationImpl::setBaseImage(InputArray img) {
@@ -884,76 +917,139 @@ namespace cv {
                 addStrategy(size3);
             }
 
-            void SelectiveSearchSegmentationImpl::process(std::vector<Rect>& rects) {
+            static void computeBaseSegmentation(const Mat& image, const Ptr<GraphSegmentation>& gs, BaseSegmentation& base) {
 
-                std::vector<Region> all_regions;
+                // Compute initial segmentation
+                gs->processImage(image, base.img_regions);
 
-                int image_id = 0;
+                const Mat& img_regions = base.img_regions;
 
-                for(std::vector<Mat>::iterator image = images.begin(); image != images.end(); ++image) {
-                    for(std::vector<Ptr<GraphSegmentation> >::iterator gs = segmentations.begin(); gs != segmentations.end(); ++gs) {
+                // Get number of regions
+                double min, max;
+                minMaxLoc(img_regions, &min, &max);
+                int nb_segs = (int)max + 1;
+                base.nb_segs = nb_segs;
 
-                        Mat img_regions;
-                        Mat_<char> is_neighbour;
-                        Mat_<int> sizes;
+                // Compute bouding rects and neighbours
+                base.bounding_rects.resize(nb_segs);
 
-                        // Compute initial segmentation
-                        (*gs)->processImage(*image, img_regions);
+                std::vector<std::vector<cv::Point> > points;
 
-                        // Get number of regions
-                        double min, max;
-                        minMaxLoc(img_regions, &min, &max);
-                        int nb_segs = (int)max + 1;
+                points.resize(nb_segs);
 
-                        // Compute bouding rects and neighbours
-                        std::vector<Rect> bounding_rects;
-                        bounding_rects.resize(nb_segs);
+                base.is_neighbour = Mat::zeros(nb_segs, nb_segs, CV_8UC1);
+                base.sizes = Mat::zeros(nb_segs, 1, CV_32SC1);
 
-                        std::vector<std::vector<cv::Point> > points;
+                Mat_<char>& is_neighbour = base.is_neighbour;
+                Mat_<int>& sizes = base.sizes;
 
-                        points.resize(nb_segs);
+                const int* previous_p = NULL;
 
-                        is_neighbour = Mat::zeros(nb_segs, nb_segs, CV_8UC1);
-                        sizes = Mat::zeros(nb_segs, 1, CV_32SC1);
+                for (int i = 0; i < (int)img_regions.rows; i++) {
+                    const int* p = img_regions.ptr<int>(i);
 
-                        const int* previous_p = NULL;
+                    for (int j = 0; j < (int)img_regions.cols; j++) {
 
-                        for (int i = 0; i < (int)img_regions.rows; i++) {
-                            const int* p = img_regions.ptr<int>(i);
+                        points[p[j]].push_back(cv::Point(j, i));
+                        sizes.at<int>(p[j], 0) = sizes.at<int>(p[j], 0) + 1;
 
-                            for (int j = 0; j < (int)img_regions.cols; j++) {
+                        if (i > 0 && j > 0) {
 
-                                points[p[j]].push_back(cv::Point(j, i));
-                                sizes.at<int>(p[j], 0) = sizes.at<int>(p[j], 0) + 1;
+                            is_neighbour.at<char>(p[j], p[j - 1]) = 1;
+                            is_neighbour.at<char>(p[j], previous_p[j]) = 1;
+                            is_neighbour.at<char>(p[j], previous_p[j - 1]) = 1;
 
-                                if (i > 0 && j > 0) {
+                            is_neighbour.at<char>(p[j - 1], p[j]) = 1;
+                            is_neighbour.at<char>(previous_p[j], p[j]) = 1;
+                            is_neighbour.at<char>(previous_p[j - 1], p[j]) = 1;
+                        }
+                    }
+                    previous_p = p;
+                }
 
-                                    is_neighbour.at<char>(p[j], p[j - 1]) = 1;
-                                    is_neighbour.at<char>(p[j], previous_p[j]) = 1;
-                                    is_neighbour.at<char>(p[j], previous_p[j - 1]) = 1;
+                for(int seg = 0; seg < nb_segs; seg++) {
+                    base.bounding_rects[seg] = cv::boundingRect(points[seg]);
+                }
+            }
 
-                                    is_neighbour.at<char>(p[j - 1], p[j]) = 1;
-                                    is_neighbour.at<char>(previous_p[j], p[j]) = 1;
-                                    is_neighbour.at<char>(previous_p[j - 1], p[j]) = 1;
-                                }
-                            }
-                            previous_p = p;
-                        }
+            // Appends the strategies holding state in s, returns false if s is not a built-in strategy,
+            // as it may then share state in ways that cannot be checked
+            static bool collectLeafStrategies(const Ptr<SelectiveSearchSegmentationStrategy>& s, std::vector<SelectiveSearchSegmentationStrategy*>& leaves) {
+                if (SelectiveSearchSegmentationStrategyMultipleImpl* multiple = dynamic_cast<SelectiveSearchSegmentationStrategyMultipleImpl*>(s.get())) {
+                    const std::vector<Ptr<SelectiveSearchSegmentationStrategy> >& children = multiple->getStrategies();
+                    for (size_t i = 0; i < children.size(); i++) {
+                        if (!collectLeafStrategies(children[i], leaves))
+                            return false;
+                    }
+                    return true;
+                }
+                if (dynamic_cast<SelectiveSearchSegmentationStrategyColorImpl*>(s.get()) ||
+                    dynamic_cast<SelectiveSearchSegmentationStrategySizeImpl*>(s.get()) ||
+                    dynamic_cast<SelectiveSearchSegmentationStrategyFillImpl*>(s.get()) ||
+                    dynamic_cast<SelectiveSearchSegmentationStrategyTextureImpl*>(s.get())) {
+                    leaves.push_back(s.get());
+                    return true;
+                }
+                return false;
+            }
 
-                        for(int seg = 0; seg < nb_segs; seg++) {
-                            bounding_rects[seg] = cv::boundingRect(points[seg]);
-                        }
+            void SelectiveSearchSegmentationImpl::process(std::vector<Rect>& rects) {
 
-                        for(std::vector<Ptr<SelectiveSearchSegmentationStrategy> >::iterator strategy = strategies.begin(); strategy != strategies.end(); ++strategy) {
-                            std::vector<Region> regions;
-                            hierarchicalGrouping(*image, *strategy, img_regions, is_neighbour, sizes, nb_segs, bounding_rects, regions, image_id);
+                // There is one base segmentation per (image, graph segmentation) pair, its index is used as image_id
+                const int nb_segmentations = (int)segmentations.size();
+                const int nb_bases = (int)images.size() * nb_segmentations;
+                const int nb_strategies = (int)strategies.size();
 
-                            for(std::vector<Region>::iterator region = regions.begin(); region != regions.end(); ++region) {
-                                all_regions.push_back(*region);
-                            }
+                std::vector<BaseSegmentation> bases(nb_bases);
+
+                parallel_for_(Range(0, nb_bases), [&](const Range& range) {
+                    for (int image_id = range.start; image_id < range.end; image_id++) {
+                        computeBaseSegmentation(images[image_id / nb_segmentations], segmentations[image_id % nb_segmentations], bases[image_id]);
+                    }
+                });
+
+                // Strategies keep per-image state (and cache it by image_id), so each strategy goes through
+                // the base segmentations in order, while different strategies run concurrently.
+                std::vector<std::vector<std::vector<Region> > > strategy_regions(nb_strategies, std::vector<std::vector<Region> >(nb_bases));
+
+                auto groupStrategies = [&](const Range& range) {
+                    for (int st = range.start; st < range.end; st++) {
+                        for (int image_id = 0; image_id < nb_bases; image_id++) {
+                            const BaseSegmentation& base = bases[image_id];
+                            hierarchicalGrouping(images[image_id / nb_segmentations], strategies[st], base.img_regions, base.is_neighbour, base.sizes, base.nb_segs, base.bounding_rects, strategy_regions[st][image_id], image_id);
                         }
+                    }
+                };
+
+                // Strategies can only run concurrently if none of them, down to the sub-strategies, is shared
+                std::vector<SelectiveSearchSegmentationStrategy*> leaves;
+                bool distinct_strategies = true;
+                for (int st = 0; st < nb_strategies && distinct_strategies; st++) {
+                    distinct_strategies = collectLeafStrategies(strategies[st], leaves);
+                }
+                if (distinct_strategies) {
+                    std::sort(leaves.begin(), leaves.end());
+                    distinct_strategies = std::adjacent_find(leaves.begin(), leaves.end()) == leaves.end();
+                }
+
+                if (distinct_strategies) {
+                    parallel_for_(Range(0, nb_strategies), groupStrategies);
+                } else {
+                    groupStrategies(Range(0, nb_strategies));
+                }
+
+                // Compute regions' rank, in the same order as a sequential run draws the random numbers
+                std::vector<Region> all_regions;
+
+                for (int image_id = 0; image_id < nb_bases; image_id++) {
+                    for (int st = 0; st < nb_strategies; st++) {
+                        std::vector<Region>& regions = strategy_regions[st][image_id];
 
-                        image_id++;
+                        for(std::vector<Region>::iterator region = regions.begin(); region != regions.end(); ++region) {
+                            // Note: this is inverted from the paper, but we keep the lover region first so it's works
+                            (*region).rank = ((double) rand() / (RAND_MAX)) * ((*region).level);
+                            all_regions.push_back(*region);
+                        }
                     }
                 }
 
@@ -973,12 +1069,25 @@ namespace cv {
 
             }
 
-            void SelectiveSearchSegmentationImpl::hierarchicalGrouping(const Mat& img, Ptr<SelectiveSearchSegmentationStrategy>& s, const Mat& img_regions, const Mat_<char>& is_neighbour, const Mat_<int>& sizes_, int& nb_segs, const std::vector<Rect>& bounding_rects, std::vector<Region>& regions, int image_id) {
+            void SelectiveSearchSegmentationImpl::hierarchicalGrouping(const Mat& img, Ptr<SelectiveSearchSegmentationStrategy>& s, const Mat& img_regions, const Mat_<char>& is_neighbour, const Mat_<int>& sizes_, int nb_segs, const std::vector<Rect>& bounding_rects, std::vector<Region>& regions, int image_id) {
 
                 Mat sizes = sizes_.clone();
 
-                std::vector<Neighbour> similarities;
+                // Most similar pair of regions on top. Pairs with a region that has already been
+                // merged are outdated, they are dropped when they reach the top.
+                std::priority_queue<Neighbour> similarities;
+
+                // Indexes (in regions) of the neighbours of each region, may contain merged regions
+                std::vector<std::vector<int> > neighbours(nb_segs);
+
+                // Last merge that collected a region as a neighbour, to avoid duplicates
+                std::vector<int> collected_by;
+
                 regions.clear();
+                regions.reserve(2 * nb_segs);
+                neighbours.reserve(2 * nb_segs);
+                collected_by.reserve(2 * nb_segs);
+                collected_by.resize(nb_segs, -1);
 
                 /////////////////////////////////////////
 
@@ -995,28 +1104,30 @@ namespace cv {
 
                     regions.push_back(r);
 
+                    const char* is_neighbour_i = is_neighbour.ptr<char>(i);
+
                     for (int j = i + 1; j < nb_segs; j++) {
-                        if (is_neighbour.at<char>(i, j)) {
+                        if (is_neighbour_i[j]) {
                             Neighbour n;
                             n.from = i;
                             n.to = j;
                             n.similarity = s->get(i, j);
 
-                            similarities.push_back(n);
+                            similarities.push(n);
+                            neighbours[i].push_back(j);
+                            neighbours[j].push_back(i);
                         }
                     }
                 }
 
-                while(similarities.size() > 0) {
-
-                    std::sort(similarities.begin(), similarities.end());
+                while(!similarities.empty()) {
 
-                    // for(std::vector<Neighbour>::iterator similarity = similarities.begin(); similarity != similarities.end(); ++similarity) {
-                    //     std::cout << *similarity << std::endl;
-                    // }
+                    Neighbour p = similarities.top();
+                    similarities.pop();
 
-                    Neighbour p = similarities.back();
-                    similarities.pop_back();
+                    if (regions[p.from].merged_to != -1 || regions[p.to].merged_to != -1) {
+                        continue;
+                    }
 
                     Region region_from = regions[p.from];
                     Region region_to = regions[p.to];
@@ -1027,10 +1138,11 @@ namespace cv {
                     new_r.merged_to = -1;
                     new_r.bounding_box = region_from.bounding_box | region_to.bounding_box;
 
+                    const int new_index = (int)regions.size();
                     regions.push_back(new_r);
 
-                    regions[p.from].merged_to = (int)regions.size() - 1;
-                    regions[p.to].merged_to = (int)regions.size() - 1;
+                    regions[p.from].merged_to = new_index;
+                    regions[p.to].merged_to = new_index;
 
                     // Merge
                     s->merge(region_from.id, region_to.id);
@@ -1039,53 +1151,49 @@ namespace cv {
                     sizes.at<int>(region_from.id, 0) += sizes.at<int>(region_to.id, 0);
                     sizes.at<int>(region_to.id, 0) = sizes.at<int>(region_from.id, 0);
 
+                    // The neighbours of the new region are the remaining neighbours of both merged regions
                     std::vector<int> local_neighbours;
+                    collected_by.push_back(-1);
 
-                    for(std::vector<Neighbour>::iterator similarity = similarities.begin(); similarity != similarities.end();) {
-                        if ((*similarity).from == p.from || (*similarity).to == p.from || (*similarity).from == p.to || (*similarity).to == p.to) {
-                            int from = 0;
-
-                            if ((*similarity).from == p.from || (*similarity).from == p.to) {
-                                from = (*similarity).to;
-                            } else {
-                                from = (*similarity).from;
-                            }
+                    for (int k = 0; k < 2; k++) {
+                        const std::vector<int>& merged_neighbours = neighbours[k == 0 ? p.from : p.to];
 
-                            bool already_neighboor = false;
+                        for (size_t m = 0; m < merged_neighbours.size(); m++) {
+                            int neighbour = merged_neighbours[m];
 
-                            for(std::vector<int>::iterator local_neighbour = local_neighbours.begin(); local_neighbour != local_neighbours.end(); local_neighbour++) {
-                                if (*local_neighbour == from) {
-                                    already_neighboor = true;
-                                }
-                            }
-
-                            if (!already_neighboor) {
-                                local_neighbours.push_back(from);
+                            if (regions[neighbour].merged_to == -1 && collected_by[neighbour] != new_index) {
+                                collected_by[neighbour] = new_index;
+                                local_neighbours.push_back(neighbour);
                             }
-
-                            similarity = similarities.erase(similarity);
-                        } else {
-                            similarity++;
                         }
                     }
 
+                    std::vector<int>().swap(neighbours[p.from]);
+                    std::vector<int>().swap(neighbours[p.to]);
+                    neighbours.push_back(local_neighbours);
+
                     for(std::vector<int>::iterator local_neighbour = local_neighbours.begin(); local_neighbour != local_neighbours.end(); local_neighbour++) {
 
+                        // Drop the merged regions from the neighbour's list
+                        std::vector<int>& neighbour_list = neighbours[*local_neighbour];
+                        size_t kept = 0;
+                        for (size_t m = 0; m < neighbour_list.size(); m++) {
+                            if (regions[neighbour_list[m]].merged_to == -1) {
+                                neighbour_list[kept++] = neighbour_list[m];
+                            }
+                        }
+                        neighbour_list.resize(kept);
+                        neighbour_list.push_back(new_index);
+
                         Neighbour n;
-                        n.from = (int)regions.size() - 1;
+                        n.from = new_index;
                         n.to = *local_neighbour;
                         n.similarity = s->get(regions[n.from].id, regions[n.to].id);
 
-                        similarities.push_back(n);
+                        similarities.push(n);
                     }
                 }
 
-                // Compute regions' rank
-                for(std::vector<Region>::iterator region = regions.begin(); region != regions.end(); ++region) {
-                    // Note: this is inverted from the paper, but we keep the lover region first so it's works
-                    (*region).rank = ((double) rand() / (RAND_MAX)) * ((*region).level);
-                }
-
             }
 
             Ptr<SelectiveSearchSegmentation> createSelectiveSearchSegmentation() {
@@ -91,115 +91,143 @@ static uint8_t lut_guo_iter1[] = {
     1, 1, 0, 0, 0, 0, 1, 1, 1, 1, 0, 0, 1, 1,
     1, 1, 1, 1};
 
-// Applies a thinning iteration to a binary image
-static void thinningIteration(Mat img, int iter, int thinningType){
-    Mat marker = Mat::zeros(img.size(), CV_8UC1);
-    int rows = img.rows;
-    int cols = img.cols;
-    marker.col(0).setTo(1);
-    marker.col(cols - 1).setTo(1);
-    marker.row(0).setTo(1);
-    marker.row(rows - 1).setTo(1);
-
-    if(thinningType == THINNING_ZHANGSUEN){
-        marker.forEach<uchar>([=](uchar& value, const int postion[]) {
-            int i = postion[0];
-            int j = postion[1];
-            if (i == 0 || j == 0 || i == rows - 1 || j == cols - 1)
-                return;
-
-            auto ptr = img.ptr(i, j); // p1
-
-            // p9 p2 p3
-            // p8 p1 p4
-            // p7 p6 p5
-            uchar p2 = ptr[-cols];
-            uchar p3 = ptr[-cols + 1];
-            uchar p4 = ptr[1];
-            uchar p5 = ptr[cols + 1];
-            uchar p6 = ptr[cols];
-            uchar p7 = ptr[cols - 1];
-            uchar p8 = ptr[-1];
-            uchar p9 = ptr[-cols - 1];
-
-            int neighbors = p9 | (p2 << 1) | (p3 << 2) | (p4 << 3) | (p5 << 4) | (p6 << 5) | (p7 << 6) | (p8 << 7);
-
-            if (iter == 0)
-                value = lut_zhang_iter0[neighbors];
-            else
-                value = lut_zhang_iter1[neighbors];
-
-            //int A  = (p2 == 0 && p3 == 1) + (p3 == 0 && p4 == 1) +
-            //         (p4 == 0 && p5 == 1) + (p5 == 0 && p6 == 1) +
-            //         (p6 == 0 && p7 == 1) + (p7 == 0 && p8 == 1) +
-            //         (p8 == 0 && p9 == 1) + (p9 == 0 && p2 == 1);
-            //int B  = p2 + p3 + p4 + p5 + p6 + p7 + p8 + p9;
-            //int m1 = iter == 0 ? (p2 * p4 * p6) : (p2 * p4 * p8);
-            //int m2 = iter == 0 ? (p4 * p6 * p8) : (p2 * p6 * p8);
-            //if (A == 1 && (B >= 2 && B <= 6) && m1 == 0 && m2 == 0) value = 0;
-            // else value = 1;
-        });
+// Code of the 8 neighbors of p1, used as index into the look up tables
+//   p9 p2 p3
+//   p8 p1 p4
+//   p7 p6 p5
+static inline int neighborsCode(const uchar* ptr, int step){
+    return  ptr[-step - 1]        | (ptr[-step] << 1) | (ptr[-step + 1] << 2) | (ptr[1] << 3) |
+           (ptr[step + 1] << 4)   | (ptr[step] << 5)  | (ptr[step - 1] << 6)  | (ptr[-1] << 7);
+}
+
+// Rows of the image processed by one thread: pixels to be tested in the next
+// sub-iteration and pixels deleted by the last two sub-iterations
+struct ThinningBand {
+    int rowStart, rowEnd;
+    std::vector<int> candidates;
+    std::vector<int> deleted[2];
+};
+
+// Thins a binary 0/1 image in place. The first iteration tests every pixel.
+// After that a pixel can only change if one of its neighbors was deleted since
+// it was last tested with the same look up table, so each sub-iteration only
+// tests the neighbors of the pixels deleted by the previous two.
+static void thinningFrontier(Mat& img, int thinningType){
+    CV_Assert(img.isContinuous() && img.total() < (size_t)INT_MAX);
+    const uint8_t* lut[2] = {
+        thinningType == THINNING_ZHANGSUEN ? lut_zhang_iter0 : lut_guo_iter0,
+        thinningType == THINNING_ZHANGSUEN ? lut_zhang_iter1 : lut_guo_iter1
+    };
+    const int rows = img.rows;
+    const int cols = img.cols;
+    const int step = cols;
+    uchar* data = img.ptr();
+    const int offsets[8] = { -step - 1, -step, -step + 1, -1, 1, step - 1, step, step + 1 };
+
+    // Border pixels are never modified, so they are kept out of the candidate lists
+    Mat queued = Mat::zeros(img.size(), CV_8UC1);
+    queued.col(0).setTo(1);
+    queued.col(cols - 1).setTo(1);
+    uchar* queuedData = queued.ptr();
+
+    const int nBands = std::max(1, std::min(rows - 2, getNumThreads() * 4));
+    std::vector<ThinningBand> bands(nBands);
+    for (int b = 0; b < nBands; b++){
+        bands[b].rowStart = 1 + (rows - 2) * b / nBands;
+        bands[b].rowEnd = 1 + (rows - 2) * (b + 1) / nBands;
     }
-    if(thinningType == THINNING_GUOHALL){
-        marker.forEach<uchar>([=](uchar& value, const int postion[]) {
-            int i = postion[0];
-            int j = postion[1];
-            if (i == 0 || j == 0 || i == rows - 1 || j == cols - 1)
-                return;
-
-            auto ptr = img.ptr(i, j); // p1
-
-            // p9 p2 p3
-            // p8 p1 p4
-            // p7 p6 p5
-            uchar p2 = ptr[-cols];
-            uchar p3 = ptr[-cols + 1];
-            uchar p4 = ptr[1];
-            uchar p5 = ptr[cols + 1];
-            uchar p6 = ptr[cols];
-            uchar p7 = ptr[cols - 1];
-            uchar p8 = ptr[-1];
-            uchar p9 = ptr[-cols - 1];
-
-            int neighbors = p9 | (p2 << 1) | (p3 << 2) | (p4 << 3) | (p5 << 4) | (p6 << 5) | (p7 << 6) | (p8 << 7);
-
-            if (iter == 0)
-                value = lut_guo_iter0[neighbors];
-            else
-                value = lut_guo_iter1[neighbors];
-
-            //int C  = ((!p2) & (p3 | p4)) + ((!p4) & (p5 | p6)) +
-            //         ((!p6) & (p7 | p8)) + ((!p8) & (p9 | p2));
-            //int N1 = (p9 | p2) + (p3 | p4) + (p5 | p6) + (p7 | p8);
-            //int N2 = (p2 | p3) + (p4 | p5) + (p6 | p7) + (p8 | p9);
-            //int N  = N1 < N2 ? N1 : N2;
-            //int m  = iter == 0 ? ((p6 | p7 | (!p9)) & p8) : ((p2 | p3 | (!p5)) & p4);
-            //if ((C == 1) && ((N >= 2) && ((N <= 3)) & (m == 0))) value = 0;
-            // else value = 1;
+
+    bool changed = false;
+    for (int iter = 0; ; iter++){
+        const int parity = iter & 1;
+        const uint8_t* curLut = lut[parity];
+
+        // Test the candidates against the image state before this sub-iteration
+        parallel_for_(Range(0, nBands), [&](const Range& range){
+            for (int b = range.start; b < range.end; b++){
+                ThinningBand& band = bands[b];
+                std::vector<int>& deleted = band.deleted[parity];
+                deleted.clear();
+                if (iter < 2){
+                    for (int i = band.rowStart; i < band.rowEnd; i++){
+                        const uchar* row = data + i * step;
+                        for (int j = 1; j < cols - 1; j++)
+                            if (row[j] && !curLut[neighborsCode(row + j, step)])
+                                deleted.push_back(i * step + j);
+                    }
+                }
+                else{
+                    for (size_t k = 0; k < band.candidates.size(); k++){
+                        const int idx = band.candidates[k];
+                        if (data[idx] && !curLut[neighborsCode(data + idx, step)])
+                            deleted.push_back(idx);
+                    }
+                }
+            }
         });
-    }
 
-    img &= marker;
+        bool deletedAny = false;
+        for (int b = 0; b < nBands && !deletedAny; b++)
+            deletedAny = !bands[b].deleted[parity].empty();
+        if (deletedAny){
+            parallel_for_(Range(0, nBands), [&](const Range& range){
+                for (int b = range.start; b < range.end; b++){
+                    const std::vector<int>& deleted = bands[b].deleted[parity];
+                    for (size_t k = 0; k < deleted.size(); k++)
+                        data[deleted[k]] = 0;
+                }
+            });
+        }
+
+        changed = parity == 0 ? deletedAny : (changed || deletedAny);
+        if (parity == 1){
+            if (!changed)
+                break;
+            changed = false;
+        }
+        if (iter == 0)
+            continue;
+
+        // Collect the foreground neighbors of the pixels deleted by the last two
+        // sub-iterations. Deleted pixels of the adjacent bands may have neighbors
+        // in the first and last rows of this band.
+        parallel_for_(Range(0, nBands), [&](const Range& range){
+            for (int b = range.start; b < range.end; b++){
+                ThinningBand& band = bands[b];
+                const int lo = band.rowStart * step;
+                const int hi = band.rowEnd * step;
+                band.candidates.clear();
+                for (int nb = std::max(b - 1, 0); nb <= std::min(b + 1, nBands - 1); nb++){
+                    for (int p = 0; p < 2; p++){
+                        const std::vector<int>& deleted = bands[nb].deleted[p];
+                        for (size_t k = 0; k < deleted.size(); k++){
+                            for (int n = 0; n < 8; n++){
+                                const int idx = deleted[k] + offsets[n];
+                                if (idx < lo || idx >= hi || !data[idx] || queuedData[idx])
+                                    continue;
+                                queuedData[idx] = 1;
+                                band.candidates.push_back(idx);
+                            }
+                        }
+                    }
+                }
+                for (size_t k = 0; k < band.candidates.size(); k++)
+                    queuedData[band.candidates[k]] = 0;
+            }
+        });
+    }
 }
 
 // Apply the thinning procedure to a given image
 void thinning(InputArray input, OutputArray output, int thinningType){
+    CV_Assert(thinningType == THINNING_ZHANGSUEN || thinningType == THINNING_GUOHALL);
     Mat processed = input.getMat().clone();
     CV_CheckTypeEQ(processed.type(), CV_8UC1, "");
     // Enforce the range of the input image to be in between 0 - 255
     processed /= 255;
 
-    Mat prev = processed.clone();
-    Mat diff;
-
-    do {
-        thinningIteration(processed, 0, thinningType);
-        thinningIteration(processed, 1, thinningType);
-        absdiff(processed, prev, diff);
-        if (!hasNonZero(diff)) break;
-        processed.copyTo(prev);
-    }
-    while (true);
+    if (processed.rows > 2 && processed.cols > 2)
+        thinningFrontier(processed, thinningType);
 
     processed *= 255;
 
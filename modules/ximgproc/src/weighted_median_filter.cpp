@@ -164,65 +164,17 @@ void from32STo32F(Mat &img, Mat &outImg, float *mapping)
 }
 
 
-/***************************************************************
- * Function: float2D
- * Description: allocate a 2D float array with dimension "dim1 x dim2"
- ***************************************************************/
-float** float2D(int dim1, int dim2)
-{
-    float **ret = new float*[dim1];
-    ret[0] = new float[dim1*dim2];
-    for(int i=1;i<dim1;i++)ret[i] = ret[i-1]+dim2;
-
-    return ret;
-}
-
-/***************************************************************
- * Function: float2D_release
- * Description: deallocate the 2D array created by float2D()
- ***************************************************************/
-void float2D_release(float **p)
-{
-    delete []p[0];
-    delete []p;
-}
-
-/***************************************************************
- * Function: int2D
- * Description: allocate a 2D integer array with dimension "dim1 x dim2"
- ***************************************************************/
-int** int2D(int dim1, int dim2)
-{
-    int **ret = new int*[dim1];
-    ret[0] = new int[dim1*dim2];
-    for(int i=1;i<dim1;i++)ret[i] = ret[i-1]+dim2;
-
-    return ret;
-}
-
-/***************************************************************
- * Function: int2D_release
- * Description: deallocate the 2D array created by int2D()
- ***************************************************************/
-void int2D_release(int **p)
-{
-    delete []p[0];
-    delete []p;
-}
-
 /***************************************************************
  * Function: updateBCB
  * Description: maintain the necklace table of BCB
  ***************************************************************/
 inline void updateBCB(int &num,int *f,int *b,int i,int v)
 {
-    static int p1,p2;
-
     if(i)
     {
         if(!num)
         { // cell is becoming non-empty
-            p2=f[0];
+            int p2=f[0];
             f[0]=i;
             f[i]=p2;
             b[p2]=i;
@@ -230,7 +182,7 @@ inline void updateBCB(int &num,int *f,int *b,int i,int v)
         }
         else if(!(num+v))
         {// cell is becoming empty
-            p1=b[i],p2=f[i];
+            int p1=b[i],p2=f[i];
             f[p1]=p2;
             b[p2]=p1;
         }
@@ -246,7 +198,7 @@ inline void updateBCB(int &num,int *f,int *b,int i,int v)
  *                If F is 3-channel, perform k-means clustering
  *                If F is 1-channel, only perform type-casting
  ***************************************************************/
-void featureIndexing(Mat &F, float **&wMap, int &nF, float sigmaI, int weightType){
+void featureIndexing(Mat &F, Mat &wMap, int &nF, float sigmaI, int weightType){
     // Configuration and Declaration
     Mat FNew;
     int cols = F.cols, rows = F.rows;
@@ -262,7 +214,7 @@ void featureIndexing(Mat &F, float **&wMap, int &nF, float sigmaI, int weightTyp
         F.convertTo(FNew, CV_32S);
 
         // Compute weight map (weight between each pair of feature index)
-        wMap = float2D(nF,nF);
+        wMap.create(nF,nF,CV_32F);
         float nSigmaI = sigmaI;
         float divider = (1.0f/(2*nSigmaI*nSigmaI));
 
@@ -284,7 +236,7 @@ void featureIndexing(Mat &F, float **&wMap, int &nF, float sigmaI, int weightTyp
                     default: val = exp(-(diff*diff)*divider);
                 }
 
-                wMap[i][j] = wMap[j][i] = val;
+                wMap.at<float>(i,j) = wMap.at<float>(j,i) = val;
             }
         }
     }
@@ -362,7 +314,7 @@ void featureIndexing(Mat &F, float **&wMap, int &nF, float sigmaI, int weightTyp
         }
 
         // Compute weight map (weight between each pair of feature index)
-        wMap = float2D(nF,nF);
+        wMap.create(nF,nF,CV_32F);
         float nSigmaI = sigmaI/256.0f*LOW_NUM;
         float divider = (1.0f/(2*nSigmaI*nSigmaI));
 
@@ -399,7 +351,7 @@ void featureIndexing(Mat &F, float **&wMap, int &nF, float sigmaI, int weightTyp
                     default: val = exp(-(diff0*diff0+diff1*diff1+diff2*diff2)*divider);
                 }
 
-                wMap[i][j] = wMap[j][i] = val;
+                wMap.at<float>(i,j) = wMap.at<float>(j,i) = val;
             }
         }
 
@@ -409,244 +361,272 @@ void featureIndexing(Mat &F, float **&wMap, int &nF, float sigmaI, int weightTyp
     F = FNew;
 }
 
-Mat filterCore(Mat &I, Mat &F, float **wMap, int r=20, int nF=256, int nI=256, Mat mask=Mat())
+/***************************************************************
+ * Class: WMFColumnInvoker
+ * Description: runs the joint-histogram median search for a strip of columns.
+ *                Every column is scanned top to bottom with its own sliding window,
+ *                so strips are independent as long as each of them owns its
+ *                joint-histogram, BCB and necklace tables. These buffers are
+ *                allocated once per strip and reused for all of its columns.
+ ***************************************************************/
+class WMFColumnInvoker : public ParallelLoopBody
 {
-    // Check validation
-    assert(I.depth() == CV_32S && I.channels()==1);//input image: 32SC1
-    assert(F.depth() == CV_32S && F.channels()==1);//feature image: 32SC1
-
-    // Configuration and declaration
-    int rows = I.rows, cols = I.cols;
-    Mat outImg = I.clone();
+public:
+    WMFColumnInvoker(const Mat &I_, const Mat &F_, const Mat &wMap_, const Mat &mask_, Mat &outImg_, int r_, int nF_, int nI_)
+        : I(I_), F(F_), wMap(wMap_), mask(mask_), outImg(outImg_), r(r_), nF(nF_), nI(nI_)
+    {}
 
-    // Handle Mask
-    if(mask.empty())
+    void operator()(const Range &range) const CV_OVERRIDE
     {
-        mask = Mat(I.size(),CV_8U);
-        mask = Scalar(1);
+        // Allocate memory for joint-histogram and BCB
+        AutoBuffer<int> H(nI*nF);
+        AutoBuffer<int> BCB(nF);
+
+        // Allocate links for necklace table
+        AutoBuffer<int> Hf(nI*nF);//forward link
+        AutoBuffer<int> Hb(nI*nF);//backward link
+        AutoBuffer<int> BCBf(nF);//forward link
+        AutoBuffer<int> BCBb(nF);//backward link
+
+        for(int x=range.start;x<range.end;x++)
+            filterColumn(x, H.data(), Hf.data(), Hb.data(), BCB.data(), BCBf.data(), BCBb.data());
     }
 
-    // Allocate memory for joint-histogram and BCB
-    int **H = int2D(nI,nF);
-    int *BCB = new int[nF];
+private:
+    void filterColumn(int x, int *H, int *Hf, int *Hb, int *BCB, int *BCBf, int *BCBb) const;
 
-    // Allocate links for necklace table
-    int **Hf = int2D(nI,nF);//forward link
-    int **Hb = int2D(nI,nF);//backward link
-    int *BCBf = new int[nF];//forward link
-    int *BCBb = new int[nF];//backward link
+    const Mat &I;
+    const Mat &F;
+    const Mat &wMap;
+    const Mat &mask;
+    Mat &outImg;
+    int r, nF, nI;
+};
 
-    // Column Scanning
-    for(int x=0;x<cols;x++)
-    {
-        // Reset histogram and BCB for each column
-        memset(BCB, 0, sizeof(int)*nF);
-        memset(H[0], 0, sizeof(int)*nF*nI);
-        for(int i=0;i<nI;i++)Hf[i][0]=Hb[i][0]=0;
-        BCBf[0]=BCBb[0]=0;
-
-        // Reset cut-point
-        int medianVal = -1;
-
-        // Precompute "x" range and checks boundary
-        int downX = max(0,x-r);
-        int upX = min(cols-1,x+r);
-
-        // Initialize joint-histogram and BCB for the first window
-        int upY = min(rows-1,r);
-        for(int i=0;i<=upY;i++)
-        {
-            int *IPtr = I.ptr<int>(i);
-            int *FPtr = F.ptr<int>(i);
-            uchar *maskPtr = mask.ptr<uchar>(i);
+void WMFColumnInvoker::filterColumn(int x, int *H, int *Hf, int *Hb, int *BCB, int *BCBf, int *BCBb) const
+{
+    int rows = I.rows, cols = I.cols;
 
-            for(int j=downX;j<=upX;j++)
-            {
-                if(!maskPtr[j])continue;
+    // Reset histogram and BCB for each column
+    memset(BCB, 0, sizeof(int)*nF);
+    memset(H, 0, sizeof(int)*nF*nI);
+    for(int i=0;i<nI;i++)Hf[i*nF]=Hb[i*nF]=0;
+    BCBf[0]=BCBb[0]=0;
 
-                int fval = IPtr[j];
-                int *curHist = H[fval];
-                int gval = FPtr[j];
+    // Reset cut-point
+    int medianVal = -1;
 
-                // Maintain necklace table of joint-histogram
-                if(!curHist[gval] && gval)
-                {
-                    int *curHf = Hf[fval];
-                    int *curHb = Hb[fval];
+    // Precompute "x" range and checks boundary
+    int downX = max(0,x-r);
+    int upX = min(cols-1,x+r);
 
-                    int p1=0,p2=curHf[0];
-                    curHf[p1]=gval;
-                    curHf[gval]=p2;
-                    curHb[p2]=gval;
-                    curHb[gval]=p1;
-                }
+    // Initialize joint-histogram and BCB for the first window
+    int upY = min(rows-1,r);
+    for(int i=0;i<=upY;i++)
+    {
+        const int *IPtr = I.ptr<int>(i);
+        const int *FPtr = F.ptr<int>(i);
+        const uchar *maskPtr = mask.ptr<uchar>(i);
 
-                curHist[gval]++;
-                // Maintain necklace table of BCB
-                updateBCB(BCB[gval],BCBf,BCBb,gval,-1);
+        for(int j=downX;j<=upX;j++)
+        {
+            if(!maskPtr[j])continue;
+
+            int fval = IPtr[j];
+            int *curHist = H + fval*nF;
+            int gval = FPtr[j];
+
+            // Maintain necklace table of joint-histogram
+            if(!curHist[gval] && gval)
+            {
+                int *curHf = Hf + fval*nF;
+                int *curHb = Hb + fval*nF;
+
+                int p1=0,p2=curHf[0];
+                curHf[p1]=gval;
+                curHf[gval]=p2;
+                curHb[p2]=gval;
+                curHb[gval]=p1;
             }
+
+            curHist[gval]++;
+            // Maintain necklace table of BCB
+            updateBCB(BCB[gval],BCBf,BCBb,gval,-1);
         }
+    }
 
-        for(int y=0;y<rows;y++)
+    for(int y=0;y<rows;y++)
+    {
+        // Find weighted median with help of BCB and joint-histogram
+        float balanceWeight = 0;
+        int curIndex = F.ptr<int>(y,x)[0];
+        const float *fPtr = wMap.ptr<float>(curIndex);
+        int &curMedianVal = medianVal;
+
+        // Compute current balance
         {
-            // Find weighted median with help of BCB and joint-histogram
-            float balanceWeight = 0;
-            int curIndex = F.ptr<int>(y,x)[0];
-            float *fPtr = wMap[curIndex];
-            int &curMedianVal = medianVal;
+            int i=0;
+            do
+            {
+                balanceWeight += BCB[i]*fPtr[i];
+                i=BCBf[i];
+            }while(i);
+        }
 
-            // Compute current balance
+        // Move cut-point to the left
+        if(balanceWeight >= 0)
+        {
+            for(;balanceWeight >= 0 && curMedianVal > 0; curMedianVal--)
             {
+                float curWeight = 0;
+                const int *nextHist = H + curMedianVal*nF;
+                const int *nextHf = Hf + curMedianVal*nF;
+
+                // Compute weight change by shift cut-point
                 int i=0;
                 do
                 {
-                    balanceWeight += BCB[i]*fPtr[i];
-                    i=BCBf[i];
+                    curWeight += (nextHist[i]<<1)*fPtr[i];
+
+                    // Update BCB and maintain the necklace table of BCB
+                    updateBCB(BCB[i],BCBf,BCBb,i,-(nextHist[i]<<1));
+
+                    i=nextHf[i];
                 }while(i);
-            }
 
-            // Move cut-point to the left
-            if(balanceWeight >= 0)
+                balanceWeight -= curWeight;
+            }
+        }
+        // Move cut-point to the right
+        else if(balanceWeight < 0)
+        {
+            for(;balanceWeight < 0 && curMedianVal != nI-1; curMedianVal++)
             {
-                for(;balanceWeight >= 0 && curMedianVal > 0; curMedianVal--)
+                float curWeight = 0;
+                const int *nextHist = H + (curMedianVal+1)*nF;
+                const int *nextHf = Hf + (curMedianVal+1)*nF;
+
+                // Compute weight change by shift cut-point
+                int i=0;
+                do
                 {
-                    float curWeight = 0;
-                    int *nextHist = H[curMedianVal];
-                    int *nextHf = Hf[curMedianVal];
+                    curWeight += (nextHist[i]<<1)*fPtr[i];
+
+                    // Update BCB and maintain the necklace table of BCB
+                    updateBCB(BCB[i],BCBf,BCBb,i,nextHist[i]<<1);
+
+                    i=nextHf[i];
+                }while(i);
+                balanceWeight += curWeight;
+            }
+        }
 
-                    // Compute weight change by shift cut-point
-                    int i=0;
-                    do
-                    {
-                        curWeight += (nextHist[i]<<1)*fPtr[i];
+        // Weighted median is found and written to the output image
+        if(curMedianVal != -1)
+        {
+            if(balanceWeight < 0)
+                outImg.ptr<int>(y,x)[0] = curMedianVal+1;
+            else
+                outImg.ptr<int>(y,x)[0] = curMedianVal;
+        }
 
-                        // Update BCB and maintain the necklace table of BCB
-                        updateBCB(BCB[i],BCBf,BCBb,i,-(nextHist[i]<<1));
+        // Update joint-histogram and BCB when local window is shifted.
+        int fval,gval,*curHist;
 
-                        i=nextHf[i];
-                    }while(i);
+        // Add entering pixels into joint-histogram and BCB
+        int rownum = y + r + 1;
+        if(rownum < rows)
+        {
+            const int *inputImgPtr = I.ptr<int>(rownum);
+            const int *guideImgPtr = F.ptr<int>(rownum);
+            const uchar *maskPtr = mask.ptr<uchar>(rownum);
 
-                    balanceWeight -= curWeight;
-                }
-            }
-            // Move cut-point to the right
-            else if(balanceWeight < 0)
+            for(int j=downX;j<=upX;j++)
             {
-                for(;balanceWeight < 0 && curMedianVal != nI-1; curMedianVal++)
+                if(!maskPtr[j])continue;
+
+                fval = inputImgPtr[j];
+                curHist = H + fval*nF;
+                gval = guideImgPtr[j];
+
+                // Maintain necklace table of joint-histogram
+                if(!curHist[gval] && gval)
                 {
-                    float curWeight = 0;
-                    int *nextHist = H[curMedianVal+1];
-                    int *nextHf = Hf[curMedianVal+1];
-
-                    // Compute weight change by shift cut-point
-                    int i=0;
-                    do
-                    {
-                        curWeight += (nextHist[i]<<1)*fPtr[i];
-
-                        // Update BCB and maintain the necklace table of BCB
-                        updateBCB(BCB[i],BCBf,BCBb,i,nextHist[i]<<1);
-
-                        i=nextHf[i];
-                    }while(i);
-                    balanceWeight += curWeight;
+                    int *curHf = Hf + fval*nF;
+                    int *curHb = Hb + fval*nF;
+
+                    int p1=0,p2=curHf[0];
+                    curHf[gval]=p2;
+                    curHb[gval]=p1;
+                    curHf[p1]=curHb[p2]=gval;
                 }
-            }
 
-            // Weighted median is found and written to the output image
-            if(curMedianVal != -1)
-            {
-                if(balanceWeight < 0)
-                    outImg.ptr<int>(y,x)[0] = curMedianVal+1;
-                else
-                    outImg.ptr<int>(y,x)[0] = curMedianVal;
+                curHist[gval]++;
+
+                // Maintain necklace table of BCB
+                updateBCB(BCB[gval],BCBf,BCBb,gval,((fval <= medianVal)<<1)-1);
             }
+        }
 
-            // Update joint-histogram and BCB when local window is shifted.
-            int fval,gval,*curHist;
+        // Delete leaving pixels into joint-histogram and BCB
+        rownum = y - r;
+        if(rownum >= 0)
+        {
+            const int *inputImgPtr = I.ptr<int>(rownum);
+            const int *guideImgPtr = F.ptr<int>(rownum);
+            const uchar *maskPtr = mask.ptr<uchar>(rownum);
 
-            // Add entering pixels into joint-histogram and BCB
-            int rownum = y + r + 1;
-            if(rownum < rows)
+            for(int j=downX;j<=upX;j++)
             {
-                    int *inputImgPtr = I.ptr<int>(rownum);
-                    int *guideImgPtr = F.ptr<int>(rownum);
-                    uchar *maskPtr = mask.ptr<uchar>(rownum);
-
-                    for(int j=downX;j<=upX;j++)
-                    {
-                        if(!maskPtr[j])continue;
-
-                        fval = inputImgPtr[j];
-                        curHist = H[fval];
-                        gval = guideImgPtr[j];
-
-                        // Maintain necklace table of joint-histogram
-                        if(!curHist[gval] && gval)
-                        {
-                            int *curHf = Hf[fval];
-                            int *curHb = Hb[fval];
-
-                            int p1=0,p2=curHf[0];
-                            curHf[gval]=p2;
-                            curHb[gval]=p1;
-                            curHf[p1]=curHb[p2]=gval;
-                        }
-
-                        curHist[gval]++;
-
-                        // Maintain necklace table of BCB
-                        updateBCB(BCB[gval],BCBf,BCBb,gval,((fval <= medianVal)<<1)-1);
-                    }
-                }
+                if(!maskPtr[j])continue;
+
+                fval = inputImgPtr[j];
+                curHist = H + fval*nF;
+                gval = guideImgPtr[j];
 
+                curHist[gval]--;
 
-                // Delete leaving pixels into joint-histogram and BCB
-                rownum = y - r;
-                if(rownum >= 0)
+                // Maintain necklace table of joint-histogram
+                if(!curHist[gval] && gval)
                 {
-                    int *inputImgPtr = I.ptr<int>(rownum);
-                    int *guideImgPtr = F.ptr<int>(rownum);
-                    uchar *maskPtr = mask.ptr<uchar>(rownum);
-
-                    for(int j=downX;j<=upX;j++)
-                    {
-                        if(!maskPtr[j])continue;
-
-                        fval = inputImgPtr[j];
-                        curHist = H[fval];
-                        gval = guideImgPtr[j];
-
-                        curHist[gval]--;
-
-                        // Maintain necklace table of joint-histogram
-                        if(!curHist[gval] && gval)
-                        {
-                            int *curHf = Hf[fval];
-                            int *curHb = Hb[fval];
-
-                            int p1=curHb[gval],p2=curHf[gval];
-                            curHf[p1]=p2;
-                            curHb[p2]=p1;
-                        }
-
-                        // Maintain necklace table of BCB
-                        updateBCB(BCB[gval],BCBf,BCBb,gval,-((fval <= medianVal)<<1)+1);
-                    }
+                    int *curHf = Hf + fval*nF;
+                    int *curHb = Hb + fval*nF;
+
+                    int p1=curHb[gval],p2=curHf[gval];
+                    curHf[p1]=p2;
+                    curHb[p2]=p1;
                 }
+
+                // Maintain necklace table of BCB
+                updateBCB(BCB[gval],BCBf,BCBb,gval,-((fval <= medianVal)<<1)+1);
+            }
         }
     }
+}
+
+Mat filterCore(Mat &I, Mat &F, const Mat &wMap, int r=20, int nF=256, int nI=256, Mat mask=Mat())
+{
+    // Check validation
+    assert(I.depth() == CV_32S && I.channels()==1);//input image: 32SC1
+    assert(F.depth() == CV_32S && F.channels()==1);//feature image: 32SC1
 
-    // Deallocate the memory
+    // Configuration and declaration
+    int cols = I.cols;
+    Mat outImg = I.clone();
+
+    // Handle Mask
+    if(mask.empty())
     {
-        delete []BCB;
-        delete []BCBf;
-        delete []BCBb;
-        int2D_release(H);
-        int2D_release(Hf);
-        int2D_release(Hb);
+        mask = Mat(I.size(),CV_8U);
+        mask = Scalar(1);
     }
 
+    // Column Scanning
+    // Columns are distributed over a few strips per thread, each strip keeps its own
+    // histogram buffers (3 x nI x nF ints), so their number is kept close to the thread count.
+    int nstripes = std::min(cols, std::max(1, getNumThreads()) * 4);
+    parallel_for_(Range(0, cols), WMFColumnInvoker(I, F, wMap, mask, outImg, r, nF, nI), nstripes);
+
     // end of the function
     return outImg;
 }
@@ -709,9 +689,9 @@ void weightedMedianFilter(InputArray joint, InputArray src, OutputArray dst, int
     //If "F" is 3-channel image, "clustering feature image" is done in featureIndexing.
     //If "F" is 1-channel image, featureIndexing only does a type-casting on "F".
     //The output "F" is CV_32S type, containing indexes of feature values.
-    //"wMap" is a 2D array that defines the distance between each pair of feature indexes.
-    // wMap[i][j] is the weight between feature index "i" and "j".
-    float **wMap = NULL;
+    //"wMap" is a nF x nF CV_32F matrix that defines the distance between each pair of feature indexes.
+    // wMap(i,j) is the weight between feature index "i" and "j".
+    Mat wMap;
     featureIndexing(F, wMap, nF, float(sigma), weightType);
 
     //Filtering - Joint-Histogram Framework
@@ -719,7 +699,6 @@ void weightedMedianFilter(InputArray joint, InputArray src, OutputArray dst, int
     {
         Is[i] = filterCore(Is[i], F, wMap, r, nF, nI, mask.getMat());
     }
-    float2D_release(wMap);
 
     //Postprocess F
     //Convert input image back to the original type.
@@ -459,4 +459,39 @@ INSTANTIATE_TEST_CASE_P(FullSet, FastHoughTransformTest,
 #undef FHT_ALL_DEPTHS
 #undef FHT_ALL_CHANNELS
 
+TEST(FastHoughTransformer, sameAsSingleThreadedFHT)
+{
+    Size const sizes[] = { Size(31, 17), Size(320, 240) };
+    int const ops[] = { FHT_ADD, FHT_MIN, FHT_MAX, FHT_AVE };
+    int const nThreads = getNumThreads();
+
+    for (size_t si = 0; si < sizeof(sizes) / sizeof(sizes[0]); ++si)
+    {
+        Mat src(sizes[si], CV_8UC3);
+        randu(src, 0, 256);
+        for (size_t oi = 0; oi < sizeof(ops) / sizeof(ops[0]); ++oi)
+        {
+            for (int angleRange = ARO_0_45; angleRange <= ARO_CTR_VER; ++angleRange)
+            {
+                Mat expected;
+                setNumThreads(1);
+                FastHoughTransform(src, expected, CV_32F, angleRange, ops[oi]);
+                setNumThreads(nThreads);
+
+                Ptr<FastHoughTransformer> fht =
+                        createFastHoughTransformer(CV_32F, angleRange, ops[oi]);
+                for (int frame = 0; frame < 2; ++frame)
+                {
+                    Mat actual;
+                    fht->apply(src, actual);
+                    ASSERT_EQ(expected.size(), actual.size());
+                    EXPECT_EQ(0, cvtest::norm(expected, actual, NORM_INF))
+                        << "size=" << sizes[si] << " op=" << ops[oi]
+                        << " angleRange=" << angleRange << " frame=" << frame;
+                }
+            }
+        }
+    }
+}
+
 }} // namespace
@@ -40,4 +40,42 @@ TEST(FindEllipsesTest, EllipsesOnly)
         EXPECT_TRUE(has_match) << "Wrong ellipse center:" << Point2f(ell[0], ell[1]);
     }
 }
+
+// The triplet searches run concurrently but share pairs of arcs, the detections must not depend on the threads
+TEST(FindEllipsesTest, SameAsSerial)
+{
+    Mat src(480, 640, CV_8UC1, Scalar(0));
+    const RotatedRect drawn[] = {
+        RotatedRect(Point2f(160.f, 120.f), Size2f(180.f, 110.f), 20.f),
+        RotatedRect(Point2f(460.f, 140.f), Size2f(200.f, 90.f), -35.f),
+        RotatedRect(Point2f(200.f, 360.f), Size2f(240.f, 130.f), 10.f),
+        RotatedRect(Point2f(470.f, 340.f), Size2f(130.f, 170.f), 60.f),
+    };
+    for (const RotatedRect &e : drawn)
+        ellipse(src, e, Scalar(255), 3);
+
+    std::vector<Vec6f> ells, ellsSerial;
+    int nthreads = getNumThreads();
+    setNumThreads(1);
+    ximgproc::findEllipses(src, ellsSerial, 0.7f, 0.75f, 0.02f);
+    setNumThreads(nthreads);
+    ximgproc::findEllipses(src, ells, 0.7f, 0.75f, 0.02f);
+
+    ASSERT_EQ(ellsSerial.size(), ells.size());
+    for (size_t i = 0; i < ells.size(); i++)
+        EXPECT_EQ(ellsSerial[i], ells[i]) << "detection " << i;
+
+    // all drawn ellipses are found
+    for (const RotatedRect &e : drawn) {
+        bool has_match = false;
+        for (auto ell : ells) {
+            Point2f diff = e.center - Point2f(ell[0], ell[1]);
+            if (sqrt(diff.x * diff.x + diff.y * diff.y) < 5.0) {
+                has_match = true;
+                break;
+            }
+        }
+        EXPECT_TRUE(has_match) << "Missing ellipse centered at " << e.center;
+    }
+}
 }}
\ No newline at end of file
@@ -26,4 +26,134 @@ TEST(ximgproc_niBlackThreshold, sauvola)
     EXPECT_EQ(255, dst.at<uchar>(2, 2));
 }
 
+TEST(ximgproc_niBlackThreshold, flat_regions)
+{
+    // the threshold of flat regions is their value, the local variance must not become
+    // negative because of rounding
+    Mat src(64, 80, CV_8UC1, Scalar::all(100));
+    src(Rect(30, 20, 10, 10)).setTo(20);
+
+    Mat dst;
+    cv::ximgproc::niBlackThreshold(src, dst, 255, THRESH_BINARY_INV, 7, 0.2, BINARIZATION_NIBLACK);
+
+    ASSERT_EQ(CV_8U, dst.type());
+    EXPECT_EQ(255, dst.at<uchar>(0, 0));
+    EXPECT_EQ(255, dst.at<uchar>(63, 79));
+    EXPECT_EQ(255, dst.at<uchar>(25, 35));
+    EXPECT_EQ(0, dst.at<uchar>(19, 30));
+}
+
+// Floating-point computation of the local thresholds, as done for all depths before the 8-bit
+// single-pass implementation. That implementation clamps the variance at zero.
+static void niBlackThresholdReference(const Mat& src, Mat& dst, double maxValue, int type, int blockSize,
+                                      double k, int binarizationMethod, double r)
+{
+    Mat mean, sqmean, variance, stddev, thresh;
+    boxFilter(src, mean, CV_32F, Size(blockSize, blockSize), Point(-1, -1), true, BORDER_REPLICATE);
+    sqrBoxFilter(src, sqmean, CV_32F, Size(blockSize, blockSize), Point(-1, -1), true, BORDER_REPLICATE);
+    variance = sqmean - mean.mul(mean);
+    if (src.depth() == CV_8U)
+        variance = cv::max(variance, 0.0);
+    sqrt(variance, stddev);
+    double srcMin, stddevMax;
+    switch (binarizationMethod)
+    {
+    case BINARIZATION_NIBLACK:
+        thresh = mean + stddev * static_cast<float>(k);
+        break;
+    case BINARIZATION_SAUVOLA:
+        thresh = mean.mul(1. + static_cast<float>(k) * (stddev / r - 1.));
+        break;
+    case BINARIZATION_WOLF:
+        minMaxIdx(src, &srcMin);
+        minMaxIdx(stddev, NULL, &stddevMax);
+        thresh = mean - static_cast<float>(k) * (mean - srcMin - stddev.mul(mean - srcMin) / stddevMax);
+        break;
+    default: // BINARIZATION_NICK
+        sqrt(variance + sqmean, stddev);
+        thresh = mean + static_cast<float>(k) * stddev;
+        break;
+    }
+    thresh.convertTo(thresh, src.depth());
+
+    Mat mask;
+    compare(src, thresh, mask, CMP_GT);
+    dst.create(src.size(), src.type());
+    switch (type)
+    {
+    case THRESH_BINARY:
+        dst.setTo(0);
+        dst.setTo(maxValue, mask);
+        break;
+    case THRESH_BINARY_INV:
+        dst.setTo(maxValue);
+        dst.setTo(0, mask);
+        break;
+    case THRESH_TRUNC:
+        src.copyTo(dst);
+        thresh.copyTo(dst, mask);
+        break;
+    case THRESH_TOZERO:
+        dst.setTo(0);
+        src.copyTo(dst, mask);
+        break;
+    default: // THRESH_TOZERO_INV
+        src.copyTo(dst);
+        dst.setTo(0, mask);
+        break;
+    }
+}
+
+typedef testing::TestWithParam<tuple<MatDepth, int> > ximgproc_niBlackThreshold_parity;
+
+TEST_P(ximgproc_niBlackThreshold_parity, floating_point_reference)
+{
+    const int depth = get<0>(GetParam());
+    const int method = get<1>(GetParam());
+    if (method == BINARIZATION_SAUVOLA && depth != CV_8U)
+        throw SkipTestException("Sauvola is only defined for 8-bit images");
+
+    // odd size for the vector tails, smooth background with text-like strokes
+    RNG& rng = TS::ptr()->get_rng();
+    Mat src8u(97, 131, CV_8UC1);
+    rng.fill(src8u, RNG::UNIFORM, 60, 200);
+    GaussianBlur(src8u, src8u, Size(9, 9), 3);
+    for (int i = 0; i < 20; i++)
+    {
+        Point p1(rng.uniform(0, src8u.cols), rng.uniform(0, src8u.rows));
+        Point p2(rng.uniform(0, src8u.cols), rng.uniform(0, src8u.rows));
+        line(src8u, p1, p2, Scalar::all(rng.uniform(0, 50)), rng.uniform(1, 4));
+    }
+    src8u(Rect(5, 5, 30, 20)).setTo(230); // flat region
+    Mat src;
+    src8u.convertTo(src, depth);
+
+    const int types[] = { THRESH_BINARY, THRESH_BINARY_INV, THRESH_TRUNC, THRESH_TOZERO, THRESH_TOZERO_INV };
+    const int blockSizes[] = { 3, 15, 51 };
+    const double ks[] = { -0.2, 0.5 };
+    for (int type : types)
+    {
+        for (int blockSize : blockSizes)
+        {
+            for (double k : ks)
+            {
+                Mat dst, ref;
+                ximgproc::niBlackThreshold(src, dst, 255, type, blockSize, k, method, 128);
+                niBlackThresholdReference(src, ref, 255, type, blockSize, k, method, 128);
+                ASSERT_EQ(ref.type(), dst.type());
+
+                // the 8-bit path sums in integers, the rounding of thresholds falling on .5 may differ
+                Mat diff;
+                absdiff(dst, ref, diff);
+                EXPECT_LE(countNonZero(diff.reshape(1)), (int)(src.total() / 1000))
+                    << "type=" << type << " blockSize=" << blockSize << " k=" << k;
+            }
+        }
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(/**/, ximgproc_niBlackThreshold_parity, Combine(
+    Values(CV_8U, CV_32F),
+    Values((int)BINARIZATION_NIBLACK, (int)BINARIZATION_SAUVOLA, (int)BINARIZATION_WOLF, (int)BINARIZATION_NICK)));
+
 }} // namespace
@@ -78,4 +78,46 @@ TEST(RadonTransformTest, accuracy_float)
     EXPECT_GT(111, sum(radon.col(0))[0]);
 }
 
+// compare with the projections of the source rotated by warpAffine
+static void checkRotationReference(int type, double maxValue, double eps)
+{
+    Mat src(Size(40, 30), type);
+    randu(src, 0, maxValue);
+    Mat radon;
+    ximgproc::RadonTransform(src, radon, 7, 0, 180, false, false);
+    ASSERT_EQ(src.depth() == CV_32F || src.depth() == CV_64F ? CV_64FC1 : CV_32SC1, radon.type());
+
+    Mat srcT = src.t();
+    int n = cvCeil(sqrt(srcT.rows * srcT.rows + srcT.cols * srcT.cols));
+    Mat padded(Size(n, n), type, Scalar(0));
+    srcT.copyTo(padded(Rect((n - srcT.cols) / 2, (n - srcT.rows) / 2, srcT.cols, srcT.rows)));
+
+    ASSERT_EQ(n, radon.rows);
+    Mat radon64;
+    radon.convertTo(radon64, CV_64F);
+    for (int col = 0; col < radon.cols; col++)
+    {
+        Mat rotated, projection;
+        warpAffine(padded, rotated, getRotationMatrix2D(Point(n / 2, n / 2), col * 7., 1), padded.size());
+        reduce(rotated, projection, 1, REDUCE_SUM, CV_64F);
+        EXPECT_LE(cvtest::norm(projection, radon64.col(col), NORM_INF), eps) << "angle: " << col * 7;
+    }
+}
+
+TEST(RadonTransformTest, accuracy_rotation_reference)
+{
+    checkRotationReference(CV_32FC1, 1, 1e-3);
+}
+
+TEST(RadonTransformTest, accuracy_rotation_reference_64f)
+{
+    checkRotationReference(CV_64FC1, 1, 1e-6);
+}
+
+TEST(RadonTransformTest, accuracy_rotation_reference_8u)
+{
+    // warpAffine interpolates 8-bit images with fixed-point weights, each sample may be off by one
+    checkRotationReference(CV_8UC1, 256, 50);
+}
+
 } }
@@ -53,5 +53,77 @@ TEST(ximgproc_Thinning, simple_GUOHALL)
 #endif
 }
 
+// Straightforward implementation of both techniques, every pixel is tested in every sub-iteration
+static void thinningReference(const Mat1b& src, Mat1b& dst, int thinningType)
+{
+    Mat1b img = src / 255;
+    Mat1b prev;
+    do
+    {
+        img.copyTo(prev);
+        for (int iter = 0; iter < 2; iter++)
+        {
+            Mat1b marker(img.size(), (uchar)1);
+            for (int i = 1; i < img.rows - 1; i++)
+            {
+                for (int j = 1; j < img.cols - 1; j++)
+                {
+                    int p2 = img(i - 1, j), p3 = img(i - 1, j + 1), p4 = img(i, j + 1), p5 = img(i + 1, j + 1);
+                    int p6 = img(i + 1, j), p7 = img(i + 1, j - 1), p8 = img(i, j - 1), p9 = img(i - 1, j - 1);
+                    bool remove;
+                    if (thinningType == THINNING_ZHANGSUEN)
+                    {
+                        int A  = (p2 == 0 && p3 == 1) + (p3 == 0 && p4 == 1) +
+                                 (p4 == 0 && p5 == 1) + (p5 == 0 && p6 == 1) +
+                                 (p6 == 0 && p7 == 1) + (p7 == 0 && p8 == 1) +
+                                 (p8 == 0 && p9 == 1) + (p9 == 0 && p2 == 1);
+                        int B  = p2 + p3 + p4 + p5 + p6 + p7 + p8 + p9;
+                        int m1 = iter == 0 ? (p2 * p4 * p6) : (p2 * p4 * p8);
+                        int m2 = iter == 0 ? (p4 * p6 * p8) : (p2 * p6 * p8);
+                        remove = A == 1 && B >= 2 && B <= 6 && m1 == 0 && m2 == 0;
+                    }
+                    else
+                    {
+                        int C  = ((!p2) & (p3 | p4)) + ((!p4) & (p5 | p6)) +
+                                 ((!p6) & (p7 | p8)) + ((!p8) & (p9 | p2));
+                        int N1 = (p9 | p2) + (p3 | p4) + (p5 | p6) + (p7 | p8);
+                        int N2 = (p2 | p3) + (p4 | p5) + (p6 | p7) + (p8 | p9);
+                        int N  = N1 < N2 ? N1 : N2;
+                        int m  = iter == 0 ? ((p6 | p7 | (!p9)) & p8) : ((p2 | p3 | (!p5)) & p4);
+                        remove = C == 1 && N >= 2 && N <= 3 && m == 0;
+                    }
+                    if (remove)
+                        marker(i, j) = 0;
+                }
+            }
+            img &= marker;
+        }
+    }
+    while (cvtest::norm(img, prev, NORM_INF) > 0);
+    dst = img * 255;
+}
+
+TEST(ximgproc_Thinning, regression_random_blobs)
+{
+    RNG& rng = theRNG();
+    for (int type = THINNING_ZHANGSUEN; type <= THINNING_GUOHALL; type++)
+    {
+        Mat1b src = Mat1b::zeros(Size(197, 131));
+        for (int k = 0; k < 12; k++)
+        {
+            Point center(rng.uniform(0, src.cols), rng.uniform(0, src.rows));
+            cv::circle(src, center, rng.uniform(3, 40), Scalar(255), FILLED);
+        }
+        Mat1b noise(src.size());
+        randu(noise, 0, 256);
+        src.setTo(0, noise > 240);
+
+        Mat1b expected, dst;
+        thinningReference(src, expected, type);
+        thinning(src, dst, type);
+        EXPECT_EQ(0, cvtest::norm(expected, dst, NORM_INF)) << "thinningType=" << type;
+    }
+}
+
 
 }} // namespace